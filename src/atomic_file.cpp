@@ -0,0 +1,32 @@
+#include "atomic_file.h"
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <system_error>
+
+bool writeFileAtomically(const std::string& path, const std::vector<uint8_t>& bytes)
+{
+    std::string tempPath = path + ".tmp";
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        if (!file.is_open())
+            return false;
+        file.write(reinterpret_cast<const char*>(bytes.data()), (std::streamsize)bytes.size());
+        file.close();
+        if (!file)
+        {
+            std::remove(tempPath.c_str());
+            return false;
+        }
+    }
+    
+    // Unlike std::rename, this also replaces an existing target on Windows
+    std::error_code error;
+    std::filesystem::rename(tempPath, path, error);
+    if (error)
+    {
+        std::remove(tempPath.c_str());
+        return false;
+    }
+    return true;
+}
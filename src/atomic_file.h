@@ -0,0 +1,10 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+// Replace path with bytes via a temporary file next to it and a rename.
+// The rename replaces an existing file in one step, so readers and crashes
+// see either the old or the new contents, never a truncated file.
+bool writeFileAtomically(const std::string& path, const std::vector<uint8_t>& bytes);
@@ -0,0 +1,366 @@
+// Silence OpenGL deprecation warnings on macOS
+#define GL_SILENCE_DEPRECATION
+
+#include "block_textures.h"
+#include "gl_state.h"
+#include "gpu_uploader.h"
+#include "render_stats.h"
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+    #define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+
+void getBlockColor(BlockId block, float* color)
+{
+    static const float PALETTE[BLOCK_TYPE_COUNT][3] = {
+        {0.0f, 0.0f, 0.0f},     // air
+        {0.50f, 0.50f, 0.55f},  // stone
+        {0.45f, 0.32f, 0.20f},  // dirt
+        {0.30f, 0.65f, 0.22f},  // grass
+        {0.85f, 0.78f, 0.50f}   // sand
+    };
+    
+    int index = block < BLOCK_TYPE_COUNT ? (int)block : (int)BLOCK_STONE;
+    color[0] = PALETTE[index][0];
+    color[1] = PALETTE[index][1];
+    color[2] = PALETTE[index][2];
+}
+
+int getBlockTextureLayer(BlockId block, int face)
+{
+    switch (block)
+    {
+        case BLOCK_DIRT:
+            return BLOCK_LAYER_DIRT;
+        case BLOCK_GRASS:
+            // Grass on top, dirt below, a grassy edge on the sides
+            if (face == 3)
+                return BLOCK_LAYER_GRASS_TOP;
+            return face == 2 ? BLOCK_LAYER_DIRT : BLOCK_LAYER_GRASS_SIDE;
+        case BLOCK_SAND:
+            return BLOCK_LAYER_SAND;
+        default:
+            return BLOCK_LAYER_STONE;
+    }
+}
+
+namespace
+{
+    const int SIZE = BlockTextures::TEXTURE_SIZE;
+    
+    // Repeatable per-pixel noise in [0, 1)
+    float hashNoise(int x, int y, uint32_t seed)
+    {
+        uint32_t h = (uint32_t)x * 374761393u + (uint32_t)y * 668265263u + seed * 2246822519u;
+        h = (h ^ (h >> 13)) * 1274126177u;
+        h ^= h >> 16;
+        return (h & 0xFFFF) / 65536.0f;
+    }
+    
+    void writeTexel(uint8_t* texel, const float* color, float shade)
+    {
+        for (int c = 0; c < 3; ++c)
+            texel[c] = (uint8_t)std::clamp(color[c] * shade * 255.0f + 0.5f, 0.0f, 255.0f);
+        texel[3] = 255;
+    }
+    
+    // Fill one SIZE x SIZE RGBA layer, row 0 is the bottom (v = 0)
+    void generateLayer(int layer, uint8_t* pixels)
+    {
+        float stone[3], dirt[3], grass[3], sand[3];
+        getBlockColor(BLOCK_STONE, stone);
+        getBlockColor(BLOCK_DIRT, dirt);
+        getBlockColor(BLOCK_GRASS, grass);
+        getBlockColor(BLOCK_SAND, sand);
+        
+        for (int y = 0; y < SIZE; ++y)
+        {
+            for (int x = 0; x < SIZE; ++x)
+            {
+                uint8_t* texel = pixels + (y * SIZE + x) * 4;
+                float fine = hashNoise(x, y, (uint32_t)layer);
+                float coarse = hashNoise(x / 4, y / 4, (uint32_t)layer + 17u);
+                switch (layer)
+                {
+                    case BLOCK_LAYER_STONE:
+                        writeTexel(texel, stone, 0.8f + 0.25f * coarse + 0.15f * fine);
+                        break;
+                    case BLOCK_LAYER_DIRT:
+                        writeTexel(texel, dirt, fine > 0.92f ? 0.65f : 0.85f + 0.3f * fine);
+                        break;
+                    case BLOCK_LAYER_GRASS_TOP:
+                        writeTexel(texel, grass, 0.8f + 0.35f * fine);
+                        break;
+                    case BLOCK_LAYER_GRASS_SIDE:
+                    {
+                        // Ragged grass edge hanging over dirt
+                        int edge = SIZE - 5 - (int)(hashNoise(x, 0, 99u) * 4.0f);
+                        if (y >= edge)
+                            writeTexel(texel, grass, 0.8f + 0.35f * fine);
+                        else
+                            writeTexel(texel, dirt, fine > 0.92f ? 0.65f : 0.85f + 0.3f * fine);
+                        break;
+                    }
+                    default:
+                        writeTexel(texel, sand, 0.92f + 0.12f * fine);
+                        break;
+                }
+            }
+        }
+    }
+    
+    // Half size with a 2x2 box filter
+    void downsample(const uint8_t* source, int sourceSize, uint8_t* target)
+    {
+        int targetSize = std::max(sourceSize / 2, 1);
+        for (int y = 0; y < targetSize; ++y)
+        {
+            for (int x = 0; x < targetSize; ++x)
+            {
+                int x0 = std::min(x * 2, sourceSize - 1), x1 = std::min(x * 2 + 1, sourceSize - 1);
+                int y0 = std::min(y * 2, sourceSize - 1), y1 = std::min(y * 2 + 1, sourceSize - 1);
+                for (int c = 0; c < 4; ++c)
+                {
+                    int sum = source[(y0 * sourceSize + x0) * 4 + c] + source[(y0 * sourceSize + x1) * 4 + c] +
+                              source[(y1 * sourceSize + x0) * 4 + c] + source[(y1 * sourceSize + x1) * 4 + c];
+                    target[(y * targetSize + x) * 4 + c] = (uint8_t)((sum + 2) / 4);
+                }
+            }
+        }
+    }
+    
+    uint16_t packRgb565(const uint8_t* color)
+    {
+        return (uint16_t)(((color[0] >> 3) << 11) | ((color[1] >> 2) << 5) | (color[2] >> 3));
+    }
+    
+    void unpackRgb565(uint16_t packed, int* color)
+    {
+        int r = (packed >> 11) & 31, g = (packed >> 5) & 63, b = packed & 31;
+        color[0] = (r << 3) | (r >> 2);
+        color[1] = (g << 2) | (g >> 4);
+        color[2] = (b << 3) | (b >> 2);
+    }
+    
+    // One DXT1 block: endpoints are the darkest and brightest texels, which
+    // suits the low-contrast noise of block textures
+    void encodeBlock(const uint8_t (*texels)[4], uint8_t* output)
+    {
+        int darkest = 0, brightest = 0;
+        int minLuma = 1 << 30, maxLuma = -1;
+        for (int i = 0; i < 16; ++i)
+        {
+            int luma = texels[i][0] * 2 + texels[i][1] * 5 + texels[i][2];
+            if (luma < minLuma)
+            {
+                minLuma = luma;
+                darkest = i;
+            }
+            if (luma > maxLuma)
+            {
+                maxLuma = luma;
+                brightest = i;
+            }
+        }
+        
+        // color0 > color1 selects the four color mode (no transparent black)
+        uint16_t color0 = packRgb565(texels[brightest]);
+        uint16_t color1 = packRgb565(texels[darkest]);
+        if (color0 < color1)
+            std::swap(color0, color1);
+        
+        uint32_t indices = 0;
+        if (color0 != color1)
+        {
+            int palette[4][3];
+            unpackRgb565(color0, palette[0]);
+            unpackRgb565(color1, palette[1]);
+            for (int c = 0; c < 3; ++c)
+            {
+                palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+                palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+            }
+            
+            for (int i = 0; i < 16; ++i)
+            {
+                int best = 0, bestDistance = 1 << 30;
+                for (int p = 0; p < 4; ++p)
+                {
+                    int dr = texels[i][0] - palette[p][0];
+                    int dg = texels[i][1] - palette[p][1];
+                    int db = texels[i][2] - palette[p][2];
+                    int distance = dr * dr + dg * dg + db * db;
+                    if (distance < bestDistance)
+                    {
+                        bestDistance = distance;
+                        best = p;
+                    }
+                }
+                indices |= (uint32_t)best << (i * 2);
+            }
+        }
+        
+        output[0] = (uint8_t)(color0 & 0xFF);
+        output[1] = (uint8_t)(color0 >> 8);
+        output[2] = (uint8_t)(color1 & 0xFF);
+        output[3] = (uint8_t)(color1 >> 8);
+        std::memcpy(output + 4, &indices, 4);
+    }
+    
+    // DXT1 blocks of an RGBA image, edges of images under 4x4 are repeated
+    void compressImage(const uint8_t* pixels, int size, std::vector<uint8_t>& output)
+    {
+        int blocks = (size + 3) / 4;
+        for (int by = 0; by < blocks; ++by)
+        {
+            for (int bx = 0; bx < blocks; ++bx)
+            {
+                uint8_t texels[16][4];
+                for (int i = 0; i < 16; ++i)
+                {
+                    int x = std::min(bx * 4 + i % 4, size - 1);
+                    int y = std::min(by * 4 + i / 4, size - 1);
+                    std::memcpy(texels[i], pixels + (y * size + x) * 4, 4);
+                }
+                uint8_t block[8];
+                encodeBlock(texels, block);
+                output.insert(output.end(), block, block + 8);
+            }
+        }
+    }
+    
+    bool hasS3tc()
+    {
+        GLint count = 0;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+        for (GLint i = 0; i < count; ++i)
+        {
+            const char* name = (const char*)glGetStringi(GL_EXTENSIONS, (GLuint)i);
+            if (name && std::strcmp(name, "GL_EXT_texture_compression_s3tc") == 0)
+                return true;
+        }
+        return false;
+    }
+}
+
+BlockTextures& BlockTextures::getInstance()
+{
+    static BlockTextures instance;
+    return instance;
+}
+
+BlockTextures::BlockTextures()
+    : m_texture(0)
+    , m_requested(false)
+    , m_compressed(false)
+    , m_memoryBytes(0)
+{
+}
+
+void BlockTextures::initialize()
+{
+    if (m_requested)
+        return;
+    m_requested = true;
+    
+    // Extensions are queried here, the loader context may not report the same list
+    bool compressed = hasS3tc();
+    
+    // Filled on the loader, handed over on the GL thread after the fence
+    struct Result
+    {
+        GLuint texture = 0;
+        size_t bytes = 0;
+    };
+    std::shared_ptr<Result> result = std::make_shared<Result>();
+    
+    GpuUploader::getInstance().submit([result, compressed]()
+    {
+        // Mip chains of every layer, level 0 first
+        std::vector<std::vector<uint8_t>> levels(MIP_LEVELS);
+        std::vector<uint8_t> pixels((size_t)SIZE * SIZE * 4);
+        std::vector<uint8_t> smaller;
+        for (int layer = 0; layer < BLOCK_LAYER_COUNT; ++layer)
+        {
+            generateLayer(layer, pixels.data());
+            std::vector<uint8_t> level = pixels;
+            int size = SIZE;
+            for (int mip = 0; mip < MIP_LEVELS; ++mip)
+            {
+                if (compressed)
+                    compressImage(level.data(), size, levels[mip]);
+                else
+                    levels[mip].insert(levels[mip].end(), level.begin(), level.end());
+                
+                if (mip + 1 < MIP_LEVELS)
+                {
+                    smaller.resize((size_t)std::max(size / 2, 1) * std::max(size / 2, 1) * 4);
+                    downsample(level.data(), size, smaller.data());
+                    level.swap(smaller);
+                    size = std::max(size / 2, 1);
+                }
+            }
+        }
+        
+        GLState& state = GLState::getInstance();
+        glGenTextures(1, &result->texture);
+        state.bindTexture(0, GL_TEXTURE_2D_ARRAY, result->texture);
+        for (int mip = 0; mip < MIP_LEVELS; ++mip)
+        {
+            int size = std::max(SIZE >> mip, 1);
+            if (compressed)
+            {
+                glCompressedTexImage3D(GL_TEXTURE_2D_ARRAY, mip, GL_COMPRESSED_RGB_S3TC_DXT1_EXT,
+                                       size, size, BLOCK_LAYER_COUNT, 0, (GLsizei)levels[mip].size(), levels[mip].data());
+            }
+            else
+            {
+                glTexImage3D(GL_TEXTURE_2D_ARRAY, mip, GL_RGBA8, size, size, BLOCK_LAYER_COUNT, 0,
+                             GL_RGBA, GL_UNSIGNED_BYTE, levels[mip].data());
+            }
+            result->bytes += levels[mip].size();
+        }
+        
+        // Crisp up close, smooth in the distance; repeat tiles merged faces
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BASE_LEVEL, 0);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, MIP_LEVELS - 1);
+        state.bindTexture(0, GL_TEXTURE_2D_ARRAY, 0);
+    }, [this, result, compressed]()
+    {
+        m_texture = result->texture;
+        m_memoryBytes = result->bytes;
+        m_compressed = compressed;
+        SDL_Log("Block textures: %d layers, %s, %.1f KB", (int)BLOCK_LAYER_COUNT,
+                compressed ? "DXT1" : "RGBA8", m_memoryBytes / 1024.0f);
+    });
+}
+
+void BlockTextures::bind(GLuint program) const
+{
+    GLState& state = GLState::getInstance();
+    if (m_texture == 0 || program == 0)
+        return;
+    
+    state.bindTexture(TEXTURE_UNIT, GL_TEXTURE_2D_ARRAY, m_texture);
+    state.activeTexture(0);
+    glUniform1i(glGetUniformLocation(program, "blockTextures"), TEXTURE_UNIT);
+    RenderStats::getInstance().countUniforms(1);
+}
+
+void BlockTextures::cleanup()
+{
+    GLState& state = GLState::getInstance();
+    state.deleteTextures(1, &m_texture);
+    m_texture = 0;
+    m_memoryBytes = 0;
+    m_requested = false;
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+// Silence OpenGL deprecation warnings on macOS
+#define GL_SILENCE_DEPRECATION
+
+#include <cstddef>
+#include <cstdint>
+
+#include "voxel_octree.h"
+
+#if defined(__APPLE__)
+    #include <OpenGL/gl3.h>
+#else
+    #include <SDL3/SDL_opengl.h>
+#endif
+
+// Layers of the block texture array
+enum BlockTextureLayer : int
+{
+    BLOCK_LAYER_STONE = 0,
+    BLOCK_LAYER_DIRT,
+    BLOCK_LAYER_GRASS_TOP,
+    BLOCK_LAYER_GRASS_SIDE,
+    BLOCK_LAYER_SAND,
+    BLOCK_LAYER_COUNT
+};
+
+// Base color of a block type (rgb), the average of its textures
+void getBlockColor(BlockId block, float* color);
+
+// Texture array layer of one face of a block, faces ordered -X, +X, -Y, +Y,
+// -Z, +Z. Thread safe, no GL calls.
+int getBlockTextureLayer(BlockId block, int face);
+
+// Every block texture in one GL_TEXTURE_2D_ARRAY, a layer per texture, so
+// the whole block world draws with a single texture bound and mipmapping
+// can't bleed between neighbors the way it does in an atlas. Textures are
+// generated procedurally with a full mip chain and stored as DXT1 when the
+// driver has S3TC (RGBA8 otherwise); generation and upload run through
+// GpuUploader, off the main thread when it has a loader.
+class BlockTextures
+{
+public:
+    static constexpr int TEXTURE_SIZE = 32;     // pixels per side of a layer
+    static constexpr int MIP_LEVELS = 6;        // 32x32 down to 1x1
+    static constexpr int TEXTURE_UNIT = 5;
+    
+    // Get singleton instance
+    static BlockTextures& getInstance();
+    
+    // Delete copy constructor and assignment operator
+    BlockTextures(const BlockTextures&) = delete;
+    BlockTextures& operator=(const BlockTextures&) = delete;
+    
+    // Queue generation and upload (GL thread, after GpuUploader::start)
+    void initialize();
+    
+    // Bind the array and point the program's blockTextures sampler at it
+    void bind(GLuint program) const;
+    
+    // Statistics
+    bool isReady() const { return m_texture != 0; }
+    bool isCompressed() const { return m_compressed; }
+    size_t getMemoryBytes() const { return m_memoryBytes; }
+    
+    // Delete the texture (call before the GL context goes away)
+    void cleanup();
+    
+private:
+    BlockTextures();
+    ~BlockTextures() = default;
+    
+    GLuint m_texture;           // 0 until the upload has completed
+    bool m_requested;
+    bool m_compressed;
+    size_t m_memoryBytes;
+};
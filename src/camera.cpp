@@ -0,0 +1,321 @@
+#include "camera.h"
+#include "libs/maths/matrix.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+    constexpr float DEGREES_TO_RADIANS = 3.14159265359f / 180.0f;
+}
+
+Camera::Camera()
+    : m_mode(CameraMode::Orbit)
+    , m_yaw(45.0f), m_pitch(30.0f)
+    , m_distance(5.0f)
+    , m_minDistance(2.0f), m_maxDistance(10.0f)
+    , m_fov(45.0f), m_nearPlane(0.1f), m_farPlane(100.0f), m_aspect(16.0f / 9.0f)
+    , m_viewDirty(true), m_projectionDirty(true), m_combinedDirty(true)
+{
+    m_target[0] = m_target[1] = m_target[2] = 0.0f;
+    m_flyPosition[0] = m_flyPosition[1] = m_flyPosition[2] = 0.0f;
+}
+
+void Camera::setMode(CameraMode mode)
+{
+    if (mode == m_mode)
+        return;
+    
+    // Keep the eye where it is: fly from the orbit position, or put the
+    // target in front of the flying eye
+    const float* eye = getPosition();
+    const float* back = getBack();
+    if (mode == CameraMode::FreeFly)
+    {
+        std::memcpy(m_flyPosition, eye, sizeof(m_flyPosition));
+    }
+    else if (m_mode == CameraMode::FreeFly)
+    {
+        for (int i = 0; i < 3; i++)
+        {
+            m_target[i] = eye[i] - back[i] * m_distance;
+        }
+    }
+    
+    m_mode = mode;
+    markViewDirty();
+    markProjectionDirty();
+}
+
+void Camera::setYaw(float yaw)
+{
+    yaw = std::fmod(yaw, 360.0f);
+    if (yaw < 0.0f) yaw += 360.0f;
+    if (yaw == m_yaw)
+        return;
+    m_yaw = yaw;
+    markViewDirty();
+}
+
+void Camera::setPitch(float pitch)
+{
+    // Clamp pitch to prevent gimbal lock
+    pitch = std::clamp(pitch, -89.0f, 89.0f);
+    if (pitch == m_pitch)
+        return;
+    m_pitch = pitch;
+    markViewDirty();
+}
+
+void Camera::setTarget(float x, float y, float z)
+{
+    if (x == m_target[0] && y == m_target[1] && z == m_target[2])
+        return;
+    m_target[0] = x;
+    m_target[1] = y;
+    m_target[2] = z;
+    markViewDirty();
+}
+
+void Camera::setDistance(float distance)
+{
+    distance = std::clamp(distance, m_minDistance, m_maxDistance);
+    if (distance == m_distance)
+        return;
+    m_distance = distance;
+    markViewDirty();
+    
+    // The ortho extent follows the distance
+    if (m_mode == CameraMode::Ortho)
+        markProjectionDirty();
+}
+
+void Camera::setDistanceLimits(float minDistance, float maxDistance)
+{
+    m_minDistance = minDistance;
+    m_maxDistance = maxDistance;
+    setDistance(m_distance);
+}
+
+void Camera::zoom(float amount)
+{
+    if (m_mode == CameraMode::FreeFly)
+        move(0.0f, 0.0f, amount);
+    else
+        setDistance(m_distance - amount);
+}
+
+void Camera::move(float right, float up, float forward)
+{
+    if (right == 0.0f && up == 0.0f && forward == 0.0f)
+        return;
+    
+    const float* r = getRight();
+    const float* u = getUp();
+    const float* b = getBack();
+    float* position = (m_mode == CameraMode::FreeFly) ? m_flyPosition : m_target;
+    for (int i = 0; i < 3; i++)
+    {
+        position[i] += r[i] * right + u[i] * up - b[i] * forward;
+    }
+    markViewDirty();
+}
+
+void Camera::setPerspective(float fovDegrees, float nearPlane, float farPlane)
+{
+    if (fovDegrees == m_fov && nearPlane == m_nearPlane && farPlane == m_farPlane)
+        return;
+    m_fov = fovDegrees;
+    m_nearPlane = nearPlane;
+    m_farPlane = farPlane;
+    markProjectionDirty();
+}
+
+void Camera::setAspect(float aspect)
+{
+    if (aspect == m_aspect || !(aspect > 0.0f))
+        return;
+    m_aspect = aspect;
+    markProjectionDirty();
+}
+
+const float* Camera::getPosition() const
+{
+    updateView();
+    return m_position;
+}
+
+const float* Camera::getRight() const
+{
+    updateView();
+    return m_right;
+}
+
+const float* Camera::getUp() const
+{
+    updateView();
+    return m_up;
+}
+
+const float* Camera::getBack() const
+{
+    updateView();
+    return m_back;
+}
+
+const float* Camera::getViewMatrix() const
+{
+    updateView();
+    return m_view;
+}
+
+const float* Camera::getProjectionMatrix() const
+{
+    updateProjection();
+    return m_projection;
+}
+
+const float* Camera::getViewProjectionMatrix() const
+{
+    updateCombined();
+    return m_viewProjection;
+}
+
+const float* Camera::getInverseViewProjectionMatrix() const
+{
+    updateCombined();
+    return m_inverseViewProjection;
+}
+
+void Camera::unproject(float ndcX, float ndcY, float ndcZ, float* world) const
+{
+    const float* m = getInverseViewProjectionMatrix();
+    float x = m[0] * ndcX + m[4] * ndcY + m[8] * ndcZ + m[12];
+    float y = m[1] * ndcX + m[5] * ndcY + m[9] * ndcZ + m[13];
+    float z = m[2] * ndcX + m[6] * ndcY + m[10] * ndcZ + m[14];
+    float w = m[3] * ndcX + m[7] * ndcY + m[11] * ndcZ + m[15];
+    float invW = (w != 0.0f) ? 1.0f / w : 0.0f;
+    world[0] = x * invW;
+    world[1] = y * invW;
+    world[2] = z * invW;
+}
+
+void Camera::getPickRay(float pixelX, float pixelY, int width, int height, float* origin, float* direction) const
+{
+    // Convert mouse position to normalized device coordinates
+    float ndcX = (2.0f * pixelX) / width - 1.0f;
+    float ndcY = 1.0f - (2.0f * pixelY) / height;
+    
+    float nearPoint[3], farPoint[3];
+    unproject(ndcX, ndcY, -1.0f, nearPoint);
+    unproject(ndcX, ndcY, 1.0f, farPoint);
+    
+    // Perspective rays start at the eye, ortho rays are parallel from the near plane
+    const float* start = (m_mode == CameraMode::Ortho) ? nearPoint : getPosition();
+    float dx = farPoint[0] - nearPoint[0];
+    float dy = farPoint[1] - nearPoint[1];
+    float dz = farPoint[2] - nearPoint[2];
+    float invLength = 1.0f / std::sqrt(dx * dx + dy * dy + dz * dz);
+    
+    origin[0] = start[0];
+    origin[1] = start[1];
+    origin[2] = start[2];
+    direction[0] = dx * invLength;
+    direction[1] = dy * invLength;
+    direction[2] = dz * invLength;
+}
+
+void Camera::updateView() const
+{
+    if (!m_viewDirty)
+        return;
+    m_viewDirty = false;
+    
+    // Unit vector from the target toward the eye
+    float yawRad = m_yaw * DEGREES_TO_RADIANS;
+    float pitchRad = m_pitch * DEGREES_TO_RADIANS;
+    m_back[0] = std::cos(pitchRad) * std::cos(yawRad);
+    m_back[1] = std::sin(pitchRad);
+    m_back[2] = std::cos(pitchRad) * std::sin(yawRad);
+    
+    if (m_mode == CameraMode::FreeFly)
+    {
+        std::memcpy(m_position, m_flyPosition, sizeof(m_position));
+    }
+    else
+    {
+        for (int i = 0; i < 3; i++)
+        {
+            m_position[i] = m_target[i] + m_back[i] * m_distance;
+        }
+    }
+    
+    // right = normalize(worldUp x back), up = back x right (pitch stays below 90)
+    float rightLength = std::sqrt(m_back[2] * m_back[2] + m_back[0] * m_back[0]);
+    m_right[0] = m_back[2] / rightLength;
+    m_right[1] = 0.0f;
+    m_right[2] = -m_back[0] / rightLength;
+    
+    m_up[0] = m_back[1] * m_right[2] - m_back[2] * m_right[1];
+    m_up[1] = m_back[2] * m_right[0] - m_back[0] * m_right[2];
+    m_up[2] = m_back[0] * m_right[1] - m_back[1] * m_right[0];
+    
+    // lookAt
+    const float* eye = m_position;
+    float view[16] = {
+        m_right[0], m_up[0], m_back[0], 0.0f,
+        m_right[1], m_up[1], m_back[1], 0.0f,
+        m_right[2], m_up[2], m_back[2], 0.0f,
+        -(m_right[0] * eye[0] + m_right[1] * eye[1] + m_right[2] * eye[2]),
+        -(m_up[0] * eye[0] + m_up[1] * eye[1] + m_up[2] * eye[2]),
+        -(m_back[0] * eye[0] + m_back[1] * eye[1] + m_back[2] * eye[2]),
+        1.0f
+    };
+    std::memcpy(m_view, view, sizeof(m_view));
+}
+
+void Camera::updateProjection() const
+{
+    if (!m_projectionDirty)
+        return;
+    m_projectionDirty = false;
+    
+    float n = m_nearPlane;
+    float f = m_farPlane;
+    float tanHalfFov = std::tan(m_fov * DEGREES_TO_RADIANS * 0.5f);
+    std::memset(m_projection, 0, sizeof(m_projection));
+    
+    if (m_mode == CameraMode::Ortho)
+    {
+        // Same extent as the perspective view has at the target
+        float halfHeight = m_distance * tanHalfFov;
+        float halfWidth = halfHeight * m_aspect;
+        m_projection[0] = 1.0f / halfWidth;
+        m_projection[5] = 1.0f / halfHeight;
+        m_projection[10] = -2.0f / (f - n);
+        m_projection[14] = -(f + n) / (f - n);
+        m_projection[15] = 1.0f;
+    }
+    else
+    {
+        float focal = 1.0f / tanHalfFov;
+        m_projection[0] = focal / m_aspect;
+        m_projection[5] = focal;
+        m_projection[10] = (f + n) / (n - f);
+        m_projection[11] = -1.0f;
+        m_projection[14] = (2.0f * f * n) / (n - f);
+    }
+}
+
+void Camera::updateCombined() const
+{
+    if (!m_combinedDirty)
+        return;
+    
+    updateView();
+    updateProjection();
+    m_combinedDirty = false;
+    
+    multiplyMatrix(m_viewProjection, m_projection, m_view);
+    invertMatrix(m_inverseViewProjection, m_viewProjection);
+}
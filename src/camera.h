@@ -0,0 +1,96 @@
+#pragma once
+
+// How a Camera is placed and projected. Code consuming the projection must
+// handle both kinds; orthographic matrices have projection[11] == 0 instead
+// of -1, which is how clustered light binning tells them apart.
+enum class CameraMode
+{
+    Orbit,      // circles the target at a distance, perspective
+    FreeFly,    // flies on its own, looks along yaw/pitch, perspective
+    Ortho       // placed like Orbit, orthographic projection
+};
+
+// View and projection with cached derived matrices. Setters only mark the
+// cache stale; the basis, matrices and inverse are rebuilt on the next read,
+// so a still camera costs nothing per frame. Angles are in degrees and the
+// view direction for a yaw/pitch points from the eye back toward the target.
+class Camera
+{
+public:
+    Camera();
+    
+    // Switching keeps the current eye and view direction
+    void setMode(CameraMode mode);
+    CameraMode getMode() const { return m_mode; }
+    
+    // Yaw wraps to [0, 360), pitch is clamped to +-89 degrees
+    void setYaw(float yaw);
+    void setPitch(float pitch);
+    void rotate(float deltaYaw, float deltaPitch) { setYaw(m_yaw + deltaYaw); setPitch(m_pitch + deltaPitch); }
+    float getYaw() const { return m_yaw; }
+    float getPitch() const { return m_pitch; }
+    
+    // Orbit and ortho placement, the distance also sets the ortho extent
+    void setTarget(float x, float y, float z);
+    const float* getTarget() const { return m_target; }
+    void setDistance(float distance);
+    float getDistance() const { return m_distance; }
+    void setDistanceLimits(float minDistance, float maxDistance);
+    float getMinDistance() const { return m_minDistance; }
+    float getMaxDistance() const { return m_maxDistance; }
+    
+    // Wheel zoom: closer to the target, or forward when flying
+    void zoom(float amount);
+    
+    // Move along the camera's own axes (the target follows in orbit modes)
+    void move(float right, float up, float forward);
+    
+    // Projection parameters
+    void setPerspective(float fovDegrees, float nearPlane, float farPlane);
+    void setAspect(float aspect);
+    float getFov() const { return m_fov; }
+    float getNearPlane() const { return m_nearPlane; }
+    float getFarPlane() const { return m_farPlane; }
+    float getAspect() const { return m_aspect; }
+    
+    // Eye position and world-space basis (back points away from the view direction)
+    const float* getPosition() const;
+    const float* getRight() const;
+    const float* getUp() const;
+    const float* getBack() const;
+    
+    // Column-major matrices
+    const float* getViewMatrix() const;
+    const float* getProjectionMatrix() const;
+    const float* getViewProjectionMatrix() const;
+    const float* getInverseViewProjectionMatrix() const;
+    
+    // World position of a point in normalized device coordinates
+    void unproject(float ndcX, float ndcY, float ndcZ, float* world) const;
+    
+    // Picking ray through a pixel of a width x height viewport, direction normalized
+    void getPickRay(float pixelX, float pixelY, int width, int height, float* origin, float* direction) const;
+    
+private:
+    void markViewDirty() { m_viewDirty = true; m_combinedDirty = true; }
+    void markProjectionDirty() { m_projectionDirty = true; m_combinedDirty = true; }
+    void updateView() const;
+    void updateProjection() const;
+    void updateCombined() const;
+    
+    CameraMode m_mode;
+    float m_yaw, m_pitch;
+    float m_target[3];
+    float m_distance;
+    float m_minDistance, m_maxDistance;
+    float m_flyPosition[3];     // eye in free-fly mode
+    float m_fov, m_nearPlane, m_farPlane, m_aspect;
+    
+    // Cache, rebuilt on read after a change
+    mutable bool m_viewDirty, m_projectionDirty, m_combinedDirty;
+    mutable float m_position[3], m_right[3], m_up[3], m_back[3];
+    mutable float m_view[16];
+    mutable float m_projection[16];
+    mutable float m_viewProjection[16];
+    mutable float m_inverseViewProjection[16];
+};
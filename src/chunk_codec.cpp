@@ -0,0 +1,205 @@
+#include "chunk_codec.h"
+#include "palette_chunk.h"
+#include <cstring>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define CHUNK_CODEC_USE_SSE2 1
+    #include <emmintrin.h>
+#endif
+
+// CHUNK_FORMAT_PALETTE_RLE layout (little-endian):
+//   uint8  format
+//   uint8  bits per block (0, 1, 2, 4, 8 or 16)
+//   uint16 palette size, then that many BlockIds
+//   run-length coded bytes of the packed indices (CHUNK_CELLS * bits / 8)
+// Runs use one control byte: 0..127 is followed by control + 1 literal bytes,
+// 128..255 repeats the next byte control - 125 times (3 to 130).
+// Packed words are written as bytes, which assumes a little-endian host.
+
+namespace
+{
+    const int MIN_REPEAT = 3;
+    const int MAX_REPEAT = 130;
+    const int MAX_LITERAL = 128;
+    
+    // Length of the run of equal bytes starting at data[0], capped at MAX_REPEAT
+    size_t repeatLength(const uint8_t* data, size_t available)
+    {
+        size_t limit = available < (size_t)MAX_REPEAT ? available : (size_t)MAX_REPEAT;
+        size_t length = 1;
+        while (length < limit && data[length] == data[0])
+        {
+            ++length;
+        }
+        return length;
+    }
+    
+    void encodeRuns(const uint8_t* data, size_t size, std::vector<uint8_t>& output)
+    {
+        size_t i = 0;
+        while (i < size)
+        {
+            size_t repeat = repeatLength(data + i, size - i);
+            if (repeat >= (size_t)MIN_REPEAT)
+            {
+                output.push_back((uint8_t)(0x80 | (repeat - MIN_REPEAT)));
+                output.push_back(data[i]);
+                i += repeat;
+                continue;
+            }
+            
+            // Literals up to the next repeat worth coding
+            size_t start = i;
+            while (i < size && i - start < (size_t)MAX_LITERAL &&
+                   repeatLength(data + i, size - i) < (size_t)MIN_REPEAT)
+            {
+                ++i;
+            }
+            output.push_back((uint8_t)(i - start - 1));
+            output.insert(output.end(), data + start, data + i);
+        }
+    }
+    
+    // Fill count bytes with value, 16 at a time
+    inline void fillBytes(uint8_t* dst, uint8_t value, size_t count)
+    {
+#if CHUNK_CODEC_USE_SSE2
+        __m128i v = _mm_set1_epi8((char)value);
+        while (count >= 16)
+        {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), v);
+            dst += 16;
+            count -= 16;
+        }
+#endif
+        while (count > 0)
+        {
+            *dst++ = value;
+            --count;
+        }
+    }
+    
+    // Copy count bytes, 16 at a time
+    inline void copyBytes(uint8_t* dst, const uint8_t* src, size_t count)
+    {
+#if CHUNK_CODEC_USE_SSE2
+        while (count >= 16)
+        {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst),
+                             _mm_loadu_si128(reinterpret_cast<const __m128i*>(src)));
+            dst += 16;
+            src += 16;
+            count -= 16;
+        }
+#endif
+        std::memcpy(dst, src, count);
+    }
+    
+    // Expand runs into exactly size bytes, false if the input doesn't match
+    bool decodeRuns(const uint8_t* data, size_t dataSize, uint8_t* output, size_t size)
+    {
+        const uint8_t* end = data + dataSize;
+        size_t written = 0;
+        while (data < end)
+        {
+            uint8_t control = *data++;
+            if (control & 0x80)
+            {
+                size_t count = (size_t)(control & 0x7F) + MIN_REPEAT;
+                if (data >= end || written + count > size)
+                    return false;
+                fillBytes(output + written, *data++, count);
+                written += count;
+            }
+            else
+            {
+                size_t count = (size_t)control + 1;
+                if ((size_t)(end - data) < count || written + count > size)
+                    return false;
+                copyBytes(output + written, data, count);
+                data += count;
+                written += count;
+            }
+        }
+        return written == size;
+    }
+}
+
+void encodeChunk(const PaletteChunk& chunk, std::vector<uint8_t>& output)
+{
+    const std::vector<BlockId>& palette = chunk.getPalette();
+    uint16_t paletteSize = (uint16_t)palette.size();
+    
+    output.clear();
+    output.push_back(CHUNK_FORMAT_PALETTE_RLE);
+    output.push_back((uint8_t)chunk.getBitsPerBlock());
+    output.push_back((uint8_t)(paletteSize & 0xFF));
+    output.push_back((uint8_t)(paletteSize >> 8));
+    for (BlockId block : palette)
+    {
+        output.push_back((uint8_t)(block & 0xFF));
+        output.push_back((uint8_t)(block >> 8));
+    }
+    encodeRuns(chunk.getPackedData(), chunk.getPackedSize(), output);
+}
+
+void encodeChunk(const VoxelOctree& octree, std::vector<uint8_t>& output)
+{
+    PaletteChunk chunk;
+    chunk.fromOctree(octree);
+    encodeChunk(chunk, output);
+}
+
+bool decodeChunk(const uint8_t* data, size_t size, PaletteChunk& chunk)
+{
+    if (size < 1)
+        return false;
+    
+    if (data[0] == CHUNK_FORMAT_RAW)
+    {
+        if (size != 1 + CHUNK_CELLS * sizeof(BlockId))
+            return false;
+        
+        std::vector<BlockId> blocks(CHUNK_CELLS);
+        std::memcpy(blocks.data(), data + 1, CHUNK_CELLS * sizeof(BlockId));
+        chunk.fromDense(blocks.data());
+        return true;
+    }
+    
+    if (data[0] == CHUNK_FORMAT_PALETTE_RLE)
+    {
+        if (size < 4)
+            return false;
+        
+        int bits = data[1];
+        size_t paletteSize = (size_t)data[2] | ((size_t)data[3] << 8);
+        size_t headerSize = 4 + paletteSize * sizeof(BlockId);
+        if (paletteSize == 0 || size < headerSize)
+            return false;
+        
+        std::vector<BlockId> palette(paletteSize);
+        for (size_t i = 0; i < paletteSize; ++i)
+        {
+            palette[i] = (BlockId)(data[4 + i * 2] | (data[5 + i * 2] << 8));
+        }
+        if (!chunk.reset(palette.data(), (int)paletteSize, bits))
+            return false;
+        
+        return decodeRuns(data + headerSize, size - headerSize, chunk.getPackedDataForWrite(), chunk.getPackedSize()) &&
+               chunk.validate();
+    }
+    return false;
+}
+
+bool decodeChunk(const uint8_t* data, size_t size, VoxelOctree& octree)
+{
+    if (octree.getDepth() != CHUNK_DEPTH)
+        return false;
+    
+    PaletteChunk chunk;
+    if (!decodeChunk(data, size, chunk))
+        return false;
+    chunk.toOctree(octree);
+    return true;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+#include "voxel_octree.h"
+
+class PaletteChunk;
+
+// Chunks are CHUNK_SIZE cells per side, stored in an octree of CHUNK_DEPTH
+constexpr int CHUNK_DEPTH = 5;
+constexpr int CHUNK_SIZE = 1 << CHUNK_DEPTH;
+constexpr int CHUNK_CELLS = CHUNK_SIZE * CHUNK_SIZE * CHUNK_SIZE;
+
+// Serialized chunk layout, first byte of every encoded chunk
+enum ChunkFormat : uint8_t
+{
+    CHUNK_FORMAT_RAW = 0,           // CHUNK_CELLS BlockIds, x fastest, then z, then y
+    CHUNK_FORMAT_PALETTE_RLE = 1    // bits per block, palette, run-length coded packed indices
+};
+
+// Dense cell index in serialized order (horizontal layers bottom to top)
+inline int chunkCellIndex(int x, int y, int z)
+{
+    return (y * CHUNK_SIZE + z) * CHUNK_SIZE + x;
+}
+
+// Serialize the blocks of a chunk (CHUNK_FORMAT_PALETTE_RLE)
+void encodeChunk(const PaletteChunk& chunk, std::vector<uint8_t>& output);
+void encodeChunk(const VoxelOctree& octree, std::vector<uint8_t>& output);
+
+// Rebuild a chunk from encoded bytes of any format, false on malformed input.
+// Palette chunks decode straight into the packed form without expanding.
+bool decodeChunk(const uint8_t* data, size_t size, PaletteChunk& chunk);
+bool decodeChunk(const uint8_t* data, size_t size, VoxelOctree& octree);
@@ -0,0 +1,259 @@
+// Silence OpenGL deprecation warnings on macOS
+#define GL_SILENCE_DEPRECATION
+
+#include "chunk_streamer.h"
+#include "region_file.h"
+#include "job_system.h"
+#include "frame_arena.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace
+{
+    // Loads queued on the job system at once, nearest chunks go first
+    const int MAX_LOADS_IN_FLIGHT = 8;
+}
+
+ChunkStreamer::ChunkStreamer()
+    : m_shared(std::make_shared<SharedState>())
+    , m_nextTicket(0)
+    , m_originX(0.0f), m_originY(0.0f), m_originZ(0.0f)
+    , m_cellSize(1.0f)
+    , m_loadRadius(4)
+    , m_uploadBudget(1024 * 1024)
+    , m_residentCount(0)
+    , m_loadingCount(0)
+    , m_lastUploadBytes(0)
+{
+}
+
+ChunkStreamer::~ChunkStreamer()
+{
+    clear();
+}
+
+void ChunkStreamer::setWorldDirectory(const std::string& directory)
+{
+    clear();
+    std::lock_guard<std::mutex> lock(m_shared->mutex);
+    m_shared->directory = directory;
+}
+
+void ChunkStreamer::setShaderPaths(const std::string& vertexShaderPath, const std::string& fragmentShaderPath)
+{
+    m_vertexShaderPath = vertexShaderPath;
+    m_fragmentShaderPath = fragmentShaderPath;
+}
+
+void ChunkStreamer::setPlacement(float originX, float originY, float originZ, float cellSize)
+{
+    clear();
+    m_originX = originX;
+    m_originY = originY;
+    m_originZ = originZ;
+    m_cellSize = cellSize;
+}
+
+void ChunkStreamer::clear()
+{
+    // Results of loads still running are dropped when they arrive (no slot)
+    m_chunks.clear();
+    m_residentCount = 0;
+    m_loadingCount = 0;
+    m_shared->completed.clear();
+    for (UploadedChunk& chunk : m_shared->uploaded)
+        chunk.mesh.release();
+    m_shared->uploaded.clear();
+    
+    std::lock_guard<std::mutex> lock(m_shared->mutex);
+    m_shared->regions.clear();
+}
+
+void ChunkStreamer::update(float x, float z)
+{
+    float chunkWorldSize = m_cellSize * CHUNK_SIZE;
+    int centerX = (int)std::floor((x - m_originX) / chunkWorldSize);
+    int centerZ = (int)std::floor((z - m_originZ) / chunkWorldSize);
+    
+    // Evict chunks past the radius, with one chunk of hysteresis
+    int evictRadius = m_loadRadius + 1;
+    for (auto it = m_chunks.begin(); it != m_chunks.end();)
+    {
+        int chunkX = (int)(it->first >> 32);
+        int chunkZ = (int)(int32_t)(it->first & 0xFFFFFFFF);
+        int dx = chunkX - centerX, dz = chunkZ - centerZ;
+        if (dx * dx + dz * dz > evictRadius * evictRadius)
+            it = m_chunks.erase(it);
+        else
+            ++it;
+    }
+    
+    // Missing chunks in the radius, nearest first
+    struct Request
+    {
+        int chunkX, chunkZ, distance;
+    };
+    FrameVector<Request> requests;
+    for (int dz = -m_loadRadius; dz <= m_loadRadius; ++dz)
+    {
+        for (int dx = -m_loadRadius; dx <= m_loadRadius; ++dx)
+        {
+            int distance = dx * dx + dz * dz;
+            if (distance > m_loadRadius * m_loadRadius)
+                continue;
+            if (m_chunks.count(makeKey(centerX + dx, centerZ + dz)) == 0)
+                requests.push_back({centerX + dx, centerZ + dz, distance});
+        }
+    }
+    std::sort(requests.begin(), requests.end(), [](const Request& a, const Request& b)
+    {
+        return a.distance < b.distance;
+    });
+    
+    for (const Request& request : requests)
+    {
+        if (m_shared->inFlight.load() >= MAX_LOADS_IN_FLIGHT)
+            break;
+        
+        int64_t key = makeKey(request.chunkX, request.chunkZ);
+        ChunkSlot& slot = m_chunks[key];
+        slot.ticket = ++m_nextTicket;
+        slot.loading = true;
+        
+        m_shared->inFlight++;
+        std::shared_ptr<SharedState> shared = m_shared;
+        uint32_t ticket = slot.ticket;
+        int chunkX = request.chunkX, chunkZ = request.chunkZ;
+        JobSystem::getInstance().submit([shared, key, ticket, chunkX, chunkZ]()
+        {
+            loadChunk(shared, key, ticket, chunkX, chunkZ);
+        });
+    }
+    
+    processUploads();
+    
+    m_residentCount = 0;
+    m_loadingCount = 0;
+    for (const auto& [key, slot] : m_chunks)
+    {
+        if (slot.loading)
+            m_loadingCount++;
+        else
+            m_residentCount++;
+    }
+}
+
+void ChunkStreamer::processUploads()
+{
+    m_lastUploadBytes = 0;
+    GpuUploader& uploader = GpuUploader::getInstance();
+    
+    LoadResult result;
+    while ((uploader.isThreaded() || m_lastUploadBytes < m_uploadBudget) && m_shared->completed.pop(result))
+    {
+        // Evicted or re-requested while loading
+        auto it = m_chunks.find(result.key);
+        if (it == m_chunks.end() || it->second.ticket != result.ticket)
+            continue;
+        
+        ChunkSlot& slot = it->second;
+        slot.loading = false;
+        slot.blocks = std::make_unique<PaletteChunk>(std::move(result.blocks));
+        if (result.mesh.indices.empty())
+            continue;
+        
+        // Drawn once the buffers arrive (an empty volume draws nothing)
+        int chunkX = (int)(result.key >> 32);
+        int chunkZ = (int)(int32_t)(result.key & 0xFFFFFFFF);
+        float chunkWorldSize = m_cellSize * CHUNK_SIZE;
+        slot.volume = std::make_unique<VoxelVolume>(
+            "Chunk", CHUNK_DEPTH,
+            m_originX + chunkX * chunkWorldSize, m_originY, m_originZ + chunkZ * chunkWorldSize, m_cellSize,
+            m_vertexShaderPath, m_fragmentShaderPath);
+        slot.volume->setSolidHeight(result.solidLayers);
+        m_lastUploadBytes += result.mesh.getByteSize();
+        
+        // The streamer may be gone by the time the buffers are ready
+        std::weak_ptr<SharedState> weakShared = m_shared;
+        int64_t key = result.key;
+        uint32_t ticket = result.ticket;
+        uploader.submitMesh(std::move(result.mesh), [weakShared, key, ticket](const UploadedMesh& mesh)
+        {
+            std::shared_ptr<SharedState> shared = weakShared.lock();
+            if (!shared)
+            {
+                UploadedMesh orphan = mesh;
+                orphan.release();
+                return;
+            }
+            shared->uploaded.push_back({key, ticket, mesh});
+        });
+    }
+    
+    // Attach finished uploads to their volumes
+    for (UploadedChunk& chunk : m_shared->uploaded)
+    {
+        auto it = m_chunks.find(chunk.key);
+        if (it != m_chunks.end() && it->second.ticket == chunk.ticket && it->second.volume)
+            it->second.volume->adoptMesh(chunk.mesh);
+        else
+            chunk.mesh.release();
+    }
+    m_shared->uploaded.clear();
+}
+
+std::shared_ptr<RegionFile> ChunkStreamer::getRegion(SharedState& shared, int chunkX, int chunkZ)
+{
+    int64_t regionKey = makeKey(RegionFile::toRegion(chunkX), RegionFile::toRegion(chunkZ));
+    
+    std::lock_guard<std::mutex> lock(shared.mutex);
+    auto it = shared.regions.find(regionKey);
+    if (it != shared.regions.end())
+        return it->second;
+    
+    // Missing files are cached too (as null) so they aren't retried per chunk
+    std::shared_ptr<RegionFile> region = std::make_shared<RegionFile>();
+    if (!region->open(shared.directory + RegionFile::getFileName(chunkX, chunkZ)))
+        region.reset();
+    shared.regions[regionKey] = region;
+    return region;
+}
+
+void ChunkStreamer::loadChunk(const std::shared_ptr<SharedState>& shared, int64_t key, uint32_t ticket, int chunkX, int chunkZ)
+{
+    LoadResult result;
+    result.key = key;
+    result.ticket = ticket;
+    
+    // Touching the mapping pages the chunk in here, off the GL thread
+    std::shared_ptr<RegionFile> region = getRegion(*shared, chunkX, chunkZ);
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+    int localX = chunkX - RegionFile::toRegion(chunkX) * RegionFile::REGION_SIZE;
+    int localZ = chunkZ - RegionFile::toRegion(chunkZ) * RegionFile::REGION_SIZE;
+    if (region && region->getChunk(localX, localZ, data, size) && decodeChunk(data, size, result.blocks))
+    {
+        buildVoxelMesh(result.blocks, result.mesh);
+        result.solidLayers = result.blocks.getSolidLayers();
+    }
+    
+    shared->completed.push(std::move(result));
+    shared->inFlight--;
+}
+
+int ChunkStreamer::getUploadQueueLength() const
+{
+    return (int)m_shared->completed.size();
+}
+
+size_t ChunkStreamer::getChunkDataMemory() const
+{
+    size_t bytes = 0;
+    for (const auto& [key, slot] : m_chunks)
+    {
+        if (slot.blocks)
+            bytes += slot.blocks->getMemoryUsage();
+    }
+    return bytes;
+}
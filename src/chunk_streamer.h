@@ -0,0 +1,137 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "voxel_volume.h"
+#include "palette_chunk.h"
+#include "chunk_codec.h"
+#include "object_pool.h"
+#include "mpsc_queue.h"
+#include "gpu_uploader.h"
+
+class RegionFile;
+
+// Streams chunk columns from region files around a point. Loading, decoding
+// and meshing run on the JobSystem (meshes are built from the palette form); finished meshes wait in a lock-free
+// queue and go to the GpuUploader, which uploads them on its loader thread or, without one, on the GL thread
+// within a per-frame byte budget.
+class ChunkStreamer
+{
+public:
+    ChunkStreamer();
+    ~ChunkStreamer();
+    
+    // Delete copy constructor and assignment operator
+    ChunkStreamer(const ChunkStreamer&) = delete;
+    ChunkStreamer& operator=(const ChunkStreamer&) = delete;
+    
+    // Directory holding the region files (with trailing separator)
+    void setWorldDirectory(const std::string& directory);
+    
+    // Shaders for the chunk volumes
+    void setShaderPaths(const std::string& vertexShaderPath, const std::string& fragmentShaderPath);
+    
+    // World position of chunk (0, 0)'s first cell and the size of a cell
+    void setPlacement(float originX, float originY, float originZ, float cellSize);
+    
+    // Chunks are kept within radius (in chunks) and evicted past radius + 1
+    void setLoadRadius(int radius) { m_loadRadius = radius; }
+    int getLoadRadius() const { return m_loadRadius; }
+    
+    // Bytes of mesh data uploaded on the GL thread per frame at most (one mesh
+    // always goes through), not limited when the upload thread runs
+    void setUploadBudget(size_t bytes) { m_uploadBudget = bytes; }
+    size_t getUploadBudget() const { return m_uploadBudget; }
+    
+    // GL thread, once per frame: evict, request loads around (x, z) and upload
+    void update(float x, float z);
+    
+    // Drop all chunks and cached regions (GL thread)
+    void clear();
+    
+    // Visit resident chunk volumes
+    template<typename Fn>
+    void forEachVolume(Fn&& fn) const
+    {
+        for (const auto& [key, slot] : m_chunks)
+        {
+            if (slot.volume)
+                fn(*slot.volume);
+        }
+    }
+    
+    // Statistics
+    int getResidentCount() const { return m_residentCount; }
+    int getLoadingCount() const { return m_loadingCount; }
+    int getUploadQueueLength() const;
+    size_t getLastUploadBytes() const { return m_lastUploadBytes; }
+    size_t getChunkDataMemory() const;
+    
+private:
+    // Decoded chunk waiting for upload
+    struct LoadResult
+    {
+        int64_t key = 0;
+        uint32_t ticket = 0;
+        PaletteChunk blocks;
+        MeshData mesh;
+        int solidLayers = 0;    // occluder hull height
+    };
+    
+    // Mesh buffers ready for drawing
+    struct UploadedChunk
+    {
+        int64_t key = 0;
+        uint32_t ticket = 0;
+        UploadedMesh mesh;
+    };
+    
+    // State shared with load jobs, which may outlive the streamer
+    struct SharedState
+    {
+        MpscQueue<LoadResult> completed;    // pushed by jobs, drained on the GL thread
+        std::vector<UploadedChunk> uploaded; // handed over by GpuUploader (GL thread only)
+        std::mutex mutex;                   // guards the region cache and directory
+        std::unordered_map<int64_t, std::shared_ptr<RegionFile>> regions;
+        std::string directory;
+        std::atomic<int> inFlight{0};
+    };
+    
+    struct ChunkSlot
+    {
+        uint32_t ticket = 0;
+        bool loading = true;
+        std::unique_ptr<PaletteChunk> blocks;   // resident block data, kept in palette form
+        std::unique_ptr<VoxelVolume> volume;    // null while loading or when empty
+    };
+    
+    static int64_t makeKey(int chunkX, int chunkZ) { return ((int64_t)chunkX << 32) | (uint32_t)chunkZ; }
+    static void loadChunk(const std::shared_ptr<SharedState>& shared, int64_t key, uint32_t ticket, int chunkX, int chunkZ);
+    static std::shared_ptr<RegionFile> getRegion(SharedState& shared, int chunkX, int chunkZ);
+    
+    void processUploads();
+    
+    std::shared_ptr<SharedState> m_shared;
+    
+    // Slot nodes come from a pool instead of one heap allocation each
+    using ChunkMap = std::unordered_map<int64_t, ChunkSlot, std::hash<int64_t>, std::equal_to<int64_t>,
+                                        PoolAllocator<std::pair<const int64_t, ChunkSlot>>>;
+    ChunkMap m_chunks;
+    uint32_t m_nextTicket;
+    
+    std::string m_vertexShaderPath;
+    std::string m_fragmentShaderPath;
+    float m_originX, m_originY, m_originZ;
+    float m_cellSize;
+    int m_loadRadius;
+    size_t m_uploadBudget;
+    
+    int m_residentCount;
+    int m_loadingCount;
+    size_t m_lastUploadBytes;
+};
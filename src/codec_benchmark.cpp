@@ -0,0 +1,99 @@
+#include "codec_benchmark.h"
+#include "chunk_codec.h"
+#include "palette_chunk.h"
+#include "voxel_volume.h"
+#include "world_generator.h"
+#include <vector>
+
+#include <SDL3/SDL.h>
+
+namespace
+{
+    double secondsSince(Uint64 start)
+    {
+        return (double)(SDL_GetPerformanceCounter() - start) / (double)SDL_GetPerformanceFrequency();
+    }
+    
+    double megabytesPerSecond(size_t bytes, double seconds)
+    {
+        return seconds > 0.0 ? (double)bytes / (1024.0 * 1024.0) / seconds : 0.0;
+    }
+}
+
+void runChunkCodecBenchmark(int chunkCount, int iterations)
+{
+    // Synthetic terrain from the world generator, laid out in a square
+    std::vector<PaletteChunk> chunks(chunkCount);
+    VoxelOctree octree(CHUNK_DEPTH);
+    int side = 1;
+    while (side * side < chunkCount)
+    {
+        ++side;
+    }
+    for (int i = 0; i < chunkCount; ++i)
+    {
+        generateChunk(i % side, i / side, octree);
+        chunks[i].fromOctree(octree);
+    }
+    
+    size_t denseBytes = (size_t)chunkCount * CHUNK_CELLS * sizeof(BlockId);
+    size_t paletteBytes = 0;
+    for (const PaletteChunk& chunk : chunks)
+    {
+        paletteBytes += chunk.getMemoryUsage();
+    }
+    
+    // Encode
+    std::vector<std::vector<uint8_t>> encoded(chunkCount);
+    Uint64 start = SDL_GetPerformanceCounter();
+    for (int iteration = 0; iteration < iterations; ++iteration)
+    {
+        for (int i = 0; i < chunkCount; ++i)
+        {
+            encodeChunk(chunks[i], encoded[i]);
+        }
+    }
+    double encodeSeconds = secondsSince(start);
+    
+    size_t encodedBytes = 0;
+    for (const std::vector<uint8_t>& data : encoded)
+    {
+        encodedBytes += data.size();
+    }
+    
+    // Decode into the palette form (the streaming path)
+    PaletteChunk decoded;
+    int failures = 0;
+    start = SDL_GetPerformanceCounter();
+    for (int iteration = 0; iteration < iterations; ++iteration)
+    {
+        for (int i = 0; i < chunkCount; ++i)
+        {
+            if (!decodeChunk(encoded[i].data(), encoded[i].size(), decoded))
+                failures++;
+        }
+    }
+    double decodeSeconds = secondsSince(start);
+    
+    // Decode and mesh straight from the palette form
+    MeshData mesh;
+    start = SDL_GetPerformanceCounter();
+    for (int i = 0; i < chunkCount; ++i)
+    {
+        decodeChunk(encoded[i].data(), encoded[i].size(), decoded);
+        buildVoxelMesh(decoded, mesh);
+    }
+    double meshSeconds = secondsSince(start);
+    
+    size_t processedBytes = denseBytes * (size_t)iterations;
+    SDL_Log("Chunk codec: %d chunks, %.1f KB dense, %.1f KB palette in memory, %.1f KB encoded",
+            chunkCount, denseBytes / 1024.0, paletteBytes / 1024.0, encodedBytes / 1024.0);
+    SDL_Log("Chunk codec: ratio %.1f:1 vs dense, %.1f:1 vs palette",
+            encodedBytes ? (double)denseBytes / encodedBytes : 0.0,
+            encodedBytes ? (double)paletteBytes / encodedBytes : 0.0);
+    SDL_Log("Chunk codec: encode %.0f MB/s, decode %.0f MB/s, decode + mesh %.2f ms per chunk",
+            megabytesPerSecond(processedBytes, encodeSeconds), megabytesPerSecond(processedBytes, decodeSeconds),
+            chunkCount ? meshSeconds * 1000.0 / chunkCount : 0.0);
+    if (failures > 0)
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Chunk codec: %d chunks failed to decode", failures);
+}
@@ -0,0 +1,6 @@
+#pragma once
+
+// Encode and decode generated terrain chunks and log the compression ratio
+// and throughput (MB/s of dense BlockId data). Runs on the calling thread,
+// needs no window or GL context.
+void runChunkCodecBenchmark(int chunkCount = 256, int iterations = 8);
@@ -3,6 +3,9 @@
 
 #include "donut.h"
 #include "shader_manager.h"
+#include "mesh_builder.h"
+#include "mesh_library.h"
+#include "libs/maths/matrix.h"
 #include "imgui.h"
 #include <cmath>
 #include <cstring>
@@ -12,26 +15,20 @@ Donut::Donut(const std::string& name, float x, float y, float z,
              float outerRadius, float innerRadius,
              const std::string& vertexShaderPath, const std::string& fragmentShaderPath)
     : m_name(name)
-    , m_vertexShaderPath(vertexShaderPath)
-    , m_fragmentShaderPath(fragmentShaderPath)
-    , m_shaderProgram(0)
+    , m_shaderHandle(INVALID_SHADER_HANDLE)
     , m_posX(x), m_posY(y), m_posZ(z)
     , m_outerRadius(outerRadius)
     , m_innerRadius(innerRadius)
     , m_rotX(0.0f), m_rotY(0.0f), m_rotZ(0.0f)
+    , m_eulerDirty(false)
     , m_autoRotate(false)
     , m_rotationSpeed(20.0f)
     , m_colorR(1.0f), m_colorG(0.5f), m_colorB(0.0f)
-    , m_majorSegments(48)
-    , m_minorSegments(24)
-    , m_VAO(0), m_VBO(0), m_EBO(0)
-    , m_ownsShader(false)
-    , m_initialized(false)
-    , m_windowVisible(true)
-    , m_vertexCount(0)
-    , m_indexCount(0)
+    , m_majorSegments(TORUS_MAJOR_SEGMENTS)
+    , m_minorSegments(TORUS_MINOR_SEGMENTS)
 {
     std::memset(m_modelMatrix, 0, sizeof(m_modelMatrix));
+    std::memset(m_normalMatrix, 0, sizeof(m_normalMatrix));
     
     // Initialize quaternion to identity (no rotation)
     m_quat[0] = 1.0f; // w
@@ -40,11 +37,10 @@ Donut::Donut(const std::string& name, float x, float y, float z,
     m_quat[3] = 0.0f; // z
     
     // Load shader if paths are provided
-    if (!m_vertexShaderPath.empty() && !m_fragmentShaderPath.empty())
+    if (!vertexShaderPath.empty() && !fragmentShaderPath.empty())
     {
-        m_shaderProgram = ShaderManager::getInstance().getShaderProgram(
-            m_vertexShaderPath, m_fragmentShaderPath);
-        m_ownsShader = true;
+        m_shaderHandle = ShaderManager::getInstance().requestShaderProgram(
+            vertexShaderPath, fragmentShaderPath, { SHADER_DEFINE_NORMAL_MATRIX });
     }
     
     initialize();
@@ -58,35 +54,25 @@ Donut::~Donut()
 
 Donut::Donut(Donut&& other) noexcept
     : m_name(std::move(other.m_name))
-    , m_vertexShaderPath(std::move(other.m_vertexShaderPath))
-    , m_fragmentShaderPath(std::move(other.m_fragmentShaderPath))
-    , m_shaderProgram(other.m_shaderProgram)
+    , m_shaderHandle(other.m_shaderHandle)
     , m_posX(other.m_posX), m_posY(other.m_posY), m_posZ(other.m_posZ)
     , m_outerRadius(other.m_outerRadius)
     , m_innerRadius(other.m_innerRadius)
     , m_rotX(other.m_rotX), m_rotY(other.m_rotY), m_rotZ(other.m_rotZ)
+    , m_eulerDirty(other.m_eulerDirty)
     , m_autoRotate(other.m_autoRotate)
     , m_rotationSpeed(other.m_rotationSpeed)
     , m_colorR(other.m_colorR), m_colorG(other.m_colorG), m_colorB(other.m_colorB)
     , m_majorSegments(other.m_majorSegments)
     , m_minorSegments(other.m_minorSegments)
-    , m_VAO(other.m_VAO), m_VBO(other.m_VBO), m_EBO(other.m_EBO)
-    , m_ownsShader(other.m_ownsShader)
-    , m_initialized(other.m_initialized)
-    , m_windowVisible(other.m_windowVisible)
-    , m_vertexCount(other.m_vertexCount)
-    , m_indexCount(other.m_indexCount)
+    , m_mesh(std::move(other.m_mesh))
 {
     std::memcpy(m_modelMatrix, other.m_modelMatrix, sizeof(m_modelMatrix));
+    std::memcpy(m_normalMatrix, other.m_normalMatrix, sizeof(m_normalMatrix));
     std::memcpy(m_quat, other.m_quat, sizeof(m_quat));
     
     // Reset other's resources
-    other.m_shaderProgram = 0;
-    other.m_VAO = 0;
-    other.m_VBO = 0;
-    other.m_EBO = 0;
-    other.m_ownsShader = false;
-    other.m_initialized = false;
+    other.m_shaderHandle = INVALID_SHADER_HANDLE;
 }
 
 Donut& Donut::operator=(Donut&& other) noexcept
@@ -96,9 +82,7 @@ Donut& Donut::operator=(Donut&& other) noexcept
         cleanup();
         
         m_name = std::move(other.m_name);
-        m_vertexShaderPath = std::move(other.m_vertexShaderPath);
-        m_fragmentShaderPath = std::move(other.m_fragmentShaderPath);
-        m_shaderProgram = other.m_shaderProgram;
+        m_shaderHandle = other.m_shaderHandle;
         m_posX = other.m_posX;
         m_posY = other.m_posY;
         m_posZ = other.m_posZ;
@@ -107,6 +91,7 @@ Donut& Donut::operator=(Donut&& other) noexcept
         m_rotX = other.m_rotX;
         m_rotY = other.m_rotY;
         m_rotZ = other.m_rotZ;
+        m_eulerDirty = other.m_eulerDirty;
         m_autoRotate = other.m_autoRotate;
         m_rotationSpeed = other.m_rotationSpeed;
         m_colorR = other.m_colorR;
@@ -114,155 +99,46 @@ Donut& Donut::operator=(Donut&& other) noexcept
         m_colorB = other.m_colorB;
         m_majorSegments = other.m_majorSegments;
         m_minorSegments = other.m_minorSegments;
-        m_VAO = other.m_VAO;
-        m_VBO = other.m_VBO;
-        m_EBO = other.m_EBO;
-        m_ownsShader = other.m_ownsShader;
-        m_initialized = other.m_initialized;
-        m_windowVisible = other.m_windowVisible;
-        m_vertexCount = other.m_vertexCount;
-        m_indexCount = other.m_indexCount;
+        m_mesh = std::move(other.m_mesh);
         
         std::memcpy(m_modelMatrix, other.m_modelMatrix, sizeof(m_modelMatrix));
+        std::memcpy(m_normalMatrix, other.m_normalMatrix, sizeof(m_normalMatrix));
         std::memcpy(m_quat, other.m_quat, sizeof(m_quat));
         
-        other.m_shaderProgram = 0;
-        other.m_VAO = 0;
-        other.m_VBO = 0;
-        other.m_EBO = 0;
-        other.m_ownsShader = false;
-        other.m_initialized = false;
+        other.m_shaderHandle = INVALID_SHADER_HANDLE;
     }
     return *this;
 }
 
-void Donut::generateTorusGeometry()
+void Donut::requestGeometry()
 {
-    std::vector<float> vertices;
-    std::vector<unsigned int> indices;
-    
-    const float PI = 3.14159265359f;
-    float tubeRadius = (m_outerRadius - m_innerRadius) * 0.5f;
-    float torusRadius = m_innerRadius + tubeRadius;
-    
-    // Generate vertices
-    for (int i = 0; i <= m_majorSegments; ++i)
-    {
-        float theta = (float)i / m_majorSegments * 2.0f * PI;
-        float cosTheta = std::cos(theta);
-        float sinTheta = std::sin(theta);
-        
-        for (int j = 0; j <= m_minorSegments; ++j)
-        {
-            float phi = (float)j / m_minorSegments * 2.0f * PI;
-            float cosPhi = std::cos(phi);
-            float sinPhi = std::sin(phi);
-            
-            // Position
-            float x = (torusRadius + tubeRadius * cosPhi) * cosTheta;
-            float y = tubeRadius * sinPhi;
-            float z = (torusRadius + tubeRadius * cosPhi) * sinTheta;
-            
-            // Normal
-            float nx = cosPhi * cosTheta;
-            float ny = sinPhi;
-            float nz = cosPhi * sinTheta;
-            
-            // Color (gradient based on position using base color)
-            float colorVariation = (sinPhi + 1.0f) * 0.5f;
-            float r = m_colorR * (0.7f + colorVariation * 0.3f);
-            float g = m_colorG * (0.7f + colorVariation * 0.3f);
-            float b = m_colorB * (0.7f + colorVariation * 0.3f);
-            
-            // Add vertex data: position (3) + color (3) + normal (3)
-            vertices.push_back(x);
-            vertices.push_back(y);
-            vertices.push_back(z);
-            vertices.push_back(r);
-            vertices.push_back(g);
-            vertices.push_back(b);
-            vertices.push_back(nx);
-            vertices.push_back(ny);
-            vertices.push_back(nz);
-        }
-    }
-    
-    // Generate indices
-    for (int i = 0; i < m_majorSegments; ++i)
+    // Built on a worker from a copy of the parameters, uploaded by MeshBuilder
+    // (radius and color sliders request a rebuild every frame while dragged)
+    float outerRadius = m_outerRadius;
+    float innerRadius = m_innerRadius;
+    int majorSegments = m_majorSegments;
+    int minorSegments = m_minorSegments;
+    float color[3] = {m_colorR, m_colorG, m_colorB};
+    MeshBuilder::getInstance().requestBuild(m_mesh, [=](MeshData& mesh)
     {
-        for (int j = 0; j < m_minorSegments; ++j)
-        {
-            int first = i * (m_minorSegments + 1) + j;
-            int second = first + m_minorSegments + 1;
-            
-            // First triangle
-            indices.push_back(first);
-            indices.push_back(second);
-            indices.push_back(first + 1);
-            
-            // Second triangle
-            indices.push_back(second);
-            indices.push_back(second + 1);
-            indices.push_back(first + 1);
-        }
-    }
-    
-    m_vertexCount = vertices.size() / 9;
-    m_indexCount = indices.size();
-    
-    // Upload to GPU
-    glBindVertexArray(m_VAO);
-    
-    glBindBuffer(GL_ARRAY_BUFFER, m_VBO);
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
-    
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_EBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
-    
-    // Position attribute (location 0)
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 9 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-    
-    // Color attribute (location 1)
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 9 * sizeof(float), (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
-    
-    // Normal attribute (location 2)
-    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, 9 * sizeof(float), (void*)(6 * sizeof(float)));
-    glEnableVertexAttribArray(2);
-    
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
+        buildTorusMesh(mesh, outerRadius, innerRadius, majorSegments, minorSegments, color);
+    });
 }
 
 void Donut::initialize()
 {
-    if (m_initialized)
+    if (m_mesh)
         return;
     
-    // Create VAO, VBO, and EBO
-    glGenVertexArrays(1, &m_VAO);
-    glGenBuffers(1, &m_VBO);
-    glGenBuffers(1, &m_EBO);
-    
-    generateTorusGeometry();
-    
-    m_initialized = true;
+    // Buffers now, contents once the first build is uploaded
+    m_mesh = std::make_shared<GpuMesh>();
+    requestGeometry();
 }
 
 void Donut::cleanup()
 {
-    if (m_initialized)
-    {
-        glDeleteVertexArrays(1, &m_VAO);
-        glDeleteBuffers(1, &m_VBO);
-        glDeleteBuffers(1, &m_EBO);
-        
-        m_VAO = 0;
-        m_VBO = 0;
-        m_EBO = 0;
-        m_initialized = false;
-    }
+    // A build still running for this mesh is dropped when it finishes
+    m_mesh.reset();
 }
 
 void Donut::updateModelMatrix()
@@ -295,9 +171,12 @@ void Donut::updateModelMatrix()
     m_modelMatrix[13] = m_posY;
     m_modelMatrix[14] = m_posZ;
     m_modelMatrix[15] = 1.0f;
+    
+    // Rotation only (scale is uniform), so the normal matrix is the rotation itself
+    normalMatrixFromQuaternion(m_normalMatrix, m_quat);
 }
 
-void Donut::updateEulerFromQuaternion()
+void Donut::updateEulerFromQuaternion() const
 {
     // Convert quaternion to Euler angles (ZYX order)
     float w = m_quat[0], x = m_quat[1], y = m_quat[2], z = m_quat[3];
@@ -323,40 +202,33 @@ void Donut::updateEulerFromQuaternion()
     if (m_rotX < 0.0f) m_rotX += 360.0f;
     if (m_rotY < 0.0f) m_rotY += 360.0f;
     if (m_rotZ < 0.0f) m_rotZ += 360.0f;
+    
+    m_eulerDirty = false;
 }
 
-void Donut::render(GLuint shaderProgram, const float* viewMatrix, const float* projectionMatrix)
+void Donut::getLocalBounds(float* boundsMin, float* boundsMax) const
 {
-    if (!m_initialized)
-        return;
-    
-    // Use provided shader or donut's own shader
-    GLuint programToUse = (shaderProgram != 0) ? shaderProgram : m_shaderProgram;
-    
-    if (programToUse == 0)
-        return; // No shader available
-    
-    // Use shader program and set uniforms
-    glUseProgram(programToUse);
-    
-    GLint modelLoc = glGetUniformLocation(programToUse, "model");
-    GLint viewLoc = glGetUniformLocation(programToUse, "view");
-    GLint projLoc = glGetUniformLocation(programToUse, "projection");
-    
-    glUniformMatrix4fv(modelLoc, 1, GL_FALSE, m_modelMatrix);
-    glUniformMatrix4fv(viewLoc, 1, GL_FALSE, viewMatrix);
-    glUniformMatrix4fv(projLoc, 1, GL_FALSE, projectionMatrix);
-    
-    // Draw donut
-    glBindVertexArray(m_VAO);
-    glDrawElements(GL_TRIANGLES, m_indexCount, GL_UNSIGNED_INT, 0);
-    glBindVertexArray(0);
+    float tubeRadius = (m_outerRadius - m_innerRadius) * 0.5f;
+    boundsMin[0] = -m_outerRadius; boundsMin[1] = -tubeRadius; boundsMin[2] = -m_outerRadius;
+    boundsMax[0] = m_outerRadius;  boundsMax[1] = tubeRadius;  boundsMax[2] = m_outerRadius;
 }
 
-void Donut::render(const float* viewMatrix, const float* projectionMatrix)
+void Donut::submit(RenderQueue& queue, GLuint shaderProgram, uint32_t pickId) const
 {
-    // Use donut's own shader
-    render(0, viewMatrix, projectionMatrix);
+    if (!m_mesh || m_mesh->getIndexCount() == 0)
+        return;
+    
+    DrawItem item;
+    item.program = (shaderProgram != 0) ? shaderProgram : getShaderProgram();
+    item.vao = m_mesh->getVAO();
+    item.depthVao = m_mesh->getDepthVAO();
+    item.indexCount = m_mesh->getIndexCount();
+    item.modelMatrix = m_modelMatrix;
+    item.normalMatrix = m_normalMatrix;
+    item.pickId = pickId;
+    
+    if (item.program != 0)
+        queue.add(item);
 }
 
 void Donut::setPosition(float x, float y, float z)
@@ -372,7 +244,7 @@ void Donut::setOuterRadius(float radius)
     if (radius > m_innerRadius)
     {
         m_outerRadius = radius;
-        generateTorusGeometry();
+        requestGeometry();
     }
 }
 
@@ -381,7 +253,7 @@ void Donut::setInnerRadius(float radius)
     if (radius < m_outerRadius && radius > 0.0f)
     {
         m_innerRadius = radius;
-        generateTorusGeometry();
+        requestGeometry();
     }
 }
 
@@ -390,6 +262,7 @@ void Donut::setRotation(float angleX, float angleY, float angleZ)
     m_rotX = angleX;
     m_rotY = angleY;
     m_rotZ = angleZ;
+    m_eulerDirty = false;
     
     // Convert Euler angles to quaternion (Z * Y * X order)
     float radX = angleX * 3.14159265359f / 180.0f;
@@ -414,7 +287,12 @@ void Donut::setColor(float r, float g, float b)
     m_colorG = g;
     m_colorB = b;
     // Regenerate geometry with new color
-    generateTorusGeometry();
+    requestGeometry();
+}
+
+GLuint Donut::getShaderProgram() const
+{
+    return ShaderManager::getInstance().getProgram(m_shaderHandle);
 }
 
 void Donut::getPosition(float& x, float& y, float& z) const
@@ -424,77 +302,81 @@ void Donut::getPosition(float& x, float& y, float& z) const
     z = m_posZ;
 }
 
-void Donut::showControls()
+void Donut::getRotation(float& x, float& y, float& z) const
 {
-    // Only show window if visible
-    if (!m_windowVisible)
-        return;
+    if (m_eulerDirty)
+        updateEulerFromQuaternion();
+    x = m_rotX;
+    y = m_rotY;
+    z = m_rotZ;
+}
+
+void Donut::showInspector()
+{
+    // Auto-rotation and dragging only touch the quaternion
+    if (m_eulerDirty)
+        updateEulerFromQuaternion();
     
-    // Create individual window for this donut with close button
-    if (ImGui::Begin(m_name.c_str(), &m_windowVisible))
+    // Position controls
+    ImGui::Text("Position:");
+    ImGui::PushItemWidth(100);
+    if (ImGui::DragFloat("X##pos", &m_posX, 0.1f, -10.0f, 10.0f))
+        updateModelMatrix();
+    ImGui::SameLine();
+    if (ImGui::DragFloat("Y##pos", &m_posY, 0.1f, -10.0f, 10.0f))
+        updateModelMatrix();
+    ImGui::SameLine();
+    if (ImGui::DragFloat("Z##pos", &m_posZ, 0.1f, -10.0f, 10.0f))
+        updateModelMatrix();
+    ImGui::PopItemWidth();
+    
+    // Rotation controls
+    ImGui::Text("Rotation:");
+    ImGui::PushItemWidth(100);
+    if (ImGui::DragFloat("X##rot", &m_rotX, 1.0f, 0.0f, 360.0f))
+        setRotation(m_rotX, m_rotY, m_rotZ);
+    ImGui::SameLine();
+    if (ImGui::DragFloat("Y##rot", &m_rotY, 1.0f, 0.0f, 360.0f))
+        setRotation(m_rotX, m_rotY, m_rotZ);
+    ImGui::SameLine();
+    if (ImGui::DragFloat("Z##rot", &m_rotZ, 1.0f, 0.0f, 360.0f))
+        setRotation(m_rotX, m_rotY, m_rotZ);
+    ImGui::PopItemWidth();
+    
+    // Diameter controls
+    ImGui::Separator();
+    ImGui::Text("Donut Dimensions:");
+    float outerDiameter = m_outerRadius * 2.0f;
+    float innerDiameter = m_innerRadius * 2.0f;
+    
+    if (ImGui::SliderFloat("Outer Diameter", &outerDiameter, 0.2f, 5.0f))
     {
-        // Position controls
-        ImGui::Text("Position:");
-        ImGui::PushItemWidth(100);
-        if (ImGui::DragFloat("X##pos", &m_posX, 0.1f, -10.0f, 10.0f))
-            updateModelMatrix();
-        ImGui::SameLine();
-        if (ImGui::DragFloat("Y##pos", &m_posY, 0.1f, -10.0f, 10.0f))
-            updateModelMatrix();
-        ImGui::SameLine();
-        if (ImGui::DragFloat("Z##pos", &m_posZ, 0.1f, -10.0f, 10.0f))
-            updateModelMatrix();
-        ImGui::PopItemWidth();
-        
-        // Rotation controls
-        ImGui::Text("Rotation:");
-        ImGui::PushItemWidth(100);
-        if (ImGui::DragFloat("X##rot", &m_rotX, 1.0f, 0.0f, 360.0f))
-            setRotation(m_rotX, m_rotY, m_rotZ);
-        ImGui::SameLine();
-        if (ImGui::DragFloat("Y##rot", &m_rotY, 1.0f, 0.0f, 360.0f))
-            setRotation(m_rotX, m_rotY, m_rotZ);
-        ImGui::SameLine();
-        if (ImGui::DragFloat("Z##rot", &m_rotZ, 1.0f, 0.0f, 360.0f))
-            setRotation(m_rotX, m_rotY, m_rotZ);
-        ImGui::PopItemWidth();
-        
-        // Diameter controls
-        ImGui::Separator();
-        ImGui::Text("Donut Dimensions:");
-        float outerDiameter = m_outerRadius * 2.0f;
-        float innerDiameter = m_innerRadius * 2.0f;
-        
-        if (ImGui::SliderFloat("Outer Diameter", &outerDiameter, 0.2f, 5.0f))
-        {
-            setOuterRadius(outerDiameter * 0.5f);
-        }
-        
-        if (ImGui::SliderFloat("Inner Diameter", &innerDiameter, 0.1f, outerDiameter - 0.1f))
-        {
-            setInnerRadius(innerDiameter * 0.5f);
-        }
-        
-        // Color control
-        float tempColor[3] = {m_colorR, m_colorG, m_colorB};
-        if (ImGui::ColorEdit3("Color", tempColor))
-        {
-            setColor(tempColor[0], tempColor[1], tempColor[2]);
-        }
-        
-        ImGui::Separator();
-        
-        // Auto-rotation controls
-        ImGui::Checkbox("Auto Rotate", &m_autoRotate);
-        if (m_autoRotate)
-        {
-            ImGui::SliderFloat("Rotation Speed", &m_rotationSpeed, 0.0f, 100.0f);
-        }
+        setOuterRadius(outerDiameter * 0.5f);
+    }
+    
+    if (ImGui::SliderFloat("Inner Diameter", &innerDiameter, 0.1f, outerDiameter - 0.1f))
+    {
+        setInnerRadius(innerDiameter * 0.5f);
+    }
+    
+    // Color control
+    float tempColor[3] = {m_colorR, m_colorG, m_colorB};
+    if (ImGui::ColorEdit3("Color", tempColor))
+    {
+        setColor(tempColor[0], tempColor[1], tempColor[2]);
+    }
+    
+    ImGui::Separator();
+    
+    // Auto-rotation controls
+    ImGui::Checkbox("Auto Rotate", &m_autoRotate);
+    if (m_autoRotate)
+    {
+        ImGui::SliderFloat("Rotation Speed", &m_rotationSpeed, 0.0f, 100.0f);
     }
-    ImGui::End();
 }
 
-void Donut::update(float deltaTime)
+bool Donut::update(float deltaTime)
 {
     if (m_autoRotate)
     {
@@ -526,11 +408,13 @@ void Donut::update(float deltaTime)
         m_quat[2] = qNew[2] / len;
         m_quat[3] = qNew[3] / len;
         
-        // Update Euler angles for ImGui display
-        updateEulerFromQuaternion();
+        // Euler angles are only needed by the inspector
+        m_eulerDirty = true;
         
         updateModelMatrix();
+        return true;
     }
+    return false;
 }
 
 void Donut::rotateScreenSpace(float horizontalDelta, float verticalDelta, const float* cameraRight, const float* cameraUp)
@@ -584,8 +468,8 @@ void Donut::rotateScreenSpace(float horizontalDelta, float verticalDelta, const
     m_quat[2] = qNew[2] / len;
     m_quat[3] = qNew[3] / len;
     
-    // Update Euler angles for ImGui display
-    updateEulerFromQuaternion();
+    // Euler angles are only needed by the inspector
+    m_eulerDirty = true;
     
     updateModelMatrix();
 }
@@ -5,6 +5,12 @@
 
 #include <vector>
 #include <string>
+#include <cstdint>
+#include <memory>
+
+#include "shader_manager.h"
+#include "render_queue.h"
+#include "mesh_builder.h"
 
 #if defined(__APPLE__)
     #include <OpenGL/gl3.h>
@@ -33,18 +39,12 @@ public:
     Donut(Donut&& other) noexcept;
     Donut& operator=(Donut&& other) noexcept;
     
-    // Render the donut (uses internal shader if shaderProgram is 0)
-    void render(GLuint shaderProgram, const float* viewMatrix, const float* projectionMatrix);
-    
-    // Render with donut's own shader
-    void render(const float* viewMatrix, const float* projectionMatrix);
+    // Queue the donut for sorted drawing (uses internal shader if shaderProgram is 0),
+    // pickId is written by the GPU picking pass
+    void submit(RenderQueue& queue, GLuint shaderProgram = 0, uint32_t pickId = 0) const;
     
-    // Show ImGui controls for this donut in its own window
-    void showControls();
-    
-    // Window visibility control
-    void setWindowVisible(bool visible) { m_windowVisible = visible; }
-    bool isWindowVisible() const { return m_windowVisible; }
+    // Show ImGui controls for this donut inside the current window
+    void showInspector();
     
     // Ray intersection test for picking
     bool intersectsRay(const float* rayOrigin, const float* rayDirection, float& distance) const;
@@ -60,37 +60,45 @@ public:
     // Screen-space rotation (rotates around camera's horizontal and vertical axes)
     void rotateScreenSpace(float horizontalDelta, float verticalDelta, const float* cameraRight, const float* cameraUp);
     
-    // Update for auto-rotation (call each frame with deltaTime)
-    void update(float deltaTime);
+    // Update for auto-rotation (call each frame with deltaTime), true if the object moved
+    bool update(float deltaTime);
     
     // Getters
     void getPosition(float& x, float& y, float& z) const;
     float getOuterRadius() const { return m_outerRadius; }
     float getInnerRadius() const { return m_innerRadius; }
-    void getRotation(float& x, float& y, float& z) const { x = m_rotX; y = m_rotY; z = m_rotZ; }
+    void getRotation(float& x, float& y, float& z) const;
     const std::string& getName() const { return m_name; }
-    GLuint getShaderProgram() const { return m_shaderProgram; }
+    const float* getModelMatrix() const { return m_modelMatrix; }
+    const float* getNormalMatrix() const { return m_normalMatrix; }
+    
+    // Axis-aligned bounds of the mesh in model space (before the model matrix)
+    void getLocalBounds(float* boundsMin, float* boundsMax) const;
+    
+    // Program to draw with (fallback program while the real one compiles)
+    GLuint getShaderProgram() const;
     
 private:
     void initialize();
     void cleanup();
     void updateModelMatrix();
-    void updateEulerFromQuaternion();
-    void generateTorusGeometry();
+    void updateEulerFromQuaternion() const;
+    void requestGeometry();
     
     // Name for ImGui identification
     std::string m_name;
     
-    // Shader paths and program
-    std::string m_vertexShaderPath;
-    std::string m_fragmentShaderPath;
-    GLuint m_shaderProgram;
+    // Shader program variant
+    ShaderHandle m_shaderHandle;
     
     // Position and transform
     float m_posX, m_posY, m_posZ;
     float m_outerRadius;  // Outer diameter / 2
     float m_innerRadius;  // Inner diameter / 2
-    float m_rotX, m_rotY, m_rotZ;
+    
+    // Euler angles for the UI, derived from the quaternion only when read
+    mutable float m_rotX, m_rotY, m_rotZ;
+    mutable bool m_eulerDirty;
     
     // Quaternion for screen-space rotation (w, x, y, z)
     float m_quat[4];
@@ -106,22 +114,12 @@ private:
     int m_majorSegments;  // Segments around the major circle
     int m_minorSegments;  // Segments around the tube
     
-    // OpenGL objects
-    GLuint m_VAO;
-    GLuint m_VBO;
-    GLuint m_EBO;
-    bool m_ownsShader; // Whether this donut loaded its own shader
+    // OpenGL buffers, shared with MeshBuilder's pending upload (null once moved from)
+    std::shared_ptr<GpuMesh> m_mesh;
     
     // Model matrix
     float m_modelMatrix[16];
     
-    // Flag to track if OpenGL resources are initialized
-    bool m_initialized;
-    
-    // UI state
-    bool m_windowVisible;
-    
-    // Vertex and index counts
-    int m_vertexCount;
-    int m_indexCount;
+    // Normal matrix (mat3), precomputed so the vertex shader skips inverse()
+    float m_normalMatrix[9];
 };
@@ -0,0 +1,257 @@
+// Silence OpenGL deprecation warnings on macOS
+#define GL_SILENCE_DEPRECATION
+
+#include "dynamic_resolution.h"
+#include "render_stats.h"
+#include "gl_state.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    // Hysteresis band around the target: over OVER_BUDGET the scale drops,
+    // under UNDER_BUDGET it rises, in between it stays
+    const float OVER_BUDGET = 0.95f;
+    const float UNDER_BUDGET = 0.75f;
+    
+    // Consecutive samples outside the band before the scale changes;
+    // dropping reacts fast, rising waits so a short calm doesn't cause a hitch
+    const int DOWN_SAMPLES = 3;
+    const int UP_SAMPLES = 45;
+    
+    // Weight of a new sample in the smoothed GPU time
+    const float SMOOTHING = 0.2f;
+    
+    // Smallest scale allowed at all (1/16 of the pixels)
+    const float LOWEST_SCALE = 0.25f;
+}
+
+DynamicResolution::DynamicResolution(const std::string& vertexShaderPath, const std::string& fragmentShaderPath)
+    : m_shaderHandle(INVALID_SHADER_HANDLE)
+    , m_initialized(false)
+    , m_queries{}
+    , m_firstPending(0)
+    , m_pendingCount(0)
+    , m_timing(false)
+    , m_vertexArray(0)
+    , m_sampler(0)
+    , m_enabled(true)
+    , m_targetMilliseconds(1000.0f / 60.0f)
+    , m_minScale(0.5f)
+    , m_maxScale(1.0f)
+    , m_scale(1.0f)
+    , m_gpuMilliseconds(0.0f)
+    , m_hasSample(false)
+    , m_overBudgetFrames(0)
+    , m_underBudgetFrames(0)
+    , m_ignoredSamples(0)
+{
+    m_shaderHandle = ShaderManager::getInstance().requestShaderProgram(vertexShaderPath, fragmentShaderPath);
+}
+
+DynamicResolution::~DynamicResolution()
+{
+    cleanup();
+}
+
+bool DynamicResolution::initialize()
+{
+    if (m_initialized)
+        return true;
+    
+    glGenQueries(QUERY_COUNT, m_queries);
+    glGenVertexArrays(1, &m_vertexArray);
+    
+    glGenSamplers(1, &m_sampler);
+    glSamplerParameteri(m_sampler, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glSamplerParameteri(m_sampler, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glSamplerParameteri(m_sampler, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glSamplerParameteri(m_sampler, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    
+    m_initialized = true;
+    return true;
+}
+
+void DynamicResolution::update()
+{
+    // Oldest first, stop at the first query the GPU hasn't reached yet
+    while (m_pendingCount > 0)
+    {
+        GLuint query = m_queries[m_firstPending];
+        GLint available = 0;
+        glGetQueryObjectiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available)
+            break;
+        
+        GLuint64 nanoseconds = 0;
+        glGetQueryObjectui64v(query, GL_QUERY_RESULT, &nanoseconds);
+        m_firstPending = (m_firstPending + 1) % QUERY_COUNT;
+        m_pendingCount--;
+        addSample((float)(nanoseconds / 1.0e6));
+    }
+}
+
+void DynamicResolution::beginTiming()
+{
+    // Every query still in flight: this frame goes unmeasured rather than waiting
+    if (!initialize() || m_pendingCount >= QUERY_COUNT)
+        return;
+    
+    glBeginQuery(GL_TIME_ELAPSED, m_queries[(m_firstPending + m_pendingCount) % QUERY_COUNT]);
+    m_timing = true;
+}
+
+void DynamicResolution::endTiming()
+{
+    if (!m_timing)
+        return;
+    
+    glEndQuery(GL_TIME_ELAPSED);
+    m_pendingCount++;
+    m_timing = false;
+}
+
+void DynamicResolution::addSample(float milliseconds)
+{
+    // Measured at the scale before the last change
+    if (m_ignoredSamples > 0)
+    {
+        m_ignoredSamples--;
+        return;
+    }
+    
+    if (!m_hasSample)
+        m_gpuMilliseconds = milliseconds;
+    else
+        m_gpuMilliseconds += (milliseconds - m_gpuMilliseconds) * SMOOTHING;
+    m_hasSample = true;
+    
+    if (!m_enabled)
+        return;
+    
+    if (m_gpuMilliseconds > m_targetMilliseconds * OVER_BUDGET)
+    {
+        m_overBudgetFrames++;
+        m_underBudgetFrames = 0;
+    }
+    else if (m_gpuMilliseconds < m_targetMilliseconds * UNDER_BUDGET)
+    {
+        m_underBudgetFrames++;
+        m_overBudgetFrames = 0;
+    }
+    else
+    {
+        m_overBudgetFrames = 0;
+        m_underBudgetFrames = 0;
+    }
+    
+    if (m_overBudgetFrames >= DOWN_SAMPLES && m_scale > m_minScale)
+    {
+        // Fragment cost follows the pixel count, the square of the scale:
+        // aim for the middle of the band, at least one step down
+        float wanted = m_targetMilliseconds * (OVER_BUDGET + UNDER_BUDGET) * 0.5f;
+        float scale = m_scale * std::sqrt(wanted / m_gpuMilliseconds);
+        setScale(std::min(scale, m_scale - SCALE_STEP));
+    }
+    else if (m_underBudgetFrames >= UP_SAMPLES && m_scale < m_maxScale)
+    {
+        setScale(m_scale + SCALE_STEP);
+    }
+}
+
+void DynamicResolution::setScale(float scale)
+{
+    // Whole steps only, so the frame graph sees a handful of target sizes
+    scale = std::round(scale / SCALE_STEP) * SCALE_STEP;
+    scale = std::clamp(scale, m_minScale, m_maxScale);
+    if (scale == m_scale)
+        return;
+    
+    m_scale = scale;
+    m_overBudgetFrames = 0;
+    m_underBudgetFrames = 0;
+    m_hasSample = false;
+    m_ignoredSamples = m_pendingCount + (m_timing ? 1 : 0);
+}
+
+void DynamicResolution::getRenderSize(int width, int height, int& renderWidth, int& renderHeight) const
+{
+    float scale = isScaling() ? m_scale : 1.0f;
+    renderWidth = std::max(1, (int)std::lround(width * scale));
+    renderHeight = std::max(1, (int)std::lround(height * scale));
+}
+
+bool DynamicResolution::isScaling() const
+{
+    return m_enabled && m_scale < 1.0f && ShaderManager::getInstance().isProgramReady(m_shaderHandle);
+}
+
+void DynamicResolution::upscale(GLuint texture)
+{
+    if (!initialize())
+        return;
+    
+    GLuint program = ShaderManager::getInstance().getProgram(m_shaderHandle);
+    GLState& state = GLState::getInstance();
+    state.setEnabled(GL_DEPTH_TEST, false);
+    state.setEnabled(GL_CULL_FACE, false);
+    state.useProgram(program);
+    glUniform1i(glGetUniformLocation(program, "sceneColor"), 0);
+    
+    state.bindTexture(0, GL_TEXTURE_2D, texture);
+    glBindSampler(0, m_sampler);
+    state.bindVertexArray(m_vertexArray);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    glBindSampler(0, 0);
+    
+    // The pooled texture is a render target again next frame, it can't stay bound for sampling
+    state.bindTexture(0, GL_TEXTURE_2D, 0);
+    
+    RenderStats& stats = RenderStats::getInstance();
+    stats.countUniforms(1);
+    stats.countDraw(3);
+}
+
+void DynamicResolution::setEnabled(bool enabled)
+{
+    if (enabled == m_enabled)
+        return;
+    
+    // Start over from full quality either way
+    m_enabled = enabled;
+    m_scale = m_maxScale;
+    m_overBudgetFrames = 0;
+    m_underBudgetFrames = 0;
+}
+
+void DynamicResolution::setTargetMilliseconds(float milliseconds)
+{
+    m_targetMilliseconds = std::max(milliseconds, 1.0f);
+    m_overBudgetFrames = 0;
+    m_underBudgetFrames = 0;
+}
+
+void DynamicResolution::setScaleRange(float minScale, float maxScale)
+{
+    m_minScale = std::clamp(minScale, LOWEST_SCALE, 1.0f);
+    m_maxScale = std::clamp(maxScale, m_minScale, 1.0f);
+    m_scale = std::clamp(m_scale, m_minScale, m_maxScale);
+}
+
+void DynamicResolution::cleanup()
+{
+    if (!m_initialized)
+        return;
+    
+    // An open query can't be deleted cleanly
+    endTiming();
+    glDeleteQueries(QUERY_COUNT, m_queries);
+    GLState::getInstance().deleteVertexArrays(1, &m_vertexArray);
+    glDeleteSamplers(1, &m_sampler);
+    m_vertexArray = 0;
+    m_sampler = 0;
+    m_firstPending = 0;
+    m_pendingCount = 0;
+    m_initialized = false;
+}
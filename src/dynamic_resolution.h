@@ -0,0 +1,98 @@
+#pragma once
+
+// Silence OpenGL deprecation warnings on macOS
+#define GL_SILENCE_DEPRECATION
+
+#include <string>
+#include <cstdint>
+
+#include "shader_manager.h"
+
+#if defined(__APPLE__)
+    #include <OpenGL/gl3.h>
+#else
+    #include <SDL3/SDL_opengl.h>
+#endif
+
+// Scales the 3D scene's render resolution to hold a GPU frame-time budget.
+// Each frame's GPU work is timed with GL_TIME_ELAPSED queries that are read
+// a few frames later without stalling. The scale drops quickly once frames
+// stay over budget and climbs back slowly once they stay well under it; the
+// band in between changes nothing, so the resolution doesn't oscillate.
+// The scene is rendered at the scaled size and upscale() stretches it to the
+// backbuffer with bilinear filtering. GL thread only.
+class DynamicResolution
+{
+public:
+    static constexpr int QUERY_COUNT = 4;           // timer queries in flight
+    static constexpr float SCALE_STEP = 0.05f;      // scales are multiples of this
+    
+    // Shader paths of the fullscreen upscale program
+    DynamicResolution(const std::string& vertexShaderPath, const std::string& fragmentShaderPath);
+    ~DynamicResolution();
+    
+    // Delete copy constructor and assignment operator
+    DynamicResolution(const DynamicResolution&) = delete;
+    DynamicResolution& operator=(const DynamicResolution&) = delete;
+    
+    // Collect finished timings and adjust the scale, once per frame before
+    // the render size is used
+    void update();
+    
+    // Bracket the GPU work of a frame (skipped while every query is in flight)
+    void beginTiming();
+    void endTiming();
+    
+    // Size to render the scene at for a width x height backbuffer
+    void getRenderSize(int width, int height, int& renderWidth, int& renderHeight) const;
+    
+    // Whether the scene goes through an offscreen target and upscale()
+    bool isScaling() const;
+    
+    // Draw texture over the bound target's viewport (GL thread, upscale program ready)
+    void upscale(GLuint texture);
+    
+    // Controller settings
+    void setEnabled(bool enabled);
+    bool isEnabled() const { return m_enabled; }
+    void setTargetMilliseconds(float milliseconds);
+    float getTargetMilliseconds() const { return m_targetMilliseconds; }
+    void setScaleRange(float minScale, float maxScale);
+    float getMinScale() const { return m_minScale; }
+    float getMaxScale() const { return m_maxScale; }
+    
+    // Statistics
+    float getScale() const { return m_scale; }
+    float getGpuMilliseconds() const { return m_gpuMilliseconds; }
+    bool hasTimerResults() const { return m_hasSample; }
+    
+    // Release queries and GL objects (call before the GL context goes away)
+    void cleanup();
+    
+private:
+    bool initialize();
+    void addSample(float milliseconds);
+    void setScale(float scale);
+    
+    ShaderHandle m_shaderHandle;
+    
+    bool m_initialized;
+    GLuint m_queries[QUERY_COUNT];
+    int m_firstPending;
+    int m_pendingCount;
+    bool m_timing;                  // a query is open this frame
+    GLuint m_vertexArray;           // empty, the fullscreen triangle comes from gl_VertexID
+    GLuint m_sampler;               // bilinear, leaves the pooled textures' own filtering alone
+    
+    // Controller
+    bool m_enabled;
+    float m_targetMilliseconds;
+    float m_minScale;
+    float m_maxScale;
+    float m_scale;
+    float m_gpuMilliseconds;        // smoothed
+    bool m_hasSample;
+    int m_overBudgetFrames;
+    int m_underBudgetFrames;
+    int m_ignoredSamples;           // samples still measuring the previous scale
+};
@@ -0,0 +1,76 @@
+#include "frame_arena.h"
+#include <algorithm>
+
+FrameArena& FrameArena::getInstance()
+{
+    static FrameArena instance;
+    return instance;
+}
+
+FrameArena::FrameArena(size_t initialCapacity)
+    : m_offset(0)
+    , m_usedBefore(0)
+    , m_peakBytes(0)
+{
+    m_blocks.reserve(8);
+    m_blocks.push_back({std::make_unique_for_overwrite<uint8_t[]>(initialCapacity), initialCapacity});
+}
+
+void* FrameArena::allocate(size_t size, size_t alignment)
+{
+    Block& block = m_blocks.back();
+    uintptr_t base = reinterpret_cast<uintptr_t>(block.data.get());
+    uintptr_t aligned = (base + m_offset + alignment - 1) & ~(uintptr_t)(alignment - 1);
+    size_t end = (size_t)(aligned - base) + size;
+    
+    if (end > block.size)
+    {
+        grow(size, alignment);
+        return allocate(size, alignment);
+    }
+    
+    m_offset = end;
+    m_peakBytes = std::max(m_peakBytes, getBytesUsed());
+    return reinterpret_cast<void*>(aligned);
+}
+
+void FrameArena::deallocate(void* pointer, size_t size)
+{
+    // Only the newest allocation can be given back
+    uint8_t* bytes = static_cast<uint8_t*>(pointer);
+    Block& block = m_blocks.back();
+    if (bytes + size == block.data.get() + m_offset)
+        m_offset = (size_t)(bytes - block.data.get());
+}
+
+void FrameArena::grow(size_t size, size_t alignment)
+{
+    // At least double, so a frame needs few extra blocks
+    size_t blockSize = std::max(m_blocks.back().size * 2, size + alignment);
+    m_usedBefore += m_offset;
+    m_offset = 0;
+    m_blocks.push_back({std::make_unique_for_overwrite<uint8_t[]>(blockSize), blockSize});
+}
+
+void FrameArena::reset()
+{
+    // Merge overflow into a single block sized for the whole frame
+    if (m_blocks.size() > 1)
+    {
+        size_t capacity = getCapacity();
+        m_blocks.clear();
+        m_blocks.push_back({std::make_unique_for_overwrite<uint8_t[]>(capacity), capacity});
+    }
+    m_offset = 0;
+    m_usedBefore = 0;
+}
+
+size_t FrameArena::getCapacity() const
+{
+    size_t capacity = 0;
+    for (const Block& block : m_blocks)
+    {
+        capacity += block.size;
+    }
+    return capacity;
+}
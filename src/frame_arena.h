@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Linear allocator for data that lives until the end of the frame. Allocation
+// is a pointer bump, deallocation is a no-op except for the most recent
+// allocation (so growing vectors reuse their space). reset() releases
+// everything at once; if the frame overflowed the first block, the blocks are
+// merged into one big enough for that frame, so steady-state frames never
+// touch the heap. Not thread safe: one arena per thread.
+class FrameArena
+{
+public:
+    // Arena of the main (GL) thread, reset by the main loop at frame end
+    static FrameArena& getInstance();
+    
+    explicit FrameArena(size_t initialCapacity = 256 * 1024);
+    ~FrameArena() = default;
+    
+    // Delete copy constructor and assignment operator
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+    
+    void* allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+    void deallocate(void* pointer, size_t size);
+    
+    // Release all allocations made since the last reset
+    void reset();
+    
+    // Statistics
+    size_t getBytesUsed() const { return m_usedBefore + m_offset; }
+    size_t getCapacity() const;
+    size_t getPeakBytes() const { return m_peakBytes; }
+    
+private:
+    struct Block
+    {
+        std::unique_ptr<uint8_t[]> data;
+        size_t size;
+    };
+    
+    // Start a new block holding at least size bytes at the given alignment
+    void grow(size_t size, size_t alignment);
+    
+    std::vector<Block> m_blocks;    // the last block is the one being filled
+    size_t m_offset;                // bump offset in the last block
+    size_t m_usedBefore;            // bytes used in the earlier (full) blocks
+    size_t m_peakBytes;
+};
+
+// Standard allocator drawing from a FrameArena (the main thread's by default).
+// Containers using it must not outlive the frame.
+template<typename T>
+class FrameAllocator
+{
+public:
+    using value_type = T;
+    
+    FrameAllocator() noexcept : m_arena(&FrameArena::getInstance()) {}
+    explicit FrameAllocator(FrameArena& arena) noexcept : m_arena(&arena) {}
+    template<typename U>
+    FrameAllocator(const FrameAllocator<U>& other) noexcept : m_arena(other.getArena()) {}
+    
+    T* allocate(size_t count)
+    {
+        return static_cast<T*>(m_arena->allocate(count * sizeof(T), alignof(T)));
+    }
+    void deallocate(T* pointer, size_t count) noexcept
+    {
+        m_arena->deallocate(pointer, count * sizeof(T));
+    }
+    
+    FrameArena* getArena() const { return m_arena; }
+    
+    template<typename U>
+    bool operator==(const FrameAllocator<U>& other) const { return m_arena == other.getArena(); }
+    
+private:
+    FrameArena* m_arena;
+};
+
+template<typename T>
+using FrameVector = std::vector<T, FrameAllocator<T>>;
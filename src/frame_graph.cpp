@@ -0,0 +1,505 @@
+// Silence OpenGL deprecation warnings on macOS
+#define GL_SILENCE_DEPRECATION
+
+#include "frame_graph.h"
+#include "gl_state.h"
+
+#include <SDL3/SDL.h>
+#include <algorithm>
+
+namespace
+{
+    // Pooled textures and framebuffers unused for this many frames are released
+    const uint64_t KEEP_FRAMES = 120;
+    
+    // Pixel transfer format of a sized internal format, for allocation and clears
+    struct FormatInfo
+    {
+        GLenum format;
+        GLenum type;
+        int bytesPerPixel;
+        bool depth;
+        bool integer;
+    };
+    
+    FormatInfo getFormatInfo(GLenum internalFormat)
+    {
+        switch (internalFormat)
+        {
+            case GL_RGBA16F:            return {GL_RGBA, GL_HALF_FLOAT, 8, false, false};
+            case GL_RGBA32F:            return {GL_RGBA, GL_FLOAT, 16, false, false};
+            case GL_R11F_G11F_B10F:     return {GL_RGB, GL_FLOAT, 4, false, false};
+            case GL_R32F:               return {GL_RED, GL_FLOAT, 4, false, false};
+            case GL_R32UI:              return {GL_RED_INTEGER, GL_UNSIGNED_INT, 4, false, true};
+            case GL_RG32UI:             return {GL_RG_INTEGER, GL_UNSIGNED_INT, 8, false, true};
+            case GL_DEPTH_COMPONENT24:  return {GL_DEPTH_COMPONENT, GL_UNSIGNED_INT, 4, true, false};
+            case GL_DEPTH_COMPONENT32F: return {GL_DEPTH_COMPONENT, GL_FLOAT, 4, true, false};
+            case GL_DEPTH24_STENCIL8:   return {GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8, 4, true, false};
+            default:                    return {GL_RGBA, GL_UNSIGNED_BYTE, 4, false, false};
+        }
+    }
+}
+
+void FrameGraphBuilder::read(FrameGraphResource resource)
+{
+    m_graph.addAccess(m_pass, resource, false);
+}
+
+void FrameGraphBuilder::write(FrameGraphResource resource)
+{
+    m_graph.addAccess(m_pass, resource, true);
+}
+
+void FrameGraphBuilder::setSideEffect()
+{
+    m_graph.m_passes[m_pass].sideEffect = true;
+}
+
+FrameGraph::FrameGraph()
+    : m_frame(0)
+    , m_executedCount(0)
+    , m_transientCount(0)
+{
+}
+
+FrameGraph::~FrameGraph()
+{
+    cleanup();
+}
+
+void FrameGraph::reset()
+{
+    // Keeps the allocations, steady-state frames don't touch the heap
+    m_resources.clear();
+    m_accesses.clear();
+    m_passes.clear();
+    m_order.clear();
+}
+
+FrameGraphResource FrameGraph::createTexture(const char* name, const FrameGraphTextureDesc& desc)
+{
+    Resource resource;
+    resource.name = name;
+    resource.desc = desc;
+    m_resources.push_back(resource);
+    return (FrameGraphResource)m_resources.size() - 1;
+}
+
+FrameGraphResource FrameGraph::importBackbuffer(const char* name, int width, int height)
+{
+    Resource resource;
+    resource.name = name;
+    resource.desc.width = width;
+    resource.desc.height = height;
+    resource.imported = true;
+    m_resources.push_back(resource);
+    return (FrameGraphResource)m_resources.size() - 1;
+}
+
+int FrameGraph::beginPass(const char* name)
+{
+    if ((int)m_passes.size() >= MAX_PASSES)
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_RENDER, "Frame graph: too many passes, dropping %s", name);
+        return -1;
+    }
+    
+    Pass pass;
+    pass.name = name;
+    m_passes.push_back(pass);
+    return (int)m_passes.size() - 1;
+}
+
+void FrameGraph::addAccess(int pass, FrameGraphResource resource, bool write)
+{
+    if (resource < 0 || resource >= (int)m_resources.size())
+        return;
+    m_accesses.push_back({pass, resource, write});
+}
+
+GLuint FrameGraph::getTexture(FrameGraphResource resource) const
+{
+    if (resource < 0 || resource >= (int)m_resources.size() || m_resources[resource].texture < 0)
+        return 0;
+    return m_pool[m_resources[resource].texture].texture;
+}
+
+void FrameGraph::buildDependencies()
+{
+    // Per resource: passes writing it (read-modify-write counts as a write)
+    // and passes only reading it
+    FrameVector<uint64_t> writers(m_resources.size(), 0);
+    FrameVector<uint64_t> readers(m_resources.size(), 0);
+    for (const Access& access : m_accesses)
+    {
+        uint64_t bit = 1ull << access.pass;
+        if (access.write)
+            writers[access.resource] |= bit;
+        else
+            readers[access.resource] |= bit;
+    }
+    
+    for (size_t r = 0; r < m_resources.size(); ++r)
+    {
+        readers[r] &= ~writers[r];
+        
+        // Writes in declaration order, every read after the last write
+        int previousWriter = -1;
+        for (int p = 0; p < (int)m_passes.size(); ++p)
+        {
+            uint64_t bit = 1ull << p;
+            if (writers[r] & bit)
+            {
+                if (previousWriter >= 0)
+                    m_passes[p].dependencies |= 1ull << previousWriter;
+                previousWriter = p;
+            }
+            else if (readers[r] & bit)
+            {
+                m_passes[p].dependencies |= writers[r];
+            }
+        }
+    }
+}
+
+bool FrameGraph::sortPasses()
+{
+    // Kahn's algorithm, the earliest declared ready pass goes first
+    uint64_t scheduled = 0;
+    for (size_t step = 0; step < m_passes.size(); ++step)
+    {
+        int next = -1;
+        for (int p = 0; p < (int)m_passes.size(); ++p)
+        {
+            if (!(scheduled & (1ull << p)) && (m_passes[p].dependencies & ~scheduled) == 0)
+            {
+                next = p;
+                break;
+            }
+        }
+        if (next < 0)
+            return false;
+        
+        scheduled |= 1ull << next;
+        m_order.push_back(next);
+    }
+    return true;
+}
+
+void FrameGraph::cullPasses()
+{
+    // Passes with visible output seed the walk, everything they depend on is needed
+    uint64_t needed = 0;
+    for (const Access& access : m_accesses)
+    {
+        if (access.write && m_resources[access.resource].imported)
+            needed |= 1ull << access.pass;
+    }
+    for (int i = (int)m_order.size() - 1; i >= 0; --i)
+    {
+        Pass& pass = m_passes[m_order[i]];
+        pass.kept = pass.sideEffect || (needed & (1ull << m_order[i])) != 0;
+        if (pass.kept)
+            needed |= pass.dependencies;
+    }
+    
+    m_order.erase(std::remove_if(m_order.begin(), m_order.end(), [this](int p)
+    {
+        return !m_passes[p].kept;
+    }), m_order.end());
+}
+
+void FrameGraph::allocateTextures()
+{
+    // Lifetimes as positions in the execution order
+    for (int position = 0; position < (int)m_order.size(); ++position)
+    {
+        for (const Access& access : m_accesses)
+        {
+            if (access.pass != m_order[position])
+                continue;
+            Resource& resource = m_resources[access.resource];
+            if (resource.firstUse < 0)
+                resource.firstUse = position;
+            resource.lastUse = position;
+        }
+    }
+    
+    // Give each transient a pooled texture that is free by its first use
+    for (PooledTexture& texture : m_pool)
+        texture.busyUntil = -1;
+    
+    m_transientCount = 0;
+    for (int position = 0; position < (int)m_order.size(); ++position)
+    {
+        for (Resource& resource : m_resources)
+        {
+            if (resource.imported || resource.firstUse != position)
+                continue;
+            
+            int found = -1;
+            for (int i = 0; i < (int)m_pool.size(); ++i)
+            {
+                if (m_pool[i].desc == resource.desc && m_pool[i].busyUntil < position)
+                {
+                    found = i;
+                    break;
+                }
+            }
+            if (found < 0)
+            {
+                FormatInfo info = getFormatInfo(resource.desc.internalFormat);
+                PooledTexture texture;
+                texture.desc = resource.desc;
+                glGenTextures(1, &texture.texture);
+                GLState::getInstance().bindTexture(0, GL_TEXTURE_2D, texture.texture);
+                glTexImage2D(GL_TEXTURE_2D, 0, resource.desc.internalFormat, resource.desc.width, resource.desc.height,
+                             0, info.format, info.type, nullptr);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+                GLState::getInstance().bindTexture(0, GL_TEXTURE_2D, 0);
+                m_pool.push_back(texture);
+                found = (int)m_pool.size() - 1;
+            }
+            
+            m_pool[found].busyUntil = resource.lastUse;
+            m_pool[found].lastUsedFrame = m_frame;
+            resource.texture = found;
+            m_transientCount++;
+        }
+    }
+}
+
+GLuint FrameGraph::getFramebuffer(const GLuint* colors, int colorCount, GLuint depth)
+{
+    GLuint key[4] = {0, 0, 0, 0};
+    std::copy(colors, colors + colorCount, key);
+    for (CachedFramebuffer& cached : m_framebuffers)
+    {
+        if (std::equal(key, key + 4, cached.colors) && cached.depth == depth)
+        {
+            cached.lastUsedFrame = m_frame;
+            return cached.framebuffer;
+        }
+    }
+    
+    CachedFramebuffer cached;
+    std::copy(key, key + 4, cached.colors);
+    cached.depth = depth;
+    cached.lastUsedFrame = m_frame;
+    glGenFramebuffers(1, &cached.framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, cached.framebuffer);
+    
+    GLenum drawBuffers[4];
+    for (int i = 0; i < colorCount; ++i)
+    {
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, GL_TEXTURE_2D, colors[i], 0);
+        drawBuffers[i] = GL_COLOR_ATTACHMENT0 + i;
+    }
+    if (colorCount > 0)
+        glDrawBuffers(colorCount, drawBuffers);
+    else
+        glDrawBuffer(GL_NONE);
+    
+    if (depth != 0)
+    {
+        // The depth texture's format decides whether stencil comes along
+        GLenum attachment = GL_DEPTH_ATTACHMENT;
+        for (const PooledTexture& texture : m_pool)
+        {
+            if (texture.texture == depth && texture.desc.internalFormat == GL_DEPTH24_STENCIL8)
+                attachment = GL_DEPTH_STENCIL_ATTACHMENT;
+        }
+        glFramebufferTexture2D(GL_FRAMEBUFFER, attachment, GL_TEXTURE_2D, depth, 0);
+    }
+    
+    GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    if (status != GL_FRAMEBUFFER_COMPLETE)
+        SDL_LogError(SDL_LOG_CATEGORY_RENDER, "Frame graph: incomplete framebuffer (0x%x)", status);
+    
+    m_framebuffers.push_back(cached);
+    return cached.framebuffer;
+}
+
+void FrameGraph::bindTargets(int position)
+{
+    int pass = m_order[position];
+    
+    GLuint colors[4];
+    int colorCount = 0;
+    GLuint depth = 0;
+    const Resource* backbuffer = nullptr;
+    const Resource* sizeSource = nullptr;
+    for (const Access& access : m_accesses)
+    {
+        if (access.pass != pass || !access.write)
+            continue;
+        
+        const Resource& resource = m_resources[access.resource];
+        if (resource.imported)
+        {
+            backbuffer = &resource;
+            continue;
+        }
+        
+        GLuint texture = m_pool[resource.texture].texture;
+        if (getFormatInfo(resource.desc.internalFormat).depth)
+            depth = texture;
+        else if (colorCount < 4)
+            colors[colorCount++] = texture;
+        sizeSource = &resource;
+    }
+    
+    // Passes without outputs (CPU work, readbacks of earlier targets) keep the current target
+    if (backbuffer)
+    {
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glViewport(0, 0, backbuffer->desc.width, backbuffer->desc.height);
+        return;
+    }
+    if (!sizeSource)
+        return;
+    
+    glBindFramebuffer(GL_FRAMEBUFFER, getFramebuffer(colors, colorCount, depth));
+    glViewport(0, 0, sizeSource->desc.width, sizeSource->desc.height);
+    
+    // First writer clears: the texture holds whatever aliased it before
+    int colorIndex = 0;
+    for (const Access& access : m_accesses)
+    {
+        if (access.pass != pass || !access.write)
+            continue;
+        
+        const Resource& resource = m_resources[access.resource];
+        FormatInfo info = getFormatInfo(resource.desc.internalFormat);
+        bool firstWrite = resource.firstUse == position;
+        if (info.depth)
+        {
+            if (firstWrite)
+            {
+                const GLfloat one = 1.0f;
+                GLState::getInstance().depthMask(true);
+                glClearBufferfv(GL_DEPTH, 0, &one);
+            }
+            continue;
+        }
+        if (colorIndex >= 4)
+            continue;
+        if (firstWrite && info.integer)
+        {
+            const GLuint zero[4] = {0, 0, 0, 0};
+            glClearBufferuiv(GL_COLOR, colorIndex, zero);
+        }
+        else if (firstWrite)
+        {
+            const GLfloat zero[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+            glClearBufferfv(GL_COLOR, colorIndex, zero);
+        }
+        colorIndex++;
+    }
+}
+
+void FrameGraph::execute()
+{
+    m_frame++;
+    m_order.clear();
+    
+    buildDependencies();
+    if (!sortPasses())
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_RENDER, "Frame graph: dependency cycle, running passes in declaration order");
+        m_order.clear();
+        for (int p = 0; p < (int)m_passes.size(); ++p)
+            m_order.push_back(p);
+    }
+    cullPasses();
+    allocateTextures();
+    
+    for (int position = 0; position < (int)m_order.size(); ++position)
+    {
+        const Pass& pass = m_passes[m_order[position]];
+        bindTargets(position);
+        if (pass.execute)
+            pass.execute(pass.context, *this);
+        
+        // Back to the baseline state every pass starts from, only what the
+        // pass changed reaches GL; bindings stay for the next pass to reuse
+        GLState& state = GLState::getInstance();
+        state.depthMask(true);
+        state.depthFunc(GL_LESS);
+        state.colorMask(true);
+        state.setEnabled(GL_DEPTH_TEST, true);
+        state.setEnabled(GL_CULL_FACE, true);
+        state.cullFace(GL_BACK);
+        state.frontFace(GL_CCW);
+        state.setEnabled(GL_BLEND, false);
+        state.setEnabled(GL_SCISSOR_TEST, false);
+        state.validate(pass.name);
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    m_executedCount = (int)m_order.size();
+    
+    releaseUnused();
+}
+
+void FrameGraph::releaseUnused()
+{
+    // Framebuffers go first, they may reference the textures below
+    for (auto it = m_framebuffers.begin(); it != m_framebuffers.end();)
+    {
+        bool stale = m_frame - it->lastUsedFrame > KEEP_FRAMES;
+        for (const PooledTexture& texture : m_pool)
+        {
+            if (m_frame - texture.lastUsedFrame > KEEP_FRAMES &&
+                (texture.texture == it->depth || std::find(it->colors, it->colors + 4, texture.texture) != it->colors + 4))
+                stale = true;
+        }
+        if (stale)
+        {
+            glDeleteFramebuffers(1, &it->framebuffer);
+            it = m_framebuffers.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+    
+    // E.g. targets of the old size after a resize
+    for (auto it = m_pool.begin(); it != m_pool.end();)
+    {
+        if (m_frame - it->lastUsedFrame > KEEP_FRAMES)
+        {
+            GLState::getInstance().deleteTextures(1, &it->texture);
+            it = m_pool.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
+
+size_t FrameGraph::getPooledTextureBytes() const
+{
+    size_t bytes = 0;
+    for (const PooledTexture& texture : m_pool)
+    {
+        bytes += (size_t)texture.desc.width * texture.desc.height *
+                 getFormatInfo(texture.desc.internalFormat).bytesPerPixel;
+    }
+    return bytes;
+}
+
+void FrameGraph::cleanup()
+{
+    for (CachedFramebuffer& cached : m_framebuffers)
+        glDeleteFramebuffers(1, &cached.framebuffer);
+    m_framebuffers.clear();
+    for (PooledTexture& texture : m_pool)
+        GLState::getInstance().deleteTextures(1, &texture.texture);
+    m_pool.clear();
+    reset();
+}
@@ -0,0 +1,197 @@
+#pragma once
+
+// Silence OpenGL deprecation warnings on macOS
+#define GL_SILENCE_DEPRECATION
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "frame_arena.h"
+
+#if defined(__APPLE__)
+    #include <OpenGL/gl3.h>
+#else
+    #include <SDL3/SDL_opengl.h>
+#endif
+
+// Resource of the current frame's graph
+using FrameGraphResource = int;
+constexpr FrameGraphResource INVALID_FRAME_GRAPH_RESOURCE = -1;
+
+// Transient 2D texture, internalFormat is a sized format (GL_RGBA8, GL_R32UI,
+// GL_DEPTH_COMPONENT24, ...)
+struct FrameGraphTextureDesc
+{
+    int width = 0;
+    int height = 0;
+    GLenum internalFormat = GL_RGBA8;
+    
+    bool operator==(const FrameGraphTextureDesc&) const = default;
+};
+
+class FrameGraph;
+
+// Declares what a pass reads and writes while it is added
+class FrameGraphBuilder
+{
+public:
+    void read(FrameGraphResource resource);
+    void write(FrameGraphResource resource);
+    
+    // Keep the pass even when nothing reads its output (e.g. a readback)
+    void setSideEffect();
+    
+private:
+    friend class FrameGraph;
+    
+    FrameGraphBuilder(FrameGraph& graph, int pass) : m_graph(graph), m_pass(pass) {}
+    
+    FrameGraph& m_graph;
+    int m_pass;
+};
+
+// Per-frame graph of render passes. Passes declare the resources they read
+// and write; execute() culls passes whose output nobody uses, orders the rest
+// so every write of a resource runs before its reads, places transient
+// textures in pooled textures (textures whose lifetimes don't overlap share
+// one), binds each pass's framebuffer and resets GL state after it. Transient
+// textures are cleared by their first writer, their previous contents belong
+// to whatever aliased them. Rebuild the graph every frame: reset(), declare,
+// execute(). GL thread only.
+class FrameGraph
+{
+public:
+    static constexpr int MAX_PASSES = 64;
+    
+    FrameGraph();
+    ~FrameGraph();
+    
+    // Delete copy constructor and assignment operator
+    FrameGraph(const FrameGraph&) = delete;
+    FrameGraph& operator=(const FrameGraph&) = delete;
+    
+    // Start declaring a new frame
+    void reset();
+    
+    // Texture that only lives within this frame
+    FrameGraphResource createTexture(const char* name, const FrameGraphTextureDesc& desc);
+    
+    // The default framebuffer (color and depth), never culled or aliased
+    FrameGraphResource importBackbuffer(const char* name, int width, int height);
+    
+    // setup(builder) runs now, execute(graph) during execute(). execute is
+    // kept in the frame arena and never destroyed, so it may only capture
+    // references and trivially destructible values.
+    template<typename SetupFn, typename ExecuteFn>
+    void addPass(const char* name, SetupFn&& setup, ExecuteFn&& execute)
+    {
+        using Callable = std::decay_t<ExecuteFn>;
+        static_assert(std::is_trivially_destructible_v<Callable>,
+                      "pass execute functions are never destroyed");
+        
+        int pass = beginPass(name);
+        if (pass < 0)
+            return;
+        FrameGraphBuilder builder(*this, pass);
+        setup(builder);
+        
+        void* storage = FrameArena::getInstance().allocate(sizeof(Callable), alignof(Callable));
+        m_passes[pass].context = new (storage) Callable(std::forward<ExecuteFn>(execute));
+        m_passes[pass].execute = [](void* context, const FrameGraph& graph)
+        {
+            (*static_cast<Callable*>(context))(graph);
+        };
+    }
+    
+    // Cull, order, allocate and run the declared passes
+    void execute();
+    
+    // Texture backing a transient resource (valid inside execute functions)
+    GLuint getTexture(FrameGraphResource resource) const;
+    
+    // Statistics of the last execute()
+    int getPassCount() const { return (int)m_passes.size(); }
+    int getExecutedCount() const { return m_executedCount; }
+    int getTransientCount() const { return m_transientCount; }
+    int getPooledTextureCount() const { return (int)m_pool.size(); }
+    size_t getPooledTextureBytes() const;
+    
+    // Release pooled textures and framebuffers (before the GL context goes away)
+    void cleanup();
+    
+private:
+    friend class FrameGraphBuilder;
+    
+    using ExecuteFunction = void (*)(void* context, const FrameGraph& graph);
+    
+    struct Resource
+    {
+        const char* name = nullptr;
+        FrameGraphTextureDesc desc;
+        bool imported = false;
+        int texture = -1;       // index into m_pool
+        int firstUse = -1;      // positions in the execution order
+        int lastUse = -1;
+    };
+    
+    struct Access
+    {
+        int pass;
+        FrameGraphResource resource;
+        bool write;
+    };
+    
+    struct Pass
+    {
+        const char* name = nullptr;
+        ExecuteFunction execute = nullptr;
+        void* context = nullptr;
+        uint64_t dependencies = 0;  // passes that must run first
+        bool sideEffect = false;
+        bool kept = false;
+    };
+    
+    // Pooled texture, reused across frames and shared by aliased resources
+    struct PooledTexture
+    {
+        GLuint texture = 0;
+        FrameGraphTextureDesc desc;
+        int busyUntil = -1;         // position of the last pass using it this frame
+        uint64_t lastUsedFrame = 0;
+    };
+    
+    // Framebuffer for one combination of attachments
+    struct CachedFramebuffer
+    {
+        GLuint framebuffer = 0;
+        GLuint colors[4] = {0, 0, 0, 0};
+        GLuint depth = 0;
+        uint64_t lastUsedFrame = 0;
+    };
+    
+    int beginPass(const char* name);
+    void addAccess(int pass, FrameGraphResource resource, bool write);
+    void buildDependencies();
+    bool sortPasses();
+    void cullPasses();
+    void allocateTextures();
+    void bindTargets(int position);
+    void releaseUnused();
+    GLuint getFramebuffer(const GLuint* colors, int colorCount, GLuint depth);
+    
+    std::vector<Resource> m_resources;
+    std::vector<Access> m_accesses;
+    std::vector<Pass> m_passes;
+    std::vector<int> m_order;
+    
+    std::vector<PooledTexture> m_pool;
+    std::vector<CachedFramebuffer> m_framebuffers;
+    uint64_t m_frame;
+    
+    int m_executedCount;
+    int m_transientCount;
+};
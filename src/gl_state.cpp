@@ -0,0 +1,352 @@
+// Silence OpenGL deprecation warnings on macOS
+#define GL_SILENCE_DEPRECATION
+
+#include "gl_state.h"
+#include "render_stats.h"
+
+#include <SDL3/SDL.h>
+
+GLState& GLState::getInstance()
+{
+    static thread_local GLState instance;
+    return instance;
+}
+
+GLState::GLState()
+    : m_validation(false)
+    , m_mismatchCount(0)
+    , m_skippedCount(0)
+{
+    invalidate();
+}
+
+int GLState::getBufferSlot(GLenum target)
+{
+    switch (target)
+    {
+        case GL_ARRAY_BUFFER: return ARRAY_BUFFER_SLOT;
+        case GL_TEXTURE_BUFFER: return TEXTURE_BUFFER_SLOT;
+        case GL_PIXEL_PACK_BUFFER: return PIXEL_PACK_BUFFER_SLOT;
+        default: return -1;
+    }
+}
+
+int GLState::getTextureSlot(GLenum target)
+{
+    switch (target)
+    {
+        case GL_TEXTURE_2D: return TEXTURE_2D_SLOT;
+        case GL_TEXTURE_2D_ARRAY: return TEXTURE_2D_ARRAY_SLOT;
+        case GL_TEXTURE_BUFFER: return TEXTURE_BUFFER_TEXTURE_SLOT;
+        default: return -1;
+    }
+}
+
+int GLState::getCapabilitySlot(GLenum capability)
+{
+    switch (capability)
+    {
+        case GL_DEPTH_TEST: return DEPTH_TEST_SLOT;
+        case GL_CULL_FACE: return CULL_FACE_SLOT;
+        case GL_BLEND: return BLEND_SLOT;
+        case GL_SCISSOR_TEST: return SCISSOR_TEST_SLOT;
+        default: return -1;
+    }
+}
+
+void GLState::useProgram(GLuint program)
+{
+    if (m_program == (int64_t)program)
+    {
+        m_skippedCount++;
+        return;
+    }
+    m_program = program;
+    glUseProgram(program);
+    if (program != 0)
+        RenderStats::getInstance().countProgramBind();
+}
+
+void GLState::bindVertexArray(GLuint vertexArray)
+{
+    if (m_vertexArray == (int64_t)vertexArray)
+    {
+        m_skippedCount++;
+        return;
+    }
+    m_vertexArray = vertexArray;
+    glBindVertexArray(vertexArray);
+    if (vertexArray != 0)
+        RenderStats::getInstance().countVertexArrayBind();
+}
+
+void GLState::bindBuffer(GLenum target, GLuint buffer)
+{
+    // The element array binding is VAO state, always passed through
+    int slot = getBufferSlot(target);
+    if (slot < 0)
+    {
+        glBindBuffer(target, buffer);
+        return;
+    }
+    if (m_buffers[slot] == (int64_t)buffer)
+    {
+        m_skippedCount++;
+        return;
+    }
+    m_buffers[slot] = buffer;
+    glBindBuffer(target, buffer);
+}
+
+void GLState::activeTexture(int unit)
+{
+    if (m_activeUnit == unit)
+    {
+        m_skippedCount++;
+        return;
+    }
+    m_activeUnit = unit;
+    glActiveTexture(GL_TEXTURE0 + unit);
+}
+
+void GLState::bindTexture(int unit, GLenum target, GLuint texture)
+{
+    int slot = getTextureSlot(target);
+    if (slot < 0 || unit >= TEXTURE_UNITS)
+    {
+        activeTexture(unit);
+        glBindTexture(target, texture);
+        return;
+    }
+    if (m_textures[unit][slot] == (int64_t)texture)
+    {
+        m_skippedCount++;
+        return;
+    }
+    activeTexture(unit);
+    m_textures[unit][slot] = texture;
+    glBindTexture(target, texture);
+}
+
+void GLState::setEnabled(GLenum capability, bool enabled)
+{
+    int slot = getCapabilitySlot(capability);
+    if (slot >= 0 && m_capabilities[slot] == (int64_t)enabled)
+    {
+        m_skippedCount++;
+        return;
+    }
+    if (slot >= 0)
+        m_capabilities[slot] = enabled;
+    if (enabled)
+        glEnable(capability);
+    else
+        glDisable(capability);
+}
+
+void GLState::depthMask(bool write)
+{
+    if (m_depthMask == (int64_t)write)
+    {
+        m_skippedCount++;
+        return;
+    }
+    m_depthMask = write;
+    glDepthMask(write ? GL_TRUE : GL_FALSE);
+}
+
+void GLState::depthFunc(GLenum function)
+{
+    if (m_depthFunc == (int64_t)function)
+    {
+        m_skippedCount++;
+        return;
+    }
+    m_depthFunc = function;
+    glDepthFunc(function);
+}
+
+void GLState::colorMask(bool write)
+{
+    if (m_colorMask == (int64_t)write)
+    {
+        m_skippedCount++;
+        return;
+    }
+    m_colorMask = write;
+    GLboolean value = write ? GL_TRUE : GL_FALSE;
+    glColorMask(value, value, value, value);
+}
+
+void GLState::blendFunc(GLenum source, GLenum destination)
+{
+    if (m_blendSource == (int64_t)source && m_blendDestination == (int64_t)destination)
+    {
+        m_skippedCount++;
+        return;
+    }
+    m_blendSource = source;
+    m_blendDestination = destination;
+    glBlendFunc(source, destination);
+}
+
+void GLState::cullFace(GLenum face)
+{
+    if (m_cullFace == (int64_t)face)
+    {
+        m_skippedCount++;
+        return;
+    }
+    m_cullFace = face;
+    glCullFace(face);
+}
+
+void GLState::frontFace(GLenum winding)
+{
+    if (m_frontFace == (int64_t)winding)
+    {
+        m_skippedCount++;
+        return;
+    }
+    m_frontFace = winding;
+    glFrontFace(winding);
+}
+
+void GLState::deleteVertexArrays(GLsizei count, const GLuint* vertexArrays)
+{
+    for (GLsizei i = 0; i < count; ++i)
+    {
+        if (vertexArrays[i] != 0 && m_vertexArray == (int64_t)vertexArrays[i])
+            m_vertexArray = 0;
+    }
+    glDeleteVertexArrays(count, vertexArrays);
+}
+
+void GLState::deleteBuffers(GLsizei count, const GLuint* buffers)
+{
+    for (GLsizei i = 0; i < count; ++i)
+    {
+        for (int64_t& bound : m_buffers)
+        {
+            if (buffers[i] != 0 && bound == (int64_t)buffers[i])
+                bound = 0;
+        }
+    }
+    glDeleteBuffers(count, buffers);
+}
+
+void GLState::deleteTextures(GLsizei count, const GLuint* textures)
+{
+    for (GLsizei i = 0; i < count; ++i)
+    {
+        for (auto& unit : m_textures)
+        {
+            for (int64_t& bound : unit)
+            {
+                if (textures[i] != 0 && bound == (int64_t)textures[i])
+                    bound = 0;
+            }
+        }
+    }
+    glDeleteTextures(count, textures);
+}
+
+void GLState::invalidate()
+{
+    m_program = UNKNOWN;
+    m_vertexArray = UNKNOWN;
+    for (int64_t& bound : m_buffers)
+        bound = UNKNOWN;
+    m_activeUnit = UNKNOWN;
+    for (auto& unit : m_textures)
+    {
+        for (int64_t& bound : unit)
+            bound = UNKNOWN;
+    }
+    for (int64_t& enabled : m_capabilities)
+        enabled = UNKNOWN;
+    m_depthMask = UNKNOWN;
+    m_depthFunc = UNKNOWN;
+    m_colorMask = UNKNOWN;
+    m_blendSource = UNKNOWN;
+    m_blendDestination = UNKNOWN;
+    m_cullFace = UNKNOWN;
+    m_frontFace = UNKNOWN;
+}
+
+void GLState::check(const char* where, const char* what, int64_t& cached, int64_t actual)
+{
+    if (cached == UNKNOWN || cached == actual)
+        return;
+    
+    SDL_LogError(SDL_LOG_CATEGORY_RENDER, "GL state after %s: %s cached as %lld, actually %lld",
+                 where, what, (long long)cached, (long long)actual);
+    cached = actual;
+    m_mismatchCount++;
+}
+
+bool GLState::validate(const char* where)
+{
+    if (!m_validation)
+        return true;
+    
+    int mismatches = m_mismatchCount;
+    GLint value = 0;
+    
+    glGetIntegerv(GL_CURRENT_PROGRAM, &value);
+    check(where, "program", m_program, value);
+    glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &value);
+    check(where, "vertex array", m_vertexArray, value);
+    glGetIntegerv(GL_ARRAY_BUFFER_BINDING, &value);
+    check(where, "array buffer", m_buffers[ARRAY_BUFFER_SLOT], value);
+    glGetIntegerv(GL_TEXTURE_BUFFER, &value);
+    check(where, "texture buffer", m_buffers[TEXTURE_BUFFER_SLOT], value);
+    glGetIntegerv(GL_PIXEL_PACK_BUFFER_BINDING, &value);
+    check(where, "pixel pack buffer", m_buffers[PIXEL_PACK_BUFFER_SLOT], value);
+    
+    // Texture bindings are per unit, visited through the active unit
+    GLint activeUnit = 0;
+    glGetIntegerv(GL_ACTIVE_TEXTURE, &activeUnit);
+    activeUnit -= GL_TEXTURE0;
+    check(where, "active texture unit", m_activeUnit, activeUnit);
+    for (int unit = 0; unit < TEXTURE_UNITS; ++unit)
+    {
+        glActiveTexture(GL_TEXTURE0 + unit);
+        glGetIntegerv(GL_TEXTURE_BINDING_2D, &value);
+        check(where, "2D texture", m_textures[unit][TEXTURE_2D_SLOT], value);
+        glGetIntegerv(GL_TEXTURE_BINDING_2D_ARRAY, &value);
+        check(where, "2D array texture", m_textures[unit][TEXTURE_2D_ARRAY_SLOT], value);
+        glGetIntegerv(GL_TEXTURE_BINDING_BUFFER, &value);
+        check(where, "buffer texture", m_textures[unit][TEXTURE_BUFFER_TEXTURE_SLOT], value);
+    }
+    glActiveTexture(GL_TEXTURE0 + activeUnit);
+    
+    check(where, "depth test", m_capabilities[DEPTH_TEST_SLOT], glIsEnabled(GL_DEPTH_TEST));
+    check(where, "face culling", m_capabilities[CULL_FACE_SLOT], glIsEnabled(GL_CULL_FACE));
+    check(where, "blending", m_capabilities[BLEND_SLOT], glIsEnabled(GL_BLEND));
+    check(where, "scissor test", m_capabilities[SCISSOR_TEST_SLOT], glIsEnabled(GL_SCISSOR_TEST));
+    
+    GLboolean flags[4] = {GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE};
+    glGetBooleanv(GL_DEPTH_WRITEMASK, flags);
+    check(where, "depth mask", m_depthMask, flags[0] != GL_FALSE);
+    glGetIntegerv(GL_DEPTH_FUNC, &value);
+    check(where, "depth function", m_depthFunc, value);
+    glGetBooleanv(GL_COLOR_WRITEMASK, flags);
+    check(where, "color mask", m_colorMask, flags[0] != GL_FALSE);
+    
+    // glBlendFunc sets the color and alpha factors alike
+    glGetIntegerv(GL_BLEND_SRC_RGB, &value);
+    check(where, "blend source", m_blendSource, value);
+    glGetIntegerv(GL_BLEND_SRC_ALPHA, &value);
+    check(where, "blend alpha source", m_blendSource, value);
+    glGetIntegerv(GL_BLEND_DST_RGB, &value);
+    check(where, "blend destination", m_blendDestination, value);
+    glGetIntegerv(GL_BLEND_DST_ALPHA, &value);
+    check(where, "blend alpha destination", m_blendDestination, value);
+    glGetIntegerv(GL_CULL_FACE_MODE, &value);
+    check(where, "culled face", m_cullFace, value);
+    glGetIntegerv(GL_FRONT_FACE, &value);
+    check(where, "front face", m_frontFace, value);
+    
+    return m_mismatchCount == mismatches;
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+// Silence OpenGL deprecation warnings on macOS
+#define GL_SILENCE_DEPRECATION
+
+#include <cstdint>
+
+#if defined(__APPLE__)
+    #include <OpenGL/gl3.h>
+#else
+    #include <SDL3/SDL_opengl.h>
+#endif
+
+// Shadow copy of the GL state the renderer changes: program, VAO, buffer
+// and texture bindings, active texture unit, depth/cull/blend/scissor
+// enables, the blend function, culled face, front face winding and the depth
+// and color masks. Each setter only calls GL when the
+// value differs from the cached one, so consecutive draws with the same
+// program or VAO cost nothing and nothing has to be unbound after a draw.
+//
+// Every change of cached state on a context must go through its GLState,
+// otherwise the cache goes stale; deleting objects goes through it too, as
+// GL unbinds deleted names. The element array binding belongs to the VAO
+// and is passed straight through. Code that changes state behind the cache's
+// back (and doesn't restore it, like the ImGui backend does) calls
+// invalidate() afterwards. With validation on, validate() compares the cache
+// against glGet queries, logs differences and adopts the real values.
+class GLState
+{
+public:
+    static constexpr int TEXTURE_UNITS = 16;    // units tracked, higher ones pass through
+    
+    // State of the calling thread's context; every GL thread here owns exactly one
+    static GLState& getInstance();
+    
+    // Delete copy constructor and assignment operator
+    GLState(const GLState&) = delete;
+    GLState& operator=(const GLState&) = delete;
+    
+    // Bindings
+    void useProgram(GLuint program);
+    void bindVertexArray(GLuint vertexArray);
+    void bindBuffer(GLenum target, GLuint buffer);
+    void activeTexture(int unit);
+    void bindTexture(int unit, GLenum target, GLuint texture);
+    
+    // Fixed-function state
+    void setEnabled(GLenum capability, bool enabled);
+    void depthMask(bool write);
+    void depthFunc(GLenum function);
+    void colorMask(bool write);
+    void blendFunc(GLenum source, GLenum destination);
+    void cullFace(GLenum face);
+    void frontFace(GLenum winding);
+    
+    // Delete objects, dropping them from the cache like GL drops their bindings
+    void deleteVertexArrays(GLsizei count, const GLuint* vertexArrays);
+    void deleteBuffers(GLsizei count, const GLuint* buffers);
+    void deleteTextures(GLsizei count, const GLuint* textures);
+    
+    // Forget everything, the next setter of each state calls GL again
+    void invalidate();
+    
+    // Debug validation against glGet, true when the cache was right
+    void setValidation(bool enabled) { m_validation = enabled; }
+    bool isValidating() const { return m_validation; }
+    bool validate(const char* where);
+    int getMismatchCount() const { return m_mismatchCount; }
+    
+    // Statistics: calls skipped since startup
+    uint64_t getSkippedCount() const { return m_skippedCount; }
+    
+private:
+    GLState();
+    ~GLState() = default;
+    
+    enum BufferTarget { ARRAY_BUFFER_SLOT = 0, TEXTURE_BUFFER_SLOT, PIXEL_PACK_BUFFER_SLOT, BUFFER_SLOT_COUNT };
+    enum TextureTarget { TEXTURE_2D_SLOT = 0, TEXTURE_2D_ARRAY_SLOT, TEXTURE_BUFFER_TEXTURE_SLOT, TEXTURE_SLOT_COUNT };
+    enum Capability { DEPTH_TEST_SLOT = 0, CULL_FACE_SLOT, BLEND_SLOT, SCISSOR_TEST_SLOT, CAPABILITY_SLOT_COUNT };
+    
+    static int getBufferSlot(GLenum target);
+    static int getTextureSlot(GLenum target);
+    static int getCapabilitySlot(GLenum capability);
+    
+    // Compare one cached value with GL's, adopting GL's on a mismatch
+    void check(const char* where, const char* what, int64_t& cached, int64_t actual);
+    
+    // Cached values, UNKNOWN until first set
+    static constexpr int64_t UNKNOWN = -1;
+    int64_t m_program;
+    int64_t m_vertexArray;
+    int64_t m_buffers[BUFFER_SLOT_COUNT];
+    int64_t m_activeUnit;
+    int64_t m_textures[TEXTURE_UNITS][TEXTURE_SLOT_COUNT];
+    int64_t m_capabilities[CAPABILITY_SLOT_COUNT];
+    int64_t m_depthMask;
+    int64_t m_depthFunc;
+    int64_t m_colorMask;
+    int64_t m_blendSource;
+    int64_t m_blendDestination;
+    int64_t m_cullFace;
+    int64_t m_frontFace;
+    
+    bool m_validation;
+    int m_mismatchCount;
+    uint64_t m_skippedCount;
+};
@@ -0,0 +1,178 @@
+// Silence OpenGL deprecation warnings on macOS
+#define GL_SILENCE_DEPRECATION
+
+#include "gpu_picker.h"
+#include "gl_state.h"
+#include "libs/maths/matrix.h"
+
+#include <algorithm>
+#include <cmath>
+
+GpuPicker::GpuPicker(const std::string& vertexShaderPath, const std::string& fragmentShaderPath)
+    : m_shaderHandle(INVALID_SHADER_HANDLE)
+    , m_instancedShaderHandle(INVALID_SHADER_HANDLE)
+    , m_initialized(false)
+    , m_firstPending(0)
+    , m_pendingCount(0)
+    , m_tolerance(0)
+{
+    ShaderManager& shaderManager = ShaderManager::getInstance();
+    m_shaderHandle = shaderManager.requestShaderProgram(vertexShaderPath, fragmentShaderPath);
+    m_instancedShaderHandle = shaderManager.requestShaderProgram(
+        vertexShaderPath, fragmentShaderPath, { SHADER_DEFINE_INSTANCED });
+}
+
+GpuPicker::~GpuPicker()
+{
+    cleanup();
+}
+
+bool GpuPicker::isReady() const
+{
+    return ShaderManager::getInstance().isProgramReady(m_shaderHandle);
+}
+
+void GpuPicker::setTolerance(int pixels)
+{
+    m_tolerance = std::clamp(pixels, 0, MAX_TOLERANCE);
+}
+
+bool GpuPicker::initialize()
+{
+    GLState& state = GLState::getInstance();
+    if (m_initialized)
+        return true;
+    
+    // Readback targets, written by the GPU and mapped once the fence signals
+    for (Slot& slot : m_slots)
+    {
+        glGenBuffers(1, &slot.pixelBuffer);
+        state.bindBuffer(GL_PIXEL_PACK_BUFFER, slot.pixelBuffer);
+        glBufferData(GL_PIXEL_PACK_BUFFER, REGION_SIZE * REGION_SIZE * sizeof(uint32_t), nullptr, GL_STREAM_READ);
+    }
+    state.bindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    
+    m_initialized = true;
+    return true;
+}
+
+bool GpuPicker::canPick() const
+{
+    return isReady() && m_pendingCount < MAX_PENDING;
+}
+
+void GpuPicker::renderPick(const RenderQueue& queue, float x, float y, int width, int height,
+                           const float* viewMatrix, const float* projectionMatrix)
+{
+    GLState& state = GLState::getInstance();
+    if (!canPick() || width <= 0 || height <= 0 || !initialize())
+        return;
+    
+    ShaderManager& shaderManager = ShaderManager::getInstance();
+    GLuint program = shaderManager.getProgram(m_shaderHandle);
+    GLuint instancedProgram = shaderManager.isProgramReady(m_instancedShaderHandle)
+        ? shaderManager.getProgram(m_instancedShaderHandle) : 0;
+    
+    // Scale and shift clip space so the REGION_SIZE pixels centered on the
+    // cursor's pixel fill the whole target
+    float centerX = 2.0f * (std::floor(x) + 0.5f) / width - 1.0f;
+    float centerY = 1.0f - 2.0f * (std::floor(y) + 0.5f) / height;
+    float scaleX = (float)width / REGION_SIZE;
+    float scaleY = (float)height / REGION_SIZE;
+    float regionMatrix[16] = {
+        scaleX, 0.0f, 0.0f, 0.0f,
+        0.0f, scaleY, 0.0f, 0.0f,
+        0.0f, 0.0f, 1.0f, 0.0f,
+        -centerX * scaleX, -centerY * scaleY, 0.0f, 1.0f
+    };
+    float regionProjection[16];
+    multiplyMatrix(regionProjection, regionMatrix, projectionMatrix);
+    
+    // Draw IDs into the small target
+    queue.renderIds(program, instancedProgram, viewMatrix, regionProjection);
+    
+    // Copy into the slot's buffer, returns without waiting for the GPU
+    Slot& slot = m_slots[(m_firstPending + m_pendingCount) % MAX_PENDING];
+    state.bindBuffer(GL_PIXEL_PACK_BUFFER, slot.pixelBuffer);
+    glReadBuffer(GL_COLOR_ATTACHMENT0);
+    glReadPixels(0, 0, REGION_SIZE, REGION_SIZE, GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+    state.bindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    slot.tolerance = m_tolerance;
+    m_pendingCount++;
+}
+
+bool GpuPicker::pollResult(uint32_t& id)
+{
+    if (m_pendingCount == 0)
+        return false;
+    
+    // Zero timeout: only asks whether the copy is done
+    Slot& slot = m_slots[m_firstPending];
+    GLenum state = glClientWaitSync(slot.fence, 0, 0);
+    if (state == GL_TIMEOUT_EXPIRED)
+        return false;
+    
+    glDeleteSync(slot.fence);
+    slot.fence = nullptr;
+    m_firstPending = (m_firstPending + 1) % MAX_PENDING;
+    m_pendingCount--;
+    
+    id = 0;
+    if (state == GL_WAIT_FAILED)
+        return true;
+    
+    GLState::getInstance().bindBuffer(GL_PIXEL_PACK_BUFFER, slot.pixelBuffer);
+    const void* pixels = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, REGION_SIZE * REGION_SIZE * sizeof(uint32_t),
+                                          GL_MAP_READ_BIT);
+    if (pixels)
+    {
+        id = findNearestId(static_cast<const uint32_t*>(pixels), slot.tolerance);
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    GLState::getInstance().bindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    return true;
+}
+
+uint32_t GpuPicker::findNearestId(const uint32_t* ids, int tolerance) const
+{
+    // The cursor's pixel wins, otherwise the closest object pixel within tolerance
+    uint32_t centerId = ids[MAX_TOLERANCE * REGION_SIZE + MAX_TOLERANCE];
+    if (centerId != 0 || tolerance == 0)
+        return centerId;
+    
+    uint32_t nearestId = 0;
+    int nearestDistance = tolerance * tolerance + 1;
+    for (int dy = -tolerance; dy <= tolerance; dy++)
+    {
+        for (int dx = -tolerance; dx <= tolerance; dx++)
+        {
+            uint32_t id = ids[(MAX_TOLERANCE + dy) * REGION_SIZE + MAX_TOLERANCE + dx];
+            int distance = dx * dx + dy * dy;
+            if (id != 0 && distance < nearestDistance)
+            {
+                nearestId = id;
+                nearestDistance = distance;
+            }
+        }
+    }
+    return nearestId;
+}
+
+void GpuPicker::cleanup()
+{
+    GLState& state = GLState::getInstance();
+    if (!m_initialized)
+        return;
+    
+    for (Slot& slot : m_slots)
+    {
+        if (slot.fence)
+            glDeleteSync(slot.fence);
+        state.deleteBuffers(1, &slot.pixelBuffer);
+        slot = Slot{};
+    }
+    m_firstPending = 0;
+    m_pendingCount = 0;
+    m_initialized = false;
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+// Silence OpenGL deprecation warnings on macOS
+#define GL_SILENCE_DEPRECATION
+
+#include <string>
+#include <cstdint>
+
+#include "shader_manager.h"
+#include "render_queue.h"
+
+#if defined(__APPLE__)
+    #include <OpenGL/gl3.h>
+#else
+    #include <SDL3/SDL_opengl.h>
+#endif
+
+// Pixel-exact picking from an object ID buffer. A pick renders the queue's
+// pickIds for a small square around the cursor into an offscreen R32UI
+// target (provided by the frame graph) and starts an asynchronous readback
+// into a pixel buffer object.
+// The result is collected a frame or two later once the fence has signaled,
+// so the CPU never waits in glReadPixels.
+class GpuPicker
+{
+public:
+    static constexpr int MAX_TOLERANCE = 4;                     // pixels around the cursor
+    static constexpr int REGION_SIZE = MAX_TOLERANCE * 2 + 1;   // side of the rendered square
+    static constexpr int MAX_PENDING = 3;                       // picks in flight
+    
+    // Shader paths of the position-only vertex shader and the ID fragment shader
+    GpuPicker(const std::string& vertexShaderPath, const std::string& fragmentShaderPath);
+    ~GpuPicker();
+    
+    // Delete copy constructor and assignment operator
+    GpuPicker(const GpuPicker&) = delete;
+    GpuPicker& operator=(const GpuPicker&) = delete;
+    
+    // Whether the ID program has finished compiling
+    bool isReady() const;
+    
+    // Pixels around the cursor searched when the cursor itself hits the
+    // background (0 = exact, up to MAX_TOLERANCE)
+    void setTolerance(int pixels);
+    int getTolerance() const { return m_tolerance; }
+    
+    // Whether a pick can start now (program ready and a readback slot free)
+    bool canPick() const;
+    
+    // Render IDs around (x, y) of a width x height window into the bound
+    // target and start reading them back (GL thread). The target must be a
+    // REGION_SIZE square R32UI color plus depth, cleared, viewport set.
+    void renderPick(const RenderQueue& queue, float x, float y, int width, int height,
+                    const float* viewMatrix, const float* projectionMatrix);
+    
+    // Oldest finished pick, true with the ID under the cursor (0 = background).
+    // Never blocks, call once per frame.
+    bool pollResult(uint32_t& id);
+    
+    bool hasPending() const { return m_pendingCount > 0; }
+    
+    // Release the readback buffers (call before the GL context goes away)
+    void cleanup();
+    
+private:
+    // One readback in flight
+    struct Slot
+    {
+        GLuint pixelBuffer = 0;
+        GLsync fence = nullptr;
+        int tolerance = 0;
+    };
+    
+    bool initialize();
+    uint32_t findNearestId(const uint32_t* ids, int tolerance) const;
+    
+    ShaderHandle m_shaderHandle;
+    ShaderHandle m_instancedShaderHandle;
+    
+    bool m_initialized;
+    
+    Slot m_slots[MAX_PENDING];
+    int m_firstPending;
+    int m_pendingCount;
+    int m_tolerance;
+};
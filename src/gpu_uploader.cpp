@@ -0,0 +1,233 @@
+// Silence OpenGL deprecation warnings on macOS
+#define GL_SILENCE_DEPRECATION
+
+#include "gpu_uploader.h"
+#include "gl_state.h"
+#include "render_stats.h"
+
+#include <memory>
+
+void UploadedMesh::release()
+{
+    GLState& state = GLState::getInstance();
+    state.deleteBuffers(1, &VBO);
+    state.deleteBuffers(1, &depthVBO);
+    state.deleteBuffers(1, &EBO);
+    VBO = 0;
+    depthVBO = 0;
+    EBO = 0;
+}
+
+GpuUploader& GpuUploader::getInstance()
+{
+    static GpuUploader instance;
+    return instance;
+}
+
+GpuUploader::GpuUploader()
+    : m_window(nullptr)
+    , m_context(nullptr)
+    , m_running(false)
+    , m_stopping(false)
+    , m_pendingCount(0)
+{
+}
+
+GpuUploader::~GpuUploader()
+{
+    stop();
+}
+
+bool GpuUploader::start(SDL_Window* window, SDL_GLContext mainContext)
+{
+    if (m_running)
+        return true;
+    
+    // The loader gets its own hidden window: some platforms (EGL) don't allow
+    // one surface to be current on two threads
+    m_window = SDL_CreateWindow("Loader", 1, 1, SDL_WINDOW_OPENGL | SDL_WINDOW_HIDDEN);
+    if (!m_window)
+    {
+        SDL_Log("Upload thread disabled, no loader window: %s", SDL_GetError());
+        return false;
+    }
+    
+    // Creating a context makes it current, switch back right after
+    SDL_GL_SetAttribute(SDL_GL_SHARE_WITH_CURRENT_CONTEXT, 1);
+    m_context = SDL_GL_CreateContext(m_window);
+    SDL_GL_SetAttribute(SDL_GL_SHARE_WITH_CURRENT_CONTEXT, 0);
+    SDL_GL_MakeCurrent(window, mainContext);
+    if (!m_context)
+    {
+        SDL_Log("Upload thread disabled, no shared context: %s", SDL_GetError());
+        SDL_DestroyWindow(m_window);
+        m_window = nullptr;
+        return false;
+    }
+    
+    // Wait until the loader has its context current (or failed to)
+    int state = 0;
+    std::mutex startMutex;
+    std::condition_variable started;
+    m_stopping = false;
+    m_thread = std::thread([this, &state, &startMutex, &started]()
+    {
+        bool current = SDL_GL_MakeCurrent(m_window, m_context);
+        {
+            std::lock_guard<std::mutex> lock(startMutex);
+            state = current ? 1 : -1;
+        }
+        started.notify_one();
+        if (current)
+            loaderLoop();
+    });
+    {
+        std::unique_lock<std::mutex> lock(startMutex);
+        started.wait(lock, [&state]() { return state != 0; });
+    }
+    
+    if (state < 0)
+    {
+        SDL_Log("Upload thread disabled, shared context can't be made current: %s", SDL_GetError());
+        m_thread.join();
+        SDL_GL_DestroyContext(m_context);
+        SDL_DestroyWindow(m_window);
+        m_context = nullptr;
+        m_window = nullptr;
+        return false;
+    }
+    
+    m_running = true;
+    SDL_Log("Upload thread started with a shared GL context");
+    return true;
+}
+
+void GpuUploader::stop()
+{
+    if (!m_running)
+        return;
+    
+    // The loader finishes its queue before it exits
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_condition.notify_one();
+    m_thread.join();
+    m_running = false;
+    
+    SDL_GL_DestroyContext(m_context);
+    SDL_DestroyWindow(m_window);
+    m_context = nullptr;
+    m_window = nullptr;
+    
+    // The loader finished on the GPU before it exited, every fence has signaled
+    processCompleted();
+}
+
+void GpuUploader::submit(UploadFunction upload, ReadyFunction ready)
+{
+    // Fallback: inline on the GL thread, usable at once
+    if (!m_running)
+    {
+        upload();
+        if (ready)
+            ready();
+        return;
+    }
+    
+    m_pendingCount++;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_jobs.push_back({std::move(upload), std::move(ready)});
+    }
+    m_condition.notify_one();
+}
+
+void GpuUploader::submitMesh(MeshData mesh, std::function<void(const UploadedMesh&)> ready)
+{
+    // Filled on the loader, read by ready on the GL thread after the fence
+    std::shared_ptr<UploadedMesh> uploaded = std::make_shared<UploadedMesh>();
+    std::shared_ptr<MeshData> data = std::make_shared<MeshData>(std::move(mesh));
+    submit([uploaded, data]()
+    {
+        uploaded->vertexCount = data->getVertexCount();
+        uploaded->indexCount = (int)data->indices.size();
+        
+        GLuint buffers[3];
+        glGenBuffers(3, buffers);
+        uploaded->VBO = buffers[0];
+        uploaded->depthVBO = buffers[1];
+        uploaded->EBO = buffers[2];
+        
+        // The element buffer binding isn't part of a VAO here, any target works for the data
+        // (the loader thread has its own GLState, its context's bindings are separate)
+        GLState& state = GLState::getInstance();
+        state.bindBuffer(GL_ARRAY_BUFFER, uploaded->VBO);
+        glBufferData(GL_ARRAY_BUFFER, data->vertices.size() * sizeof(float), data->vertices.data(), GL_STATIC_DRAW);
+        state.bindBuffer(GL_ARRAY_BUFFER, uploaded->depthVBO);
+        glBufferData(GL_ARRAY_BUFFER, data->positions.size() * sizeof(float), data->positions.data(), GL_STATIC_DRAW);
+        state.bindBuffer(GL_ARRAY_BUFFER, uploaded->EBO);
+        glBufferData(GL_ARRAY_BUFFER, data->indices.size() * sizeof(unsigned int), data->indices.data(), GL_STATIC_DRAW);
+        state.bindBuffer(GL_ARRAY_BUFFER, 0);
+        RenderStats::getInstance().countBufferUpload((data->vertices.size() + data->positions.size()) * sizeof(float) +
+                                                     data->indices.size() * sizeof(unsigned int));
+    }, [uploaded, ready = std::move(ready)]()
+    {
+        ready(*uploaded);
+    });
+}
+
+void GpuUploader::loaderLoop()
+{
+    while (true)
+    {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_condition.wait(lock, [this]() { return m_stopping || !m_jobs.empty(); });
+            if (m_jobs.empty())
+                break;
+            job = std::move(m_jobs.front());
+            m_jobs.pop_front();
+        }
+        
+        job.upload();
+        
+        // Flush so the fence reaches the GPU, the main context polls it
+        Completion completion;
+        completion.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        completion.ready = std::move(job.ready);
+        glFlush();
+        m_completed.push(std::move(completion));
+    }
+    
+    // Complete all uploads before the context goes away
+    glFinish();
+    SDL_GL_MakeCurrent(m_window, nullptr);
+}
+
+void GpuUploader::processCompleted()
+{
+    Completion completion;
+    while (m_completed.pop(completion))
+    {
+        m_waiting.push_back(std::move(completion));
+    }
+    
+    // In submission order, stop at the first upload still in flight
+    while (!m_waiting.empty())
+    {
+        Completion& front = m_waiting.front();
+        GLenum state = glClientWaitSync(front.fence, 0, 0);
+        if (state == GL_TIMEOUT_EXPIRED)
+            break;
+        
+        glDeleteSync(front.fence);
+        ReadyFunction ready = std::move(front.ready);
+        m_waiting.pop_front();
+        m_pendingCount--;
+        if (ready)
+            ready();
+    }
+}
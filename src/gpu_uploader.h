@@ -0,0 +1,114 @@
+#pragma once
+
+// Silence OpenGL deprecation warnings on macOS
+#define GL_SILENCE_DEPRECATION
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#include <SDL3/SDL.h>
+
+#include "mesh_builder.h"
+#include "mpsc_queue.h"
+
+#if defined(__APPLE__)
+    #include <OpenGL/gl3.h>
+#else
+    #include <SDL3/SDL_opengl.h>
+#endif
+
+// Buffers of a mesh uploaded by GpuUploader, owned by whoever receives them
+struct UploadedMesh
+{
+    GLuint VBO = 0;
+    GLuint depthVBO = 0;
+    GLuint EBO = 0;
+    int vertexCount = 0;
+    int indexCount = 0;
+    
+    // Delete the buffers (GL thread, for results nobody wants anymore)
+    void release();
+};
+
+// Uploads GPU resources from a loader thread with its own GL context that
+// shares objects with the main one, so large glBufferData / glTexImage calls
+// don't cost the main thread frame time. Each upload ends with a fence; the
+// main thread hands the result over only once the fence has signaled. Only
+// shareable objects (buffers, textures) may be created on the loader, VAOs and
+// framebuffers must be made on the main context. Without a shared context
+// (start() failed or was never called) uploads run inline on the GL thread.
+class GpuUploader
+{
+public:
+    using UploadFunction = std::function<void()>;
+    using ReadyFunction = std::function<void()>;
+    
+    // Get singleton instance
+    static GpuUploader& getInstance();
+    
+    // Delete copy constructor and assignment operator
+    GpuUploader(const GpuUploader&) = delete;
+    GpuUploader& operator=(const GpuUploader&) = delete;
+    
+    // Create the shared context and start the loader thread (main thread,
+    // with mainContext current). False when sharing isn't available.
+    bool start(SDL_Window* window, SDL_GLContext mainContext);
+    
+    // Finish outstanding uploads and stop the thread (before the main context goes away)
+    void stop();
+    
+    // Whether uploads run on the loader thread
+    bool isThreaded() const { return m_running; }
+    
+    // Run upload with a current GL context, then ready on the GL thread once
+    // the GPU may use the result. Without the loader both run right away.
+    void submit(UploadFunction upload, ReadyFunction ready);
+    
+    // Upload a mesh into new buffers, ready receives them on the GL thread
+    void submitMesh(MeshData mesh, std::function<void(const UploadedMesh&)> ready);
+    
+    // GL thread, once per frame: hand over uploads whose fence has signaled
+    void processCompleted();
+    
+    // Uploads submitted but not handed over yet
+    int getPendingCount() const { return m_pendingCount.load(); }
+    
+private:
+    // Finished upload waiting for its fence
+    struct Completion
+    {
+        GLsync fence = nullptr;
+        ReadyFunction ready;
+    };
+    
+    struct Job
+    {
+        UploadFunction upload;
+        ReadyFunction ready;
+    };
+    
+    GpuUploader();
+    ~GpuUploader();
+    
+    void loaderLoop();
+    
+    SDL_Window* m_window;           // hidden window the loader context draws to
+    SDL_GLContext m_context;
+    std::thread m_thread;
+    bool m_running;
+    
+    // Jobs for the loader thread
+    std::deque<Job> m_jobs;
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    bool m_stopping;
+    
+    // Loader thread to GL thread, in submission order
+    MpscQueue<Completion> m_completed;
+    std::deque<Completion> m_waiting;   // popped, fence not signaled yet (GL thread)
+    std::atomic<int> m_pendingCount;
+};
@@ -0,0 +1,75 @@
+#include "heap_counter.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#if defined(_WIN32)
+    #include <malloc.h>
+#endif
+
+// Replacements of the global allocation functions that count calls. The
+// array and nothrow forms call these by default, so they are counted too.
+
+namespace
+{
+    std::atomic<uint64_t> g_allocationCount{0};
+    
+    void* allocateAligned(std::size_t size, std::size_t alignment)
+    {
+        if (size == 0)
+            size = 1;
+#if defined(_WIN32)
+        return _aligned_malloc(size, alignment);
+#else
+        // aligned_alloc wants the size to be a multiple of the alignment
+        return std::aligned_alloc(alignment, (size + alignment - 1) & ~(alignment - 1));
+#endif
+    }
+}
+
+uint64_t getHeapAllocationCount()
+{
+    return g_allocationCount.load(std::memory_order_relaxed);
+}
+
+void* operator new(std::size_t size)
+{
+    g_allocationCount.fetch_add(1, std::memory_order_relaxed);
+    void* pointer = std::malloc(size != 0 ? size : 1);
+    if (!pointer)
+        throw std::bad_alloc();
+    return pointer;
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+    g_allocationCount.fetch_add(1, std::memory_order_relaxed);
+    void* pointer = allocateAligned(size, (std::size_t)alignment);
+    if (!pointer)
+        throw std::bad_alloc();
+    return pointer;
+}
+
+void operator delete(void* pointer) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, std::align_val_t) noexcept
+{
+#if defined(_WIN32)
+    _aligned_free(pointer);
+#else
+    std::free(pointer);
+#endif
+}
+
+void operator delete(void* pointer, std::size_t, std::align_val_t alignment) noexcept
+{
+    operator delete(pointer, alignment);
+}
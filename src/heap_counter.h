@@ -0,0 +1,7 @@
+#pragma once
+
+#include <cstdint>
+
+// Number of global operator new calls since startup, on all threads.
+// Sampled once per frame to check that steady-state frames don't allocate.
+uint64_t getHeapAllocationCount();
@@ -0,0 +1,442 @@
+#include "input_trace.h"
+#include "atomic_file.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+namespace
+{
+    const uint32_t MAGIC = 0x54495347;  // "GSIT"
+    const uint32_t VERSION = 1;
+    
+    struct InputTraceHeader
+    {
+        uint32_t magic;
+        uint32_t version;
+        float fixedDelta;
+        int32_t windowWidth;    // logical size mouse coordinates refer to
+        int32_t windowHeight;
+        uint32_t frameCount;
+        uint32_t eventCount;
+        uint32_t reserved;
+    };
+    
+    enum TraceKind : uint8_t
+    {
+        TRACE_END = 0,
+        TRACE_KEY_DOWN,
+        TRACE_KEY_UP,
+        TRACE_TEXT,
+        TRACE_MOUSE_MOTION,
+        TRACE_MOUSE_DOWN,
+        TRACE_MOUSE_UP,
+        TRACE_MOUSE_WHEEL
+    };
+    
+    // Little-endian writers
+    void putVarint(std::vector<uint8_t>& data, uint32_t value)
+    {
+        while (value >= 0x80)
+        {
+            data.push_back((uint8_t)(value | 0x80));
+            value >>= 7;
+        }
+        data.push_back((uint8_t)value);
+    }
+    
+    void putU8(std::vector<uint8_t>& data, uint8_t value)
+    {
+        data.push_back(value);
+    }
+    
+    void putU16(std::vector<uint8_t>& data, uint16_t value)
+    {
+        data.push_back((uint8_t)value);
+        data.push_back((uint8_t)(value >> 8));
+    }
+    
+    void putU32(std::vector<uint8_t>& data, uint32_t value)
+    {
+        for (int i = 0; i < 4; ++i)
+            data.push_back((uint8_t)(value >> (i * 8)));
+    }
+    
+    void putFloat(std::vector<uint8_t>& data, float value)
+    {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        putU32(data, bits);
+    }
+    
+    // Bounds-checked reader, every get fails once the data ran out
+    class Reader
+    {
+    public:
+        Reader(const uint8_t* data, size_t size) : m_data(data), m_size(size), m_position(0), m_failed(false) {}
+        
+        bool failed() const { return m_failed; }
+        size_t getRemaining() const { return m_size - m_position; }
+        
+        uint32_t getVarint()
+        {
+            uint32_t value = 0;
+            for (int shift = 0; shift < 35; shift += 7)
+            {
+                uint8_t byte = getU8();
+                value |= (uint32_t)(byte & 0x7F) << shift;
+                if (!(byte & 0x80))
+                    return value;
+            }
+            m_failed = true;
+            return 0;
+        }
+        
+        uint8_t getU8()
+        {
+            if (m_position + 1 > m_size)
+            {
+                m_failed = true;
+                return 0;
+            }
+            return m_data[m_position++];
+        }
+        
+        uint16_t getU16()
+        {
+            uint16_t low = getU8();
+            return (uint16_t)(low | (getU8() << 8));
+        }
+        
+        uint32_t getU32()
+        {
+            uint32_t value = 0;
+            for (int i = 0; i < 4; ++i)
+                value |= (uint32_t)getU8() << (i * 8);
+            return value;
+        }
+        
+        float getFloat()
+        {
+            uint32_t bits = getU32();
+            float value;
+            std::memcpy(&value, &bits, sizeof(value));
+            return value;
+        }
+        
+        std::string getString(size_t length)
+        {
+            if (m_position + length > m_size)
+            {
+                m_failed = true;
+                return {};
+            }
+            std::string text(reinterpret_cast<const char*>(m_data + m_position), length);
+            m_position += length;
+            return text;
+        }
+        
+    private:
+        const uint8_t* m_data;
+        size_t m_size;
+        size_t m_position;
+        bool m_failed;
+    };
+    
+    // The header goes through the same little-endian helpers as the records
+    void putHeader(std::vector<uint8_t>& data, const InputTraceHeader& header)
+    {
+        putU32(data, header.magic);
+        putU32(data, header.version);
+        putFloat(data, header.fixedDelta);
+        putU32(data, (uint32_t)header.windowWidth);
+        putU32(data, (uint32_t)header.windowHeight);
+        putU32(data, header.frameCount);
+        putU32(data, header.eventCount);
+        putU32(data, header.reserved);
+    }
+    
+    InputTraceHeader getHeader(Reader& reader)
+    {
+        InputTraceHeader header;
+        header.magic = reader.getU32();
+        header.version = reader.getU32();
+        header.fixedDelta = reader.getFloat();
+        header.windowWidth = (int32_t)reader.getU32();
+        header.windowHeight = (int32_t)reader.getU32();
+        header.frameCount = reader.getU32();
+        header.eventCount = reader.getU32();
+        header.reserved = reader.getU32();
+        return header;
+    }
+}
+
+bool isTracedInputEvent(const SDL_Event& event)
+{
+    switch (event.type)
+    {
+        case SDL_EVENT_KEY_DOWN:
+        case SDL_EVENT_KEY_UP:
+        case SDL_EVENT_TEXT_INPUT:
+        case SDL_EVENT_MOUSE_MOTION:
+        case SDL_EVENT_MOUSE_BUTTON_DOWN:
+        case SDL_EVENT_MOUSE_BUTTON_UP:
+        case SDL_EVENT_MOUSE_WHEEL:
+            return true;
+        default:
+            return false;
+    }
+}
+
+InputRecorder::InputRecorder()
+    : m_windowWidth(0)
+    , m_windowHeight(0)
+    , m_lastFrame(0)
+    , m_eventCount(0)
+    , m_recording(false)
+{
+}
+
+void InputRecorder::start(const std::string& path, int windowWidth, int windowHeight)
+{
+    m_path = path;
+    m_data.clear();
+    m_windowWidth = windowWidth;
+    m_windowHeight = windowHeight;
+    m_lastFrame = 0;
+    m_eventCount = 0;
+    m_recording = true;
+}
+
+void InputRecorder::record(uint32_t frame, const SDL_Event& event)
+{
+    if (!m_recording || !isTracedInputEvent(event))
+        return;
+    
+    uint8_t kind;
+    switch (event.type)
+    {
+        case SDL_EVENT_KEY_DOWN:            kind = TRACE_KEY_DOWN; break;
+        case SDL_EVENT_KEY_UP:              kind = TRACE_KEY_UP; break;
+        case SDL_EVENT_TEXT_INPUT:          kind = TRACE_TEXT; break;
+        case SDL_EVENT_MOUSE_MOTION:        kind = TRACE_MOUSE_MOTION; break;
+        case SDL_EVENT_MOUSE_BUTTON_DOWN:   kind = TRACE_MOUSE_DOWN; break;
+        case SDL_EVENT_MOUSE_BUTTON_UP:     kind = TRACE_MOUSE_UP; break;
+        default:                            kind = TRACE_MOUSE_WHEEL; break;
+    }
+    
+    putVarint(m_data, frame - m_lastFrame);
+    putU8(m_data, kind);
+    m_lastFrame = frame;
+    m_eventCount++;
+    
+    switch (kind)
+    {
+        case TRACE_KEY_DOWN:
+        case TRACE_KEY_UP:
+            putU32(m_data, (uint32_t)event.key.key);
+            putU16(m_data, (uint16_t)event.key.scancode);
+            putU16(m_data, (uint16_t)event.key.mod);
+            putU8(m_data, event.key.repeat ? 1 : 0);
+            break;
+        case TRACE_TEXT:
+        {
+            size_t length = event.text.text ? std::strlen(event.text.text) : 0;
+            length = length < 255 ? length : 255;
+            putU8(m_data, (uint8_t)length);
+            m_data.insert(m_data.end(), event.text.text, event.text.text + length);
+            break;
+        }
+        case TRACE_MOUSE_MOTION:
+            putU32(m_data, (uint32_t)event.motion.state);
+            putFloat(m_data, event.motion.x);
+            putFloat(m_data, event.motion.y);
+            putFloat(m_data, event.motion.xrel);
+            putFloat(m_data, event.motion.yrel);
+            break;
+        case TRACE_MOUSE_DOWN:
+        case TRACE_MOUSE_UP:
+            putU8(m_data, event.button.button);
+            putU8(m_data, event.button.clicks);
+            putFloat(m_data, event.button.x);
+            putFloat(m_data, event.button.y);
+            break;
+        default:
+            putFloat(m_data, event.wheel.x);
+            putFloat(m_data, event.wheel.y);
+            putU8(m_data, (uint8_t)event.wheel.direction);
+            putFloat(m_data, event.wheel.mouse_x);
+            putFloat(m_data, event.wheel.mouse_y);
+            break;
+    }
+}
+
+bool InputRecorder::stop(uint32_t frameCount)
+{
+    if (!m_recording)
+        return false;
+    m_recording = false;
+    
+    // The end record marks the last frame even when it had no input
+    putVarint(m_data, frameCount > m_lastFrame ? frameCount - m_lastFrame : 0);
+    putU8(m_data, TRACE_END);
+    
+    InputTraceHeader header = {};
+    header.magic = MAGIC;
+    header.version = VERSION;
+    header.fixedDelta = INPUT_TRACE_FIXED_DELTA;
+    header.windowWidth = m_windowWidth;
+    header.windowHeight = m_windowHeight;
+    header.frameCount = frameCount;
+    header.eventCount = (uint32_t)m_eventCount;
+    
+    std::vector<uint8_t> bytes;
+    bytes.reserve(sizeof(header) + m_data.size());
+    putHeader(bytes, header);
+    bytes.insert(bytes.end(), m_data.begin(), m_data.end());
+    return writeFileAtomically(m_path, bytes);
+}
+
+InputReplayer::InputReplayer()
+    : m_nextEvent(0)
+    , m_frameCount(0)
+    , m_fixedDelta(INPUT_TRACE_FIXED_DELTA)
+    , m_windowWidth(0)
+    , m_windowHeight(0)
+    , m_loaded(false)
+{
+}
+
+bool InputReplayer::load(const std::string& path)
+{
+    m_loaded = false;
+    m_events.clear();
+    m_eventFrames.clear();
+    m_eventTexts.clear();
+    m_texts.clear();
+    m_nextEvent = 0;
+    
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open())
+        return false;
+    std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    
+    Reader reader(data.data(), data.size());
+    InputTraceHeader header = getHeader(reader);
+    if (reader.failed() || header.magic != MAGIC || header.version != VERSION || header.fixedDelta <= 0.0f ||
+        header.windowWidth <= 0 || header.windowHeight <= 0)
+        return false;
+    
+    // The header count is untrusted, an event takes at least 3 bytes (frame
+    // delta, kind and the shortest payload), which bounds what can really follow
+    size_t eventCount = std::min<size_t>(header.eventCount, reader.getRemaining() / 3);
+    m_events.reserve(eventCount);
+    m_eventFrames.reserve(eventCount);
+    m_eventTexts.reserve(eventCount);
+    
+    uint32_t frame = 0;
+    while (true)
+    {
+        frame += reader.getVarint();
+        uint8_t kind = reader.getU8();
+        if (reader.failed())
+            return false;
+        if (kind == TRACE_END)
+            break;
+        
+        SDL_Event event;
+        std::memset(&event, 0, sizeof(event));
+        int text = -1;
+        switch (kind)
+        {
+            case TRACE_KEY_DOWN:
+            case TRACE_KEY_UP:
+                event.type = (kind == TRACE_KEY_DOWN) ? SDL_EVENT_KEY_DOWN : SDL_EVENT_KEY_UP;
+                event.key.key = (SDL_Keycode)reader.getU32();
+                event.key.scancode = (SDL_Scancode)reader.getU16();
+                event.key.mod = (SDL_Keymod)reader.getU16();
+                event.key.repeat = reader.getU8() != 0;
+                event.key.down = (kind == TRACE_KEY_DOWN);
+                break;
+            case TRACE_TEXT:
+                event.type = SDL_EVENT_TEXT_INPUT;
+                m_texts.push_back(reader.getString(reader.getU8()));
+                text = (int)m_texts.size() - 1;
+                break;
+            case TRACE_MOUSE_MOTION:
+                event.type = SDL_EVENT_MOUSE_MOTION;
+                event.motion.state = (SDL_MouseButtonFlags)reader.getU32();
+                event.motion.x = reader.getFloat();
+                event.motion.y = reader.getFloat();
+                event.motion.xrel = reader.getFloat();
+                event.motion.yrel = reader.getFloat();
+                break;
+            case TRACE_MOUSE_DOWN:
+            case TRACE_MOUSE_UP:
+                event.type = (kind == TRACE_MOUSE_DOWN) ? SDL_EVENT_MOUSE_BUTTON_DOWN : SDL_EVENT_MOUSE_BUTTON_UP;
+                event.button.button = reader.getU8();
+                event.button.clicks = reader.getU8();
+                event.button.x = reader.getFloat();
+                event.button.y = reader.getFloat();
+                event.button.down = (kind == TRACE_MOUSE_DOWN);
+                break;
+            case TRACE_MOUSE_WHEEL:
+                event.type = SDL_EVENT_MOUSE_WHEEL;
+                event.wheel.x = reader.getFloat();
+                event.wheel.y = reader.getFloat();
+                event.wheel.direction = (SDL_MouseWheelDirection)reader.getU8();
+                event.wheel.mouse_x = reader.getFloat();
+                event.wheel.mouse_y = reader.getFloat();
+                break;
+            default:
+                return false;
+        }
+        if (reader.failed())
+            return false;
+        
+        m_events.push_back(event);
+        m_eventFrames.push_back(frame);
+        m_eventTexts.push_back(text);
+    }
+    
+    m_frameCount = header.frameCount;
+    m_fixedDelta = header.fixedDelta;
+    m_windowWidth = header.windowWidth;
+    m_windowHeight = header.windowHeight;
+    m_loaded = true;
+    return true;
+}
+
+void InputReplayer::getFrameEvents(uint32_t frame, SDL_WindowID windowID, std::vector<SDL_Event>& events)
+{
+    Uint64 timestamp = SDL_GetTicksNS();
+    while (m_nextEvent < m_events.size() && m_eventFrames[m_nextEvent] <= frame)
+    {
+        SDL_Event event = m_events[m_nextEvent];
+        event.common.timestamp = timestamp;
+        switch (event.type)
+        {
+            case SDL_EVENT_KEY_DOWN:
+            case SDL_EVENT_KEY_UP:
+                event.key.windowID = windowID;
+                break;
+            case SDL_EVENT_TEXT_INPUT:
+                event.text.windowID = windowID;
+                event.text.text = m_texts[m_eventTexts[m_nextEvent]].c_str();
+                break;
+            case SDL_EVENT_MOUSE_MOTION:
+                event.motion.windowID = windowID;
+                break;
+            case SDL_EVENT_MOUSE_BUTTON_DOWN:
+            case SDL_EVENT_MOUSE_BUTTON_UP:
+                event.button.windowID = windowID;
+                break;
+            default:
+                event.wheel.windowID = windowID;
+                break;
+        }
+        events.push_back(event);
+        m_nextEvent++;
+    }
+}
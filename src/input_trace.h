@@ -0,0 +1,83 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+#include <SDL3/SDL.h>
+
+// Input trace file, little-endian:
+//   InputTraceHeader
+//   records: varint frames since the previous record, uint8 kind, payload
+//   end record (kind 0) on the last frame
+// Only input is stored (keys, text, mouse); window size and the frame
+// delta are fixed by the header, so a replay steps the simulation exactly
+// like the recorded session did.
+
+// Frame delta of recorded and replayed sessions, seconds
+constexpr float INPUT_TRACE_FIXED_DELTA = 1.0f / 60.0f;
+
+// Whether an event is input that traces record and replays replace
+bool isTracedInputEvent(const SDL_Event& event);
+
+// Collects input events with their frame index, written on stop()
+class InputRecorder
+{
+public:
+    InputRecorder();
+    
+    // Start collecting; the window size is the logical size mouse
+    // coordinates refer to
+    void start(const std::string& path, int windowWidth, int windowHeight);
+    
+    // Append an input event of frame (non-input events are ignored)
+    void record(uint32_t frame, const SDL_Event& event);
+    
+    // Write the trace, frameCount frames long. False when writing failed.
+    bool stop(uint32_t frameCount);
+    
+    bool isRecording() const { return m_recording; }
+    int getEventCount() const { return m_eventCount; }
+    size_t getByteSize() const { return m_data.size(); }
+    
+private:
+    std::string m_path;
+    std::vector<uint8_t> m_data;    // records after the header
+    int m_windowWidth, m_windowHeight;
+    uint32_t m_lastFrame;
+    int m_eventCount;
+    bool m_recording;
+};
+
+// Feeds a recorded trace back frame by frame
+class InputReplayer
+{
+public:
+    InputReplayer();
+    
+    // Read and decode a trace, false when it is missing or malformed
+    bool load(const std::string& path);
+    
+    // Append the events recorded for frame, addressed to windowID
+    void getFrameEvents(uint32_t frame, SDL_WindowID windowID, std::vector<SDL_Event>& events);
+    
+    bool isLoaded() const { return m_loaded; }
+    bool isFinished(uint32_t frame) const { return frame >= m_frameCount; }
+    uint32_t getFrameCount() const { return m_frameCount; }
+    float getFixedDelta() const { return m_fixedDelta; }
+    int getWindowWidth() const { return m_windowWidth; }
+    int getWindowHeight() const { return m_windowHeight; }
+    
+private:
+    std::vector<SDL_Event> m_events;
+    std::vector<uint32_t> m_eventFrames;
+    std::vector<int> m_eventTexts;      // index into m_texts, -1 for other kinds
+    std::vector<std::string> m_texts;
+    size_t m_nextEvent;
+    
+    uint32_t m_frameCount;
+    float m_fixedDelta;
+    int m_windowWidth, m_windowHeight;
+    bool m_loaded;
+};
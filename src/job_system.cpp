@@ -0,0 +1,198 @@
+#include "job_system.h"
+#include "object_pool.h"
+#include <algorithm>
+
+// State of one parallelFor, shared by the caller and its helper jobs.
+// Pooled and reference counted: helpers that start after every range was
+// claimed still read it, so the last user returns it to the pool.
+struct JobSystem::ParallelTask
+{
+    RangeFunction function;
+    void* context;
+    int count;
+    int grainSize;
+    int rangeCount;
+    std::atomic<int> nextRange{0};
+    std::atomic<int> completedRanges{0};
+    std::atomic<int> references{0};
+};
+
+JobSystem& JobSystem::getInstance()
+{
+    static JobSystem instance;
+    return instance;
+}
+
+JobSystem::JobSystem()
+    : m_jobHead(0)
+    , m_jobCount(0)
+    , m_stopping(false)
+{
+    m_jobs.resize(256);
+    
+    // Leave one hardware thread for the main (GL) thread
+    unsigned int hardwareThreads = std::thread::hardware_concurrency();
+    int workerCount = hardwareThreads > 1 ? (int)hardwareThreads - 1 : 1;
+    
+    for (int i = 0; i < workerCount; ++i)
+    {
+        m_workers.emplace_back(&JobSystem::workerLoop, this);
+    }
+}
+
+JobSystem::~JobSystem()
+{
+    shutdown();
+}
+
+void JobSystem::pushJob(std::function<void()>&& job, bool front)
+{
+    // Grow by unrolling the ring into a buffer twice the size
+    if (m_jobCount == m_jobs.size())
+    {
+        std::vector<std::function<void()>> jobs(m_jobs.size() * 2);
+        for (size_t i = 0; i < m_jobCount; ++i)
+        {
+            jobs[i] = std::move(m_jobs[(m_jobHead + i) % m_jobs.size()]);
+        }
+        m_jobs.swap(jobs);
+        m_jobHead = 0;
+    }
+    
+    if (front)
+    {
+        m_jobHead = (m_jobHead + m_jobs.size() - 1) % m_jobs.size();
+        m_jobs[m_jobHead] = std::move(job);
+    }
+    else
+    {
+        m_jobs[(m_jobHead + m_jobCount) % m_jobs.size()] = std::move(job);
+    }
+    m_jobCount++;
+}
+
+std::function<void()> JobSystem::popJob()
+{
+    std::function<void()> job = std::move(m_jobs[m_jobHead]);
+    m_jobs[m_jobHead] = nullptr;
+    m_jobHead = (m_jobHead + 1) % m_jobs.size();
+    m_jobCount--;
+    return job;
+}
+
+void JobSystem::submit(std::function<void()> job)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_stopping)
+            return;
+        pushJob(std::move(job), false);
+    }
+    m_condition.notify_one();
+}
+
+void JobSystem::runRanges(ParallelTask* task)
+{
+    int range;
+    while ((range = task->nextRange.fetch_add(1)) < task->rangeCount)
+    {
+        int begin = range * task->grainSize;
+        int end = std::min(begin + task->grainSize, task->count);
+        task->function(task->context, begin, end);
+        task->completedRanges.fetch_add(1, std::memory_order_release);
+    }
+}
+
+void JobSystem::releaseTask(ParallelTask* task)
+{
+    if (task->references.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        ObjectPool<ParallelTask>::destroy(task);
+}
+
+void JobSystem::runParallelFor(int count, int grainSize, RangeFunction function, void* context)
+{
+    if (count <= 0)
+        return;
+    
+    grainSize = std::max(grainSize, 1);
+    int rangeCount = (count + grainSize - 1) / grainSize;
+    if (rangeCount == 1 || m_workers.empty())
+    {
+        function(context, 0, count);
+        return;
+    }
+    
+    int helperCount = std::min((int)m_workers.size(), rangeCount - 1);
+    ParallelTask* task = ObjectPool<ParallelTask>::create();
+    task->function = function;
+    task->context = context;
+    task->count = count;
+    task->grainSize = grainSize;
+    task->rangeCount = rangeCount;
+    task->references.store(helperCount + 1, std::memory_order_relaxed);
+    
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (int i = 0; i < helperCount; ++i)
+        {
+            // Capturing one pointer keeps the std::function in its inline storage.
+            // The context is only used while ranges remain, and the caller
+            // doesn't return until every range has completed.
+            pushJob([task]()
+            {
+                runRanges(task);
+                releaseTask(task);
+            }, true);
+        }
+    }
+    m_condition.notify_all();
+    
+    // The caller works too, so this never waits on busy workers for progress
+    runRanges(task);
+    
+    while (task->completedRanges.load(std::memory_order_acquire) < rangeCount)
+    {
+        std::this_thread::yield();
+    }
+    releaseTask(task);
+}
+
+void JobSystem::shutdown()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_stopping)
+            return;
+        m_stopping = true;
+        
+        // Pending jobs are dropped (pooled parallelFor tasks stay in the pool)
+        while (m_jobCount > 0)
+        {
+            popJob();
+        }
+    }
+    m_condition.notify_all();
+    
+    for (std::thread& worker : m_workers)
+    {
+        if (worker.joinable())
+            worker.join();
+    }
+    m_workers.clear();
+}
+
+void JobSystem::workerLoop()
+{
+    while (true)
+    {
+        std::function<void()> job;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_condition.wait(lock, [this]() { return m_stopping || m_jobCount > 0; });
+            if (m_stopping)
+                return;
+            job = popJob();
+        }
+        job();
+    }
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Pool of worker threads for CPU-side parallel work
+class JobSystem
+{
+public:
+    // Get singleton instance
+    static JobSystem& getInstance();
+    
+    // Delete copy constructor and assignment operator
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+    
+    // Run a job on a worker thread without waiting for it
+    void submit(std::function<void()> job);
+    
+    // Split [0, count) into ranges of at most grainSize and run fn(begin, end)
+    // on the workers; the calling thread helps and returns when all are done.
+    // fn is called through a pointer, so no std::function is built per call.
+    template<typename Fn>
+    void parallelFor(int count, int grainSize, Fn&& fn)
+    {
+        using Callable = std::remove_reference_t<Fn>;
+        runParallelFor(count, grainSize, [](void* context, int begin, int end)
+        {
+            (*static_cast<Callable*>(context))(begin, end);
+        }, const_cast<void*>(static_cast<const void*>(&fn)));
+    }
+    
+    // Number of threads taking part in parallelFor (workers + caller)
+    int getThreadCount() const { return (int)m_workers.size() + 1; }
+    
+    // Stop and join the worker threads (pending jobs are dropped)
+    void shutdown();
+    
+private:
+    using RangeFunction = void (*)(void* context, int begin, int end);
+    struct ParallelTask;
+    
+    JobSystem();
+    ~JobSystem();
+    
+    void runParallelFor(int count, int grainSize, RangeFunction function, void* context);
+    static void runRanges(ParallelTask* task);
+    static void releaseTask(ParallelTask* task);
+    void workerLoop();
+    
+    // Job queue as a ring buffer that only grows, so steady-state pushes don't allocate
+    void pushJob(std::function<void()>&& job, bool front);
+    std::function<void()> popJob();
+    
+    std::vector<std::thread> m_workers;
+    std::vector<std::function<void()>> m_jobs;
+    size_t m_jobHead;
+    size_t m_jobCount;
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    bool m_stopping;
+};
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string_view>
+
+// 64-bit FNV-1a hashing, usable at compile time
+constexpr uint64_t FNV1A_64_OFFSET = 0xcbf29ce484222325ull;
+constexpr uint64_t FNV1A_64_PRIME = 0x100000001b3ull;
+
+constexpr uint64_t fnv1a64(std::string_view data, uint64_t hash = FNV1A_64_OFFSET)
+{
+    for (char c : data)
+    {
+        hash ^= static_cast<uint8_t>(c);
+        hash *= FNV1A_64_PRIME;
+    }
+    return hash;
+}
+
+inline uint64_t fnv1a64(const void* data, size_t size, uint64_t hash = FNV1A_64_OFFSET)
+{
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < size; ++i)
+    {
+        hash ^= bytes[i];
+        hash *= FNV1A_64_PRIME;
+    }
+    return hash;
+}
@@ -0,0 +1,150 @@
+#include "matrix.h"
+#include <cmath>
+
+void computeNormalMatrix(float* normalMatrix, const float* modelMatrix)
+{
+    // Basis columns of the upper 3x3
+    const float* c0 = modelMatrix;
+    const float* c1 = modelMatrix + 4;
+    const float* c2 = modelMatrix + 8;
+    
+    float len0 = c0[0] * c0[0] + c0[1] * c0[1] + c0[2] * c0[2];
+    float len1 = c1[0] * c1[0] + c1[1] * c1[1] + c1[2] * c1[2];
+    float len2 = c2[0] * c2[0] + c2[1] * c2[1] + c2[2] * c2[2];
+    float dot01 = c0[0] * c1[0] + c0[1] * c1[1] + c0[2] * c1[2];
+    float dot02 = c0[0] * c2[0] + c0[1] * c2[1] + c0[2] * c2[2];
+    float dot12 = c1[0] * c2[0] + c1[1] * c2[1] + c1[2] * c2[2];
+    
+    // Orthogonal columns of equal length: inverse-transpose is the matrix over its scale
+    const float epsilon = 1e-5f * len0;
+    if (std::abs(len0 - len1) <= epsilon && std::abs(len0 - len2) <= epsilon &&
+        std::abs(dot01) <= epsilon && std::abs(dot02) <= epsilon && std::abs(dot12) <= epsilon &&
+        len0 > 0.0f)
+    {
+        float invScale = 1.0f / std::sqrt(len0);
+        for (int i = 0; i < 3; i++)
+        {
+            normalMatrix[i] = c0[i] * invScale;
+            normalMatrix[3 + i] = c1[i] * invScale;
+            normalMatrix[6 + i] = c2[i] * invScale;
+        }
+        return;
+    }
+    
+    // General case: cofactor matrix divided by the determinant
+    float a = c0[0], b = c1[0], c = c2[0];
+    float d = c0[1], e = c1[1], f = c2[1];
+    float g = c0[2], h = c1[2], i = c2[2];
+    
+    float cofA = e * i - f * h;
+    float cofB = -(d * i - f * g);
+    float cofC = d * h - e * g;
+    float cofD = -(b * i - c * h);
+    float cofE = a * i - c * g;
+    float cofF = -(a * h - b * g);
+    float cofG = b * f - c * e;
+    float cofH = -(a * f - c * d);
+    float cofI = a * e - b * d;
+    
+    float det = a * cofA + b * cofB + c * cofC;
+    float invDet = (std::abs(det) > 1e-12f) ? 1.0f / det : 0.0f;
+    
+    // Inverse-transpose equals cofactor / det, stored column-major
+    normalMatrix[0] = cofA * invDet;
+    normalMatrix[1] = cofD * invDet;
+    normalMatrix[2] = cofG * invDet;
+    normalMatrix[3] = cofB * invDet;
+    normalMatrix[4] = cofE * invDet;
+    normalMatrix[5] = cofH * invDet;
+    normalMatrix[6] = cofC * invDet;
+    normalMatrix[7] = cofF * invDet;
+    normalMatrix[8] = cofI * invDet;
+}
+
+void normalMatrixFromQuaternion(float* normalMatrix, const float* quat)
+{
+    float w = quat[0], x = quat[1], y = quat[2], z = quat[3];
+    
+    float xx = x * x, yy = y * y, zz = z * z;
+    float xy = x * y, xz = x * z, yz = y * z;
+    float wx = w * x, wy = w * y, wz = w * z;
+    
+    normalMatrix[0] = 1.0f - 2.0f * (yy + zz);
+    normalMatrix[1] = 2.0f * (xy + wz);
+    normalMatrix[2] = 2.0f * (xz - wy);
+    
+    normalMatrix[3] = 2.0f * (xy - wz);
+    normalMatrix[4] = 1.0f - 2.0f * (xx + zz);
+    normalMatrix[5] = 2.0f * (yz + wx);
+    
+    normalMatrix[6] = 2.0f * (xz + wy);
+    normalMatrix[7] = 2.0f * (yz - wx);
+    normalMatrix[8] = 1.0f - 2.0f * (xx + yy);
+}
+
+void multiplyMatrix(float* result, const float* a, const float* b)
+{
+    for (int col = 0; col < 4; col++)
+    {
+        for (int row = 0; row < 4; row++)
+        {
+            float sum = 0.0f;
+            for (int k = 0; k < 4; k++)
+            {
+                sum += a[k * 4 + row] * b[col * 4 + k];
+            }
+            result[col * 4 + row] = sum;
+        }
+    }
+}
+
+bool invertMatrix(float* result, const float* m)
+{
+    // Cofactor expansion via 2x2 sub-determinants of the upper and lower row pairs
+    float s0 = m[0] * m[5] - m[4] * m[1];
+    float s1 = m[0] * m[9] - m[8] * m[1];
+    float s2 = m[0] * m[13] - m[12] * m[1];
+    float s3 = m[4] * m[9] - m[8] * m[5];
+    float s4 = m[4] * m[13] - m[12] * m[5];
+    float s5 = m[8] * m[13] - m[12] * m[9];
+    
+    float c5 = m[10] * m[15] - m[14] * m[11];
+    float c4 = m[6] * m[15] - m[14] * m[7];
+    float c3 = m[6] * m[11] - m[10] * m[7];
+    float c2 = m[2] * m[15] - m[14] * m[3];
+    float c1 = m[2] * m[11] - m[10] * m[3];
+    float c0 = m[2] * m[7] - m[6] * m[3];
+    
+    float det = s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
+    if (std::abs(det) < 1e-20f)
+    {
+        for (int i = 0; i < 16; i++)
+        {
+            result[i] = (i % 5 == 0) ? 1.0f : 0.0f;
+        }
+        return false;
+    }
+    float invDet = 1.0f / det;
+    
+    // Transposed indexing: m[col * 4 + row] holds element (row, col)
+    result[0] = (m[5] * c5 - m[9] * c4 + m[13] * c3) * invDet;
+    result[4] = (-m[4] * c5 + m[8] * c4 - m[12] * c3) * invDet;
+    result[8] = (m[7] * s5 - m[11] * s4 + m[15] * s3) * invDet;
+    result[12] = (-m[6] * s5 + m[10] * s4 - m[14] * s3) * invDet;
+    
+    result[1] = (-m[1] * c5 + m[9] * c2 - m[13] * c1) * invDet;
+    result[5] = (m[0] * c5 - m[8] * c2 + m[12] * c1) * invDet;
+    result[9] = (-m[3] * s5 + m[11] * s2 - m[15] * s1) * invDet;
+    result[13] = (m[2] * s5 - m[10] * s2 + m[14] * s1) * invDet;
+    
+    result[2] = (m[1] * c4 - m[5] * c2 + m[13] * c0) * invDet;
+    result[6] = (-m[0] * c4 + m[4] * c2 - m[12] * c0) * invDet;
+    result[10] = (m[3] * s4 - m[7] * s2 + m[15] * s0) * invDet;
+    result[14] = (-m[2] * s4 + m[6] * s2 - m[14] * s0) * invDet;
+    
+    result[3] = (-m[1] * c3 + m[5] * c1 - m[9] * c0) * invDet;
+    result[7] = (m[0] * c3 - m[4] * c1 + m[8] * c0) * invDet;
+    result[11] = (-m[3] * s3 + m[7] * s1 - m[11] * s0) * invDet;
+    result[15] = (m[2] * s3 - m[6] * s1 + m[10] * s0) * invDet;
+    return true;
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+// Column-major 4x4 / 3x3 matrix helpers shared by renderable objects
+
+// Build the normal matrix (inverse-transpose of the upper 3x3) of a model matrix.
+// Rotation with uniform scale skips the inverse and just rescales the basis.
+void computeNormalMatrix(float* normalMatrix, const float* modelMatrix);
+
+// Normal matrix straight from a unit quaternion (w, x, y, z), valid for any
+// uniform scale since the rotation part is already orthonormal
+void normalMatrixFromQuaternion(float* normalMatrix, const float* quat);
+
+// result = a * b for column-major 4x4 matrices (result must not alias a or b)
+void multiplyMatrix(float* result, const float* a, const float* b);
+
+// result = inverse of a column-major 4x4 matrix, false (and identity) if singular
+bool invertMatrix(float* result, const float* m);
@@ -0,0 +1,328 @@
+// Silence OpenGL deprecation warnings on macOS
+#define GL_SILENCE_DEPRECATION
+
+#include "light_system.h"
+#include "job_system.h"
+#include "render_stats.h"
+#include "gl_state.h"
+#include <algorithm>
+#include <cmath>
+
+LightSystem::LightSystem()
+    : m_nearPlane(0.1f), m_farPlane(100.0f)
+    , m_logDepthScale(0.0f), m_logDepthBias(0.0f)
+    , m_screenWidth(1), m_screenHeight(1)
+    , m_visibleLights(0)
+    , m_overflowCount(0)
+    , m_lightDataBuffer(0), m_lightDataTexture(0)
+    , m_clusterGridBuffer(0), m_clusterGridTexture(0)
+    , m_lightIndexBuffer(0), m_lightIndexTexture(0)
+    , m_initialized(false)
+{
+    m_clusterGrid.resize(CLUSTER_COUNT * 2, 0);
+}
+
+LightSystem::~LightSystem()
+{
+    cleanup();
+}
+
+void LightSystem::initialize()
+{
+    if (m_initialized)
+        return;
+    
+    glGenBuffers(1, &m_lightDataBuffer);
+    glGenBuffers(1, &m_clusterGridBuffer);
+    glGenBuffers(1, &m_lightIndexBuffer);
+    glGenTextures(1, &m_lightDataTexture);
+    glGenTextures(1, &m_clusterGridTexture);
+    glGenTextures(1, &m_lightIndexTexture);
+    
+    // Texture buffers need storage before they can be attached
+    GLState& state = GLState::getInstance();
+    uint32_t zero[4] = {0, 0, 0, 0};
+    state.bindBuffer(GL_TEXTURE_BUFFER, m_lightDataBuffer);
+    glBufferData(GL_TEXTURE_BUFFER, sizeof(zero), zero, GL_STREAM_DRAW);
+    state.bindBuffer(GL_TEXTURE_BUFFER, m_clusterGridBuffer);
+    glBufferData(GL_TEXTURE_BUFFER, sizeof(zero), zero, GL_STREAM_DRAW);
+    state.bindBuffer(GL_TEXTURE_BUFFER, m_lightIndexBuffer);
+    glBufferData(GL_TEXTURE_BUFFER, sizeof(zero), zero, GL_STREAM_DRAW);
+    
+    // Each texture is attached on the unit it is sampled from
+    state.bindTexture(LIGHT_DATA_UNIT, GL_TEXTURE_BUFFER, m_lightDataTexture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, m_lightDataBuffer);
+    state.bindTexture(CLUSTER_GRID_UNIT, GL_TEXTURE_BUFFER, m_clusterGridTexture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RG32UI, m_clusterGridBuffer);
+    state.bindTexture(LIGHT_INDEX_UNIT, GL_TEXTURE_BUFFER, m_lightIndexTexture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_R32UI, m_lightIndexBuffer);
+    state.activeTexture(0);
+    
+    m_initialized = true;
+}
+
+void LightSystem::cleanup()
+{
+    if (m_initialized)
+    {
+        GLState& state = GLState::getInstance();
+        state.deleteTextures(1, &m_lightDataTexture);
+        state.deleteTextures(1, &m_clusterGridTexture);
+        state.deleteTextures(1, &m_lightIndexTexture);
+        state.deleteBuffers(1, &m_lightDataBuffer);
+        state.deleteBuffers(1, &m_clusterGridBuffer);
+        state.deleteBuffers(1, &m_lightIndexBuffer);
+        
+        m_lightDataTexture = m_clusterGridTexture = m_lightIndexTexture = 0;
+        m_lightDataBuffer = m_clusterGridBuffer = m_lightIndexBuffer = 0;
+        m_initialized = false;
+    }
+}
+
+int LightSystem::addLight(const PointLight& light)
+{
+    m_lights.push_back(light);
+    return (int)m_lights.size() - 1;
+}
+
+void LightSystem::removeLights(int first, int count)
+{
+    if (first < 0 || first >= (int)m_lights.size() || count <= 0)
+        return;
+    
+    int last = std::min(first + count, (int)m_lights.size());
+    m_lights.erase(m_lights.begin() + first, m_lights.begin() + last);
+}
+
+void LightSystem::update(const float* viewMatrix, const float* projectionMatrix,
+                         float nearPlane, float farPlane, int screenWidth, int screenHeight)
+{
+    m_nearPlane = nearPlane;
+    m_farPlane = farPlane;
+    m_screenWidth = std::max(screenWidth, 1);
+    m_screenHeight = std::max(screenHeight, 1);
+    
+    // slice = log(depth) * scale + bias maps [near, far] onto [0, CLUSTER_Z]
+    float logRatio = std::log(m_farPlane / m_nearPlane);
+    m_logDepthScale = CLUSTER_Z / logRatio;
+    m_logDepthBias = -CLUSTER_Z * std::log(m_nearPlane) / logRatio;
+    
+    JobSystem& jobs = JobSystem::getInstance();
+    int lightCount = (int)m_lights.size();
+    m_lightBounds.resize(lightCount);
+    m_lightData.resize(std::max(lightCount, 1) * 8);
+    
+    // Pass 1: per-light cluster ranges
+    jobs.parallelFor(lightCount, 256, [&](int begin, int end)
+    {
+        computeLightBounds(begin, end, viewMatrix, projectionMatrix);
+    });
+    
+    m_visibleLights = 0;
+    for (const LightBounds& bounds : m_lightBounds)
+    {
+        if (bounds.z0 <= bounds.z1)
+            m_visibleLights++;
+    }
+    
+    // Pass 2: count lights per cluster, one depth slice per job
+    jobs.parallelFor(CLUSTER_Z, 1, [this](int begin, int end)
+    {
+        countClusterLights(begin, end);
+    });
+    
+    // Prefix sum into offsets, clamping overfull clusters
+    uint32_t offset = 0;
+    m_overflowCount = 0;
+    for (int cluster = 0; cluster < CLUSTER_COUNT; ++cluster)
+    {
+        uint32_t count = m_clusterGrid[cluster * 2 + 1];
+        if (count > (uint32_t)MAX_LIGHTS_PER_CLUSTER)
+        {
+            m_overflowCount++;
+            count = MAX_LIGHTS_PER_CLUSTER;
+        }
+        m_clusterGrid[cluster * 2] = offset;
+        m_clusterGrid[cluster * 2 + 1] = count;
+        offset += count;
+    }
+    m_lightIndices.resize(std::max(offset, 1u));
+    
+    // Pass 3: write light indices, slices touch disjoint ranges
+    jobs.parallelFor(CLUSTER_Z, 1, [this](int begin, int end)
+    {
+        fillClusterLights(begin, end);
+    });
+    
+    if (!m_initialized)
+        return;
+    
+    // Upload, orphaning last frame's storage
+    GLState& state = GLState::getInstance();
+    state.bindBuffer(GL_TEXTURE_BUFFER, m_lightDataBuffer);
+    glBufferData(GL_TEXTURE_BUFFER, m_lightData.size() * sizeof(float), m_lightData.data(), GL_STREAM_DRAW);
+    state.bindBuffer(GL_TEXTURE_BUFFER, m_clusterGridBuffer);
+    glBufferData(GL_TEXTURE_BUFFER, m_clusterGrid.size() * sizeof(uint32_t), m_clusterGrid.data(), GL_STREAM_DRAW);
+    state.bindBuffer(GL_TEXTURE_BUFFER, m_lightIndexBuffer);
+    glBufferData(GL_TEXTURE_BUFFER, m_lightIndices.size() * sizeof(uint32_t), m_lightIndices.data(), GL_STREAM_DRAW);
+    RenderStats::getInstance().countBufferUpload(m_lightData.size() * sizeof(float) +
+                                                 m_clusterGrid.size() * sizeof(uint32_t) +
+                                                 m_lightIndices.size() * sizeof(uint32_t));
+}
+
+void LightSystem::computeLightBounds(int begin, int end, const float* viewMatrix, const float* projectionMatrix)
+{
+    const float* v = viewMatrix;
+    const float* p = projectionMatrix;
+    
+    for (int i = begin; i < end; ++i)
+    {
+        const PointLight& light = m_lights[i];
+        LightBounds& bounds = m_lightBounds[i];
+        bounds = {0, -1, 0, -1, 0, -1};
+        
+        // Shader data: position + radius, premultiplied color
+        float* data = &m_lightData[i * 8];
+        data[0] = light.position[0];
+        data[1] = light.position[1];
+        data[2] = light.position[2];
+        data[3] = light.radius;
+        data[4] = light.color[0] * light.intensity;
+        data[5] = light.color[1] * light.intensity;
+        data[6] = light.color[2] * light.intensity;
+        data[7] = 0.0f;
+        
+        // View-space center (camera looks down -Z)
+        float px = light.position[0], py = light.position[1], pz = light.position[2];
+        float cx = v[0] * px + v[4] * py + v[8] * pz + v[12];
+        float cy = v[1] * px + v[5] * py + v[9] * pz + v[13];
+        float cz = v[2] * px + v[6] * py + v[10] * pz + v[14];
+        float r = light.radius;
+        
+        float depthMin = -cz - r;
+        float depthMax = -cz + r;
+        if (r <= 0.0f || depthMax < m_nearPlane || depthMin > m_farPlane)
+            continue;
+        depthMin = std::max(depthMin, m_nearPlane);
+        depthMax = std::min(depthMax, m_farPlane);
+        
+        // Bounding box of the sphere projected to NDC. With perspective the
+        // extremes sit on the nearest depth for outward edges and the farthest
+        // for inward ones; an orthographic projection (no w from depth) is
+        // affine, so the box maps straight through
+        float xMin = cx - r, xMax = cx + r;
+        float yMin = cy - r, yMax = cy + r;
+        float ndcX0, ndcX1, ndcY0, ndcY1;
+        if (p[11] == 0.0f)
+        {
+            ndcX0 = p[0] * xMin + p[12];
+            ndcX1 = p[0] * xMax + p[12];
+            ndcY0 = p[5] * yMin + p[13];
+            ndcY1 = p[5] * yMax + p[13];
+        }
+        else
+        {
+            ndcX0 = p[0] * (xMin < 0.0f ? xMin / depthMin : xMin / depthMax);
+            ndcX1 = p[0] * (xMax > 0.0f ? xMax / depthMin : xMax / depthMax);
+            ndcY0 = p[5] * (yMin < 0.0f ? yMin / depthMin : yMin / depthMax);
+            ndcY1 = p[5] * (yMax > 0.0f ? yMax / depthMin : yMax / depthMax);
+        }
+        if (ndcX1 < -1.0f || ndcX0 > 1.0f || ndcY1 < -1.0f || ndcY0 > 1.0f)
+            continue;
+        
+        auto toTile = [](float ndc, int tiles)
+        {
+            int tile = (int)std::floor((ndc * 0.5f + 0.5f) * tiles);
+            return (int16_t)std::clamp(tile, 0, tiles - 1);
+        };
+        auto toSlice = [this](float depth)
+        {
+            int slice = (int)std::floor(std::log(depth) * m_logDepthScale + m_logDepthBias);
+            return (int16_t)std::clamp(slice, 0, CLUSTER_Z - 1);
+        };
+        
+        bounds.x0 = toTile(ndcX0, CLUSTER_X);
+        bounds.x1 = toTile(ndcX1, CLUSTER_X);
+        bounds.y0 = toTile(ndcY0, CLUSTER_Y);
+        bounds.y1 = toTile(ndcY1, CLUSTER_Y);
+        bounds.z0 = toSlice(depthMin);
+        bounds.z1 = toSlice(depthMax);
+    }
+}
+
+void LightSystem::countClusterLights(int sliceBegin, int sliceEnd)
+{
+    for (int z = sliceBegin; z < sliceEnd; ++z)
+    {
+        uint32_t* grid = &m_clusterGrid[z * CLUSTER_X * CLUSTER_Y * 2];
+        for (int c = 0; c < CLUSTER_X * CLUSTER_Y; ++c)
+        {
+            grid[c * 2 + 1] = 0;
+        }
+        
+        for (const LightBounds& bounds : m_lightBounds)
+        {
+            if (z < bounds.z0 || z > bounds.z1)
+                continue;
+            
+            for (int y = bounds.y0; y <= bounds.y1; ++y)
+            {
+                for (int x = bounds.x0; x <= bounds.x1; ++x)
+                {
+                    grid[(y * CLUSTER_X + x) * 2 + 1]++;
+                }
+            }
+        }
+    }
+}
+
+void LightSystem::fillClusterLights(int sliceBegin, int sliceEnd)
+{
+    uint32_t written[CLUSTER_X * CLUSTER_Y];
+    
+    for (int z = sliceBegin; z < sliceEnd; ++z)
+    {
+        const uint32_t* grid = &m_clusterGrid[z * CLUSTER_X * CLUSTER_Y * 2];
+        std::fill(written, written + CLUSTER_X * CLUSTER_Y, 0u);
+        
+        for (int i = 0; i < (int)m_lightBounds.size(); ++i)
+        {
+            const LightBounds& bounds = m_lightBounds[i];
+            if (z < bounds.z0 || z > bounds.z1)
+                continue;
+            
+            for (int y = bounds.y0; y <= bounds.y1; ++y)
+            {
+                for (int x = bounds.x0; x <= bounds.x1; ++x)
+                {
+                    int c = y * CLUSTER_X + x;
+                    if (written[c] < grid[c * 2 + 1])
+                    {
+                        m_lightIndices[grid[c * 2] + written[c]] = (uint32_t)i;
+                        written[c]++;
+                    }
+                }
+            }
+        }
+    }
+}
+
+void LightSystem::bind(GLuint program) const
+{
+    if (!m_initialized || program == 0)
+        return;
+    
+    GLState& state = GLState::getInstance();
+    state.bindTexture(LIGHT_DATA_UNIT, GL_TEXTURE_BUFFER, m_lightDataTexture);
+    state.bindTexture(CLUSTER_GRID_UNIT, GL_TEXTURE_BUFFER, m_clusterGridTexture);
+    state.bindTexture(LIGHT_INDEX_UNIT, GL_TEXTURE_BUFFER, m_lightIndexTexture);
+    state.activeTexture(0);
+    
+    glUniform1i(glGetUniformLocation(program, "lightData"), LIGHT_DATA_UNIT);
+    glUniform1i(glGetUniformLocation(program, "clusterGrid"), CLUSTER_GRID_UNIT);
+    glUniform1i(glGetUniformLocation(program, "lightIndices"), LIGHT_INDEX_UNIT);
+    glUniform3ui(glGetUniformLocation(program, "clusterDims"), CLUSTER_X, CLUSTER_Y, CLUSTER_Z);
+    glUniform2f(glGetUniformLocation(program, "screenSize"), (float)m_screenWidth, (float)m_screenHeight);
+    glUniform2f(glGetUniformLocation(program, "clusterDepthParams"), m_logDepthScale, m_logDepthBias);
+    RenderStats::getInstance().countUniforms(6);
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+// Silence OpenGL deprecation warnings on macOS
+#define GL_SILENCE_DEPRECATION
+
+#include <vector>
+#include <cstdint>
+
+#if defined(__APPLE__)
+    #include <OpenGL/gl3.h>
+#else
+    #include <SDL3/SDL_opengl.h>
+#endif
+
+// Point light with a finite range
+struct PointLight
+{
+    float position[3];
+    float radius;
+    float color[3];
+    float intensity;
+};
+
+// Clustered forward lighting: lights are binned on the CPU into a view-space
+// froxel grid and the per-cluster light lists are uploaded to texture buffers
+class LightSystem
+{
+public:
+    // Froxel grid resolution (screen tiles x, y and logarithmic depth slices)
+    static constexpr int CLUSTER_X = 16;
+    static constexpr int CLUSTER_Y = 9;
+    static constexpr int CLUSTER_Z = 24;
+    static constexpr int CLUSTER_COUNT = CLUSTER_X * CLUSTER_Y * CLUSTER_Z;
+    
+    // Upper bound on lights shaded by a single cluster
+    static constexpr int MAX_LIGHTS_PER_CLUSTER = 256;
+    
+    // Texture units used by the light buffers
+    static constexpr int LIGHT_DATA_UNIT = 1;
+    static constexpr int CLUSTER_GRID_UNIT = 2;
+    static constexpr int LIGHT_INDEX_UNIT = 3;
+    
+    LightSystem();
+    ~LightSystem();
+    
+    // Delete copy constructor and assignment operator
+    LightSystem(const LightSystem&) = delete;
+    LightSystem& operator=(const LightSystem&) = delete;
+    
+    // Create the GL buffers (needs a current context)
+    void initialize();
+    void cleanup();
+    
+    // Light list
+    int addLight(const PointLight& light);
+    void removeLights(int first, int count);
+    PointLight& getLight(int index) { return m_lights[index]; }
+    int getLightCount() const { return (int)m_lights.size(); }
+    
+    // Assign lights to clusters for this camera and upload the result.
+    // projection is a symmetric OpenGL perspective or orthographic matrix
+    // (column-major).
+    void update(const float* viewMatrix, const float* projectionMatrix,
+                float nearPlane, float farPlane, int screenWidth, int screenHeight);
+    
+    // Bind the light buffers and set the clustering uniforms on a program in use
+    void bind(GLuint program) const;
+    
+    // Statistics from the last update
+    int getVisibleLightCount() const { return m_visibleLights; }
+    int getAssignedIndexCount() const { return (int)m_lightIndices.size(); }
+    int getOverflowCount() const { return m_overflowCount; }
+    
+private:
+    // Cluster range covered by one light, empty if z0 > z1
+    struct LightBounds
+    {
+        int16_t x0, x1, y0, y1, z0, z1;
+    };
+    
+    void computeLightBounds(int begin, int end, const float* viewMatrix, const float* projectionMatrix);
+    void countClusterLights(int sliceBegin, int sliceEnd);
+    void fillClusterLights(int sliceBegin, int sliceEnd);
+    
+    std::vector<PointLight> m_lights;
+    
+    // CPU side cluster data
+    std::vector<LightBounds> m_lightBounds;
+    std::vector<uint32_t> m_clusterGrid;    // (offset, count) pairs per cluster
+    std::vector<uint32_t> m_lightIndices;   // light indices grouped by cluster
+    std::vector<float> m_lightData;         // two vec4 per light for the shader
+    
+    // Depth slicing parameters for the current frame
+    float m_nearPlane, m_farPlane;
+    float m_logDepthScale, m_logDepthBias;
+    int m_screenWidth, m_screenHeight;
+    
+    int m_visibleLights;
+    int m_overflowCount;
+    
+    // Texture buffer objects: buffer + texture view for each array
+    GLuint m_lightDataBuffer, m_lightDataTexture;
+    GLuint m_clusterGridBuffer, m_clusterGridTexture;
+    GLuint m_lightIndexBuffer, m_lightIndexTexture;
+    bool m_initialized;
+};
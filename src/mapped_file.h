@@ -0,0 +1,36 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+// Read-only memory mapped file. Pages are read in by the OS on first
+// access, so touching the data on a worker thread keeps I/O off the GL thread.
+class MappedFile
+{
+public:
+    MappedFile();
+    ~MappedFile();
+    
+    // Delete copy constructor and assignment operator
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    
+    // Map a whole file, returns false if it doesn't exist or can't be mapped
+    bool open(const std::string& path);
+    void close();
+    
+    bool isOpen() const { return m_data != nullptr; }
+    const uint8_t* getData() const { return m_data; }
+    size_t getSize() const { return m_size; }
+    
+private:
+#if defined(_WIN32)
+    void* m_file;       // HANDLE
+    void* m_mapping;    // HANDLE
+#else
+    int m_fd;
+#endif
+    const uint8_t* m_data;
+    size_t m_size;
+};
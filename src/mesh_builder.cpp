@@ -0,0 +1,142 @@
+// Silence OpenGL deprecation warnings on macOS
+#define GL_SILENCE_DEPRECATION
+
+#include "mesh_builder.h"
+#include "gl_state.h"
+#include "job_system.h"
+#include "render_stats.h"
+
+GpuMesh::GpuMesh()
+    : m_VAO(0), m_VBO(0), m_EBO(0)
+    , m_depthVAO(0), m_depthVBO(0)
+    , m_vertexCount(0)
+    , m_indexCount(0)
+    , m_building(false)
+{
+    GLState& state = GLState::getInstance();
+    glGenVertexArrays(1, &m_VAO);
+    glGenBuffers(1, &m_VBO);
+    glGenBuffers(1, &m_EBO);
+    glGenVertexArrays(1, &m_depthVAO);
+    glGenBuffers(1, &m_depthVBO);
+    
+    state.bindVertexArray(m_VAO);
+    state.bindBuffer(GL_ARRAY_BUFFER, m_VBO);
+    state.bindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_EBO);
+    
+    // Position attribute (location 0)
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 9 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+    
+    // Color attribute (location 1)
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 9 * sizeof(float), (void*)(3 * sizeof(float)));
+    glEnableVertexAttribArray(1);
+    
+    // Normal attribute (location 2)
+    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, 9 * sizeof(float), (void*)(6 * sizeof(float)));
+    glEnableVertexAttribArray(2);
+    
+    state.bindVertexArray(m_depthVAO);
+    state.bindBuffer(GL_ARRAY_BUFFER, m_depthVBO);
+    state.bindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_EBO);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+}
+
+GpuMesh::~GpuMesh()
+{
+    GLState& state = GLState::getInstance();
+    state.deleteVertexArrays(1, &m_VAO);
+    state.deleteBuffers(1, &m_VBO);
+    state.deleteBuffers(1, &m_EBO);
+    state.deleteVertexArrays(1, &m_depthVAO);
+    state.deleteBuffers(1, &m_depthVBO);
+}
+
+void GpuMesh::upload(const MeshData& mesh)
+{
+    GLState& state = GLState::getInstance();
+    m_vertexCount = mesh.getVertexCount();
+    m_indexCount = (int)mesh.indices.size();
+    
+    state.bindBuffer(GL_ARRAY_BUFFER, m_VBO);
+    glBufferData(GL_ARRAY_BUFFER, mesh.vertices.size() * sizeof(float), mesh.vertices.data(), GL_STATIC_DRAW);
+    state.bindBuffer(GL_ARRAY_BUFFER, m_depthVBO);
+    glBufferData(GL_ARRAY_BUFFER, mesh.positions.size() * sizeof(float), mesh.positions.data(), GL_STATIC_DRAW);
+    
+    state.bindVertexArray(m_VAO);
+    state.bindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_EBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, mesh.indices.size() * sizeof(unsigned int), mesh.indices.data(), GL_STATIC_DRAW);
+    RenderStats::getInstance().countBufferUpload((mesh.vertices.size() + mesh.positions.size()) * sizeof(float) +
+                                                 mesh.indices.size() * sizeof(unsigned int));
+}
+
+MeshBuilder& MeshBuilder::getInstance()
+{
+    static MeshBuilder instance;
+    return instance;
+}
+
+MeshBuilder::MeshBuilder()
+    : m_inFlight(0)
+    , m_uploadBudget(1024 * 1024)
+    , m_lastUploadBytes(0)
+{
+}
+
+void MeshBuilder::requestBuild(const std::shared_ptr<GpuMesh>& target, BuildFunction build)
+{
+    if (!target)
+        return;
+    
+    // Already building: remember only the latest request
+    if (target->m_building)
+    {
+        target->m_nextBuild = std::move(build);
+        return;
+    }
+    startBuild(target, std::move(build));
+}
+
+void MeshBuilder::startBuild(const std::shared_ptr<GpuMesh>& target, BuildFunction build)
+{
+    target->m_building = true;
+    m_inFlight++;
+    
+    // The job only holds a weak reference, the mesh is never released on a worker
+    std::weak_ptr<GpuMesh> weakTarget = target;
+    JobSystem::getInstance().submit([this, weakTarget, build = std::move(build)]()
+    {
+        BuildResult result;
+        result.target = weakTarget;
+        build(result.mesh);
+        m_completed.push(std::move(result));
+        m_inFlight--;
+    });
+}
+
+void MeshBuilder::processUploads()
+{
+    m_lastUploadBytes = 0;
+    
+    BuildResult result;
+    while (m_lastUploadBytes < m_uploadBudget && m_completed.pop(result))
+    {
+        // Destroyed while building
+        std::shared_ptr<GpuMesh> target = result.target.lock();
+        if (!target)
+            continue;
+        
+        target->m_building = false;
+        target->upload(result.mesh);
+        m_lastUploadBytes += result.mesh.getByteSize();
+        
+        // Changed again while building, build the latest state
+        if (target->m_nextBuild)
+        {
+            BuildFunction build = std::move(target->m_nextBuild);
+            target->m_nextBuild = nullptr;
+            startBuild(target, std::move(build));
+        }
+    }
+}
@@ -0,0 +1,126 @@
+#pragma once
+
+// Silence OpenGL deprecation warnings on macOS
+#define GL_SILENCE_DEPRECATION
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "mpsc_queue.h"
+
+#if defined(__APPLE__)
+    #include <OpenGL/gl3.h>
+#else
+    #include <SDL3/SDL_opengl.h>
+#endif
+
+// CPU side of a mesh, built off the GL thread and uploaded later
+struct MeshData
+{
+    std::vector<float> vertices;        // position, color, normal (then any extra attributes)
+    std::vector<float> positions;       // position only, for the depth pre-pass
+    std::vector<unsigned int> indices;
+    int floatsPerVertex = 9;            // 12 for voxel meshes, which add a texture coordinate
+    
+    int getVertexCount() const { return (int)(vertices.size() / floatsPerVertex); }
+    
+    size_t getByteSize() const
+    {
+        return vertices.size() * sizeof(float) + positions.size() * sizeof(float) +
+               indices.size() * sizeof(unsigned int);
+    }
+};
+
+// GPU side of a mesh: the vertex layout of the lit shaders plus a
+// position-only stream for the depth pre-pass, sharing one index buffer.
+// GL thread only.
+class GpuMesh
+{
+public:
+    GpuMesh();
+    ~GpuMesh();
+    
+    // Delete copy constructor and assignment operator
+    GpuMesh(const GpuMesh&) = delete;
+    GpuMesh& operator=(const GpuMesh&) = delete;
+    
+    void upload(const MeshData& mesh);
+    
+    GLuint getVAO() const { return m_VAO; }
+    GLuint getDepthVAO() const { return m_depthVAO; }
+    int getVertexCount() const { return m_vertexCount; }
+    int getIndexCount() const { return m_indexCount; }
+    
+private:
+    friend class MeshBuilder;
+    
+    GLuint m_VAO;
+    GLuint m_VBO;
+    GLuint m_EBO;
+    GLuint m_depthVAO;
+    GLuint m_depthVBO;
+    int m_vertexCount;
+    int m_indexCount;
+    
+    // Build state, owned by MeshBuilder
+    bool m_building;
+    std::function<void(MeshData&)> m_nextBuild;
+};
+
+// Builds meshes on the JobSystem and uploads them on the GL thread. Finished
+// meshes wait in a lock-free queue and processUploads() drains it within a
+// per-frame byte budget, so a large rebuild never stalls a frame. Each mesh
+// has at most one build in flight; requests made meanwhile collapse into one
+// follow-up build of the latest state.
+class MeshBuilder
+{
+public:
+    using BuildFunction = std::function<void(MeshData&)>;
+    
+    // Get singleton instance
+    static MeshBuilder& getInstance();
+    
+    // Delete copy constructor and assignment operator
+    MeshBuilder(const MeshBuilder&) = delete;
+    MeshBuilder& operator=(const MeshBuilder&) = delete;
+    
+    // Rebuild target's mesh with build (GL thread). build runs on a worker
+    // thread, so it must capture what it reads by value. Results for meshes
+    // destroyed in the meantime are dropped.
+    void requestBuild(const std::shared_ptr<GpuMesh>& target, BuildFunction build);
+    
+    // GL thread, once per frame: upload finished meshes (one always goes through)
+    void processUploads();
+    
+    // Bytes of mesh data uploaded per frame at most
+    void setUploadBudget(size_t bytes) { m_uploadBudget = bytes; }
+    size_t getUploadBudget() const { return m_uploadBudget; }
+    
+    // Whether builds are running or waiting for upload
+    bool hasPending() const { return m_inFlight.load() > 0 || m_completed.size() > 0; }
+    
+    // Statistics
+    int getBuildingCount() const { return m_inFlight.load(); }
+    int getUploadQueueLength() const { return (int)m_completed.size(); }
+    size_t getLastUploadBytes() const { return m_lastUploadBytes; }
+    
+private:
+    // Finished build waiting for upload
+    struct BuildResult
+    {
+        std::weak_ptr<GpuMesh> target;
+        MeshData mesh;
+    };
+    
+    MeshBuilder();
+    ~MeshBuilder() = default;
+    
+    void startBuild(const std::shared_ptr<GpuMesh>& target, BuildFunction build);
+    
+    MpscQueue<BuildResult> m_completed;
+    std::atomic<int> m_inFlight;
+    size_t m_uploadBudget;
+    size_t m_lastUploadBytes;
+};
@@ -0,0 +1,267 @@
+// Silence OpenGL deprecation warnings on macOS
+#define GL_SILENCE_DEPRECATION
+
+#include "mesh_library.h"
+#include "gl_state.h"
+#include "render_stats.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+MeshLibrary& MeshLibrary::getInstance()
+{
+    static MeshLibrary instance;
+    return instance;
+}
+
+std::unique_ptr<LibraryMesh> MeshLibrary::createMesh(const float* vertices, size_t vertexCount,
+                                                     const unsigned int* indices, size_t indexCount)
+{
+    std::unique_ptr<LibraryMesh> mesh = std::make_unique<LibraryMesh>();
+    mesh->indexCount = (GLsizei)indexCount;
+    
+    // Position-only copy for the depth pre-pass, and the bounds
+    std::vector<float> positions(vertexCount * 3);
+    for (size_t i = 0; i < vertexCount; ++i)
+    {
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            float value = vertices[i * 9 + axis];
+            positions[i * 3 + axis] = value;
+            mesh->boundsMin[axis] = (i == 0) ? value : std::min(mesh->boundsMin[axis], value);
+            mesh->boundsMax[axis] = (i == 0) ? value : std::max(mesh->boundsMax[axis], value);
+        }
+    }
+    
+    GLState& state = GLState::getInstance();
+    glGenBuffers(1, &mesh->VBO);
+    glGenBuffers(1, &mesh->depthVBO);
+    glGenBuffers(1, &mesh->EBO);
+    
+    state.bindBuffer(GL_ARRAY_BUFFER, mesh->VBO);
+    glBufferData(GL_ARRAY_BUFFER, vertexCount * 9 * sizeof(float), vertices, GL_STATIC_DRAW);
+    state.bindBuffer(GL_ARRAY_BUFFER, mesh->depthVBO);
+    glBufferData(GL_ARRAY_BUFFER, positions.size() * sizeof(float), positions.data(), GL_STATIC_DRAW);
+    
+    // Draws leave their VAO bound, unbind it so the element buffer changes no VAO state
+    state.bindVertexArray(0);
+    state.bindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->EBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexCount * sizeof(unsigned int), indices, GL_STATIC_DRAW);
+    RenderStats::getInstance().countBufferUpload((vertexCount * 9 + positions.size()) * sizeof(float) +
+                                                 indexCount * sizeof(unsigned int));
+    
+    // Shared VAOs for objects drawing the mesh one at a time
+    glGenVertexArrays(1, &mesh->VAO);
+    state.bindVertexArray(mesh->VAO);
+    state.bindBuffer(GL_ARRAY_BUFFER, mesh->VBO);
+    state.bindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->EBO);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 9 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 9 * sizeof(float), (void*)(3 * sizeof(float)));
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, 9 * sizeof(float), (void*)(6 * sizeof(float)));
+    glEnableVertexAttribArray(2);
+    
+    glGenVertexArrays(1, &mesh->depthVAO);
+    state.bindVertexArray(mesh->depthVAO);
+    state.bindBuffer(GL_ARRAY_BUFFER, mesh->depthVBO);
+    state.bindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->EBO);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+    
+    return mesh;
+}
+
+std::unique_ptr<LibraryMesh> MeshLibrary::createCube(const float (*faceColors)[3])
+{
+    // Position, color, normal per vertex, four vertices per face
+    static const float FACE_NORMALS[6][3] = {
+        {0.0f, 0.0f, 1.0f}, {0.0f, 0.0f, -1.0f},
+        {-1.0f, 0.0f, 0.0f}, {1.0f, 0.0f, 0.0f},
+        {0.0f, 1.0f, 0.0f}, {0.0f, -1.0f, 0.0f}
+    };
+    
+    std::vector<float> vertices;
+    std::vector<unsigned int> indices;
+    for (int face = 0; face < 6; ++face)
+    {
+        const float* n = FACE_NORMALS[face];
+        const float* c = faceColors[face];
+        
+        // Two axes spanning the face, ordered so the quad winds CCW from outside
+        float u[3] = {n[1], n[2], n[0]};
+        float v[3] = {n[1] * u[2] - n[2] * u[1], n[2] * u[0] - n[0] * u[2], n[0] * u[1] - n[1] * u[0]};
+        static const float CORNERS[4][2] = {{-0.5f, -0.5f}, {0.5f, -0.5f}, {0.5f, 0.5f}, {-0.5f, 0.5f}};
+        
+        unsigned int base = (unsigned int)(vertices.size() / 9);
+        for (int i = 0; i < 4; ++i)
+        {
+            float px = n[0] * 0.5f + u[0] * CORNERS[i][0] + v[0] * CORNERS[i][1];
+            float py = n[1] * 0.5f + u[1] * CORNERS[i][0] + v[1] * CORNERS[i][1];
+            float pz = n[2] * 0.5f + u[2] * CORNERS[i][0] + v[2] * CORNERS[i][1];
+            vertices.insert(vertices.end(), {px, py, pz, c[0], c[1], c[2], n[0], n[1], n[2]});
+        }
+        indices.insert(indices.end(), {base, base + 1, base + 2, base + 2, base + 3, base});
+    }
+    
+    return createMesh(vertices.data(), vertices.size() / 9, indices.data(), indices.size());
+}
+
+const LibraryMesh& MeshLibrary::getCube()
+{
+    if (!m_cube)
+    {
+        static const float WHITE[6][3] = {
+            {1.0f, 1.0f, 1.0f}, {1.0f, 1.0f, 1.0f}, {1.0f, 1.0f, 1.0f},
+            {1.0f, 1.0f, 1.0f}, {1.0f, 1.0f, 1.0f}, {1.0f, 1.0f, 1.0f}
+        };
+        m_cube = createCube(WHITE);
+    }
+    return *m_cube;
+}
+
+const LibraryMesh& MeshLibrary::getColoredCube()
+{
+    if (!m_coloredCube)
+    {
+        // Red front, green back, blue left, yellow right, cyan top, magenta bottom
+        static const float FACE_COLORS[6][3] = {
+            {1.0f, 0.0f, 0.0f}, {0.0f, 1.0f, 0.0f}, {0.0f, 0.0f, 1.0f},
+            {1.0f, 1.0f, 0.0f}, {0.0f, 1.0f, 1.0f}, {1.0f, 0.0f, 1.0f}
+        };
+        m_coloredCube = createCube(FACE_COLORS);
+    }
+    return *m_coloredCube;
+}
+
+void buildTorusMesh(MeshData& mesh, float outerRadius, float innerRadius,
+                    int majorSegments, int minorSegments, const float* color)
+{
+    mesh.vertices.reserve((majorSegments + 1) * (minorSegments + 1) * 9);
+    mesh.indices.reserve(majorSegments * minorSegments * 6);
+    
+    const float PI = 3.14159265359f;
+    float tubeRadius = (outerRadius - innerRadius) * 0.5f;
+    float torusRadius = innerRadius + tubeRadius;
+    
+    // Generate vertices
+    for (int i = 0; i <= majorSegments; ++i)
+    {
+        float theta = (float)i / majorSegments * 2.0f * PI;
+        float cosTheta = std::cos(theta);
+        float sinTheta = std::sin(theta);
+        
+        for (int j = 0; j <= minorSegments; ++j)
+        {
+            float phi = (float)j / minorSegments * 2.0f * PI;
+            float cosPhi = std::cos(phi);
+            float sinPhi = std::sin(phi);
+            
+            // Position
+            float x = (torusRadius + tubeRadius * cosPhi) * cosTheta;
+            float y = tubeRadius * sinPhi;
+            float z = (torusRadius + tubeRadius * cosPhi) * sinTheta;
+            
+            // Normal
+            float nx = cosPhi * cosTheta;
+            float ny = sinPhi;
+            float nz = cosPhi * sinTheta;
+            
+            // Color (gradient based on position using base color)
+            float colorVariation = (sinPhi + 1.0f) * 0.5f;
+            float r = color[0] * (0.7f + colorVariation * 0.3f);
+            float g = color[1] * (0.7f + colorVariation * 0.3f);
+            float b = color[2] * (0.7f + colorVariation * 0.3f);
+            
+            // Add vertex data: position (3) + color (3) + normal (3)
+            mesh.vertices.push_back(x);
+            mesh.vertices.push_back(y);
+            mesh.vertices.push_back(z);
+            mesh.vertices.push_back(r);
+            mesh.vertices.push_back(g);
+            mesh.vertices.push_back(b);
+            mesh.vertices.push_back(nx);
+            mesh.vertices.push_back(ny);
+            mesh.vertices.push_back(nz);
+        }
+    }
+    
+    // Generate indices
+    for (int i = 0; i < majorSegments; ++i)
+    {
+        for (int j = 0; j < minorSegments; ++j)
+        {
+            int first = i * (minorSegments + 1) + j;
+            int second = first + minorSegments + 1;
+            
+            // First triangle
+            mesh.indices.push_back(first);
+            mesh.indices.push_back(second);
+            mesh.indices.push_back(first + 1);
+            
+            // Second triangle
+            mesh.indices.push_back(second);
+            mesh.indices.push_back(second + 1);
+            mesh.indices.push_back(first + 1);
+        }
+    }
+    
+    // Position-only copy for the depth pre-pass, sharing the index buffer
+    size_t vertexCount = mesh.vertices.size() / 9;
+    mesh.positions.reserve(vertexCount * 3);
+    for (size_t i = 0; i < vertexCount; ++i)
+    {
+        mesh.positions.push_back(mesh.vertices[i * 9 + 0]);
+        mesh.positions.push_back(mesh.vertices[i * 9 + 1]);
+        mesh.positions.push_back(mesh.vertices[i * 9 + 2]);
+    }
+}
+
+const LibraryMesh& MeshLibrary::getTorus(float outerRadius, float innerRadius)
+{
+    uint32_t outerBits, innerBits;
+    std::memcpy(&outerBits, &outerRadius, sizeof(outerBits));
+    std::memcpy(&innerBits, &innerRadius, sizeof(innerBits));
+    uint64_t key = ((uint64_t)outerBits << 32) | innerBits;
+    
+    auto it = m_tori.find(key);
+    if (it != m_tori.end())
+        return *it->second;
+    
+    // White, the material color is multiplied in the shader
+    MeshData torus;
+    const float white[3] = {1.0f, 1.0f, 1.0f};
+    buildTorusMesh(torus, outerRadius, innerRadius, TORUS_MAJOR_SEGMENTS, TORUS_MINOR_SEGMENTS, white);
+    
+    std::unique_ptr<LibraryMesh>& mesh = m_tori[key];
+    mesh = createMesh(torus.vertices.data(), torus.getVertexCount(), torus.indices.data(), torus.indices.size());
+    return *mesh;
+}
+
+void MeshLibrary::cleanup()
+{
+    GLState& state = GLState::getInstance();
+    auto release = [&state](LibraryMesh& mesh)
+    {
+        state.deleteVertexArrays(1, &mesh.VAO);
+        state.deleteVertexArrays(1, &mesh.depthVAO);
+        state.deleteBuffers(1, &mesh.VBO);
+        state.deleteBuffers(1, &mesh.depthVBO);
+        state.deleteBuffers(1, &mesh.EBO);
+        mesh = LibraryMesh{};
+    };
+    
+    if (m_cube)
+        release(*m_cube);
+    m_cube.reset();
+    if (m_coloredCube)
+        release(*m_coloredCube);
+    m_coloredCube.reset();
+    for (auto& [key, mesh] : m_tori)
+    {
+        release(*mesh);
+    }
+    m_tori.clear();
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+// Silence OpenGL deprecation warnings on macOS
+#define GL_SILENCE_DEPRECATION
+
+#include <memory>
+#include <unordered_map>
+
+#include "mesh_builder.h"
+
+#if defined(__APPLE__)
+    #include <OpenGL/gl3.h>
+#else
+    #include <SDL3/SDL_opengl.h>
+#endif
+
+// GPU mesh shared by every object that references it. The vertex stream is
+// position, color, normal (9 floats), the depth stream position only; both
+// use the same index buffer. VAO and depthVAO bind them for plain draws.
+struct LibraryMesh
+{
+    GLuint VAO = 0;
+    GLuint depthVAO = 0;
+    GLuint VBO = 0;
+    GLuint depthVBO = 0;
+    GLuint EBO = 0;
+    GLsizei indexCount = 0;
+    float boundsMin[3] = {0.0f, 0.0f, 0.0f};
+    float boundsMax[3] = {0.0f, 0.0f, 0.0f};
+};
+
+// Segment counts of every torus, Donut's and the library's alike
+constexpr int TORUS_MAJOR_SEGMENTS = 48;   // around the major circle
+constexpr int TORUS_MINOR_SEGMENTS = 24;   // around the tube
+
+// Torus around the y axis with position (3) + color (3) + normal (3)
+// vertices and a position-only copy. Thread safe, no GL calls.
+void buildTorusMesh(MeshData& mesh, float outerRadius, float innerRadius,
+                    int majorSegments, int minorSegments, const float* color);
+
+// Builds each shape once and hands out the shared buffers (GL thread only)
+class MeshLibrary
+{
+public:
+    // Get singleton instance
+    static MeshLibrary& getInstance();
+    
+    // Delete copy constructor and assignment operator
+    MeshLibrary(const MeshLibrary&) = delete;
+    MeshLibrary& operator=(const MeshLibrary&) = delete;
+    
+    // Unit cube centered on the origin (white)
+    const LibraryMesh& getCube();
+    
+    // Unit cube with a different color per face, as drawn by Voxel
+    const LibraryMesh& getColoredCube();
+    
+    // Torus around the Y axis, radii as in Donut
+    const LibraryMesh& getTorus(float outerRadius, float innerRadius);
+    
+    // Release all meshes (call before the GL context goes away)
+    void cleanup();
+    
+private:
+    MeshLibrary() = default;
+    ~MeshLibrary() = default;
+    
+    // Cube with the given per-face colors (front, back, left, right, top, bottom)
+    std::unique_ptr<LibraryMesh> createCube(const float (*faceColors)[3]);
+    
+    // Upload interleaved vertices (9 floats each) and indices
+    std::unique_ptr<LibraryMesh> createMesh(const float* vertices, size_t vertexCount,
+                                            const unsigned int* indices, size_t indexCount);
+    
+    std::unique_ptr<LibraryMesh> m_cube;
+    std::unique_ptr<LibraryMesh> m_coloredCube;
+    std::unordered_map<uint64_t, std::unique_ptr<LibraryMesh>> m_tori;  // keyed by the radii bits
+};
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+// Lock-free FIFO for many producer threads and one consumer thread.
+// Producers push onto an atomic stack; the consumer takes the whole stack
+// with one exchange and reverses it into its private list, so neither side
+// ever waits on the other and there is no ABA problem.
+template<typename T>
+class MpscQueue
+{
+public:
+    MpscQueue()
+        : m_inbox(nullptr)
+        , m_head(nullptr)
+        , m_tail(nullptr)
+        , m_size(0)
+    {
+    }
+    
+    ~MpscQueue()
+    {
+        clear();
+    }
+    
+    // Delete copy constructor and assignment operator
+    MpscQueue(const MpscQueue&) = delete;
+    MpscQueue& operator=(const MpscQueue&) = delete;
+    
+    // Any thread
+    void push(T&& value)
+    {
+        Node* node = new Node{std::move(value), nullptr};
+        node->next = m_inbox.load(std::memory_order_relaxed);
+        while (!m_inbox.compare_exchange_weak(node->next, node, std::memory_order_release, std::memory_order_relaxed))
+        {
+        }
+        m_size.fetch_add(1, std::memory_order_relaxed);
+    }
+    
+    // Consumer thread only, false when empty
+    bool pop(T& value)
+    {
+        if (!m_head)
+            takeInbox();
+        if (!m_head)
+            return false;
+        
+        Node* node = m_head;
+        m_head = node->next;
+        if (!m_head)
+            m_tail = nullptr;
+        value = std::move(node->value);
+        delete node;
+        m_size.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+    }
+    
+    // Consumer thread only
+    void clear()
+    {
+        T value;
+        while (pop(value))
+        {
+        }
+    }
+    
+    // Approximate while producers are pushing
+    size_t size() const { return m_size.load(std::memory_order_relaxed); }
+    
+private:
+    struct Node
+    {
+        T value;
+        Node* next;
+    };
+    
+    void takeInbox()
+    {
+        // Newest first on the stack, reverse into push order
+        Node* node = m_inbox.exchange(nullptr, std::memory_order_acquire);
+        Node* reversed = nullptr;
+        Node* last = node;
+        while (node)
+        {
+            Node* next = node->next;
+            node->next = reversed;
+            reversed = node;
+            node = next;
+        }
+        if (!reversed)
+            return;
+        
+        if (m_tail)
+            m_tail->next = reversed;
+        else
+            m_head = reversed;
+        m_tail = last;
+    }
+    
+    std::atomic<Node*> m_inbox;     // pushed by producers, newest first
+    Node* m_head;                   // consumer's list, oldest first
+    Node* m_tail;
+    std::atomic<size_t> m_size;
+};
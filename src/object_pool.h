@@ -0,0 +1,190 @@
+#pragma once
+
+#include <cstddef>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <vector>
+
+// Pool of fixed-size blocks shared by all threads, one instance per block
+// size and alignment. Every thread keeps a small cache of free blocks, so
+// allocate() and deallocate() normally take no lock; caches refill from and
+// spill to the shared free list in batches. Memory is returned to the system
+// only when the pool is destroyed at exit.
+template<size_t BlockSize, size_t Alignment>
+class FixedBlockPool
+{
+public:
+    // Get singleton instance
+    static FixedBlockPool& getInstance()
+    {
+        static FixedBlockPool instance;
+        return instance;
+    }
+    
+    // Delete copy constructor and assignment operator
+    FixedBlockPool(const FixedBlockPool&) = delete;
+    FixedBlockPool& operator=(const FixedBlockPool&) = delete;
+    
+    void* allocate()
+    {
+        ThreadCache& cache = getCache();
+        if (!cache.head)
+            refill(cache);
+        
+        FreeBlock* block = cache.head;
+        cache.head = block->next;
+        cache.count--;
+        return block;
+    }
+    
+    // Blocks may be freed on any thread, not only the allocating one
+    void deallocate(void* pointer)
+    {
+        ThreadCache& cache = getCache();
+        FreeBlock* block = static_cast<FreeBlock*>(pointer);
+        block->next = cache.head;
+        cache.head = block;
+        if (++cache.count > CACHE_LIMIT)
+            spill(cache, CACHE_BATCH);
+    }
+    
+private:
+    struct FreeBlock
+    {
+        FreeBlock* next;
+    };
+    
+    static constexpr size_t ALIGNMENT = Alignment > alignof(FreeBlock) ? Alignment : alignof(FreeBlock);
+    static constexpr size_t BLOCK_BYTES = ((BlockSize > sizeof(FreeBlock) ? BlockSize : sizeof(FreeBlock)) + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+    static constexpr int BLOCKS_PER_PAGE = 64;
+    static constexpr int CACHE_BATCH = 16;
+    static constexpr int CACHE_LIMIT = CACHE_BATCH * 2;
+    
+    // Free blocks owned by one thread, handed back to the pool at thread exit
+    struct ThreadCache
+    {
+        FreeBlock* head = nullptr;
+        int count = 0;
+        
+        ~ThreadCache()
+        {
+            if (head)
+                getInstance().spill(*this, count);
+        }
+    };
+    
+    FixedBlockPool() = default;
+    
+    ~FixedBlockPool()
+    {
+        for (void* page : m_pages)
+        {
+            ::operator delete(page, std::align_val_t(ALIGNMENT));
+        }
+    }
+    
+    static ThreadCache& getCache()
+    {
+        thread_local ThreadCache cache;
+        return cache;
+    }
+    
+    // Take a batch from the shared list, or carve a new page
+    void refill(ThreadCache& cache)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_free)
+        {
+            char* page = static_cast<char*>(::operator new(BLOCK_BYTES * BLOCKS_PER_PAGE, std::align_val_t(ALIGNMENT)));
+            m_pages.push_back(page);
+            for (int i = 0; i < BLOCKS_PER_PAGE; ++i)
+            {
+                FreeBlock* block = reinterpret_cast<FreeBlock*>(page + i * BLOCK_BYTES);
+                block->next = m_free;
+                m_free = block;
+            }
+        }
+        
+        for (int i = 0; i < CACHE_BATCH && m_free; ++i)
+        {
+            FreeBlock* block = m_free;
+            m_free = block->next;
+            block->next = cache.head;
+            cache.head = block;
+            cache.count++;
+        }
+    }
+    
+    // Move count blocks from the cache to the shared list
+    void spill(ThreadCache& cache, int count)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (int i = 0; i < count && cache.head; ++i)
+        {
+            FreeBlock* block = cache.head;
+            cache.head = block->next;
+            cache.count--;
+            block->next = m_free;
+            m_free = block;
+        }
+    }
+    
+    std::mutex m_mutex;
+    FreeBlock* m_free = nullptr;
+    std::vector<void*> m_pages;
+};
+
+// Create and destroy objects of one type in their FixedBlockPool
+template<typename T>
+class ObjectPool
+{
+public:
+    using Blocks = FixedBlockPool<sizeof(T), alignof(T)>;
+    
+    template<typename... Args>
+    static T* create(Args&&... args)
+    {
+        void* memory = Blocks::getInstance().allocate();
+        return new (memory) T(std::forward<Args>(args)...);
+    }
+    
+    static void destroy(T* object)
+    {
+        if (!object)
+            return;
+        object->~T();
+        Blocks::getInstance().deallocate(object);
+    }
+};
+
+// Standard allocator serving single-object requests (container nodes) from
+// a FixedBlockPool; arrays (e.g. hash buckets) go to the heap
+template<typename T>
+class PoolAllocator
+{
+public:
+    using value_type = T;
+    
+    PoolAllocator() noexcept = default;
+    template<typename U>
+    PoolAllocator(const PoolAllocator<U>&) noexcept {}
+    
+    T* allocate(size_t count)
+    {
+        if (count == 1)
+            return static_cast<T*>(ObjectPool<T>::Blocks::getInstance().allocate());
+        return static_cast<T*>(::operator new(count * sizeof(T), std::align_val_t(alignof(T))));
+    }
+    
+    void deallocate(T* pointer, size_t count) noexcept
+    {
+        if (count == 1)
+            ObjectPool<T>::Blocks::getInstance().deallocate(pointer);
+        else
+            ::operator delete(pointer, std::align_val_t(alignof(T)));
+    }
+    
+    template<typename U>
+    bool operator==(const PoolAllocator<U>&) const { return true; }
+};
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <tuple>
+#include <utility>
+
+#include "slot_map.h"
+
+// Owns every runtime object, one SlotMap per type. Objects are referenced
+// through Handle<T> so creating and destroying them never leaves dangling
+// pointers; per-type iteration walks densely packed storage.
+template<typename... Types>
+class ObjectRegistry
+{
+public:
+    template<typename T, typename... Args>
+    Handle<T> create(Args&&... args)
+    {
+        return getStorage<T>().create(std::forward<Args>(args)...);
+    }
+    
+    template<typename T>
+    bool destroy(Handle<T> handle) { return getStorage<T>().destroy(handle); }
+    
+    template<typename T>
+    T* get(Handle<T> handle) { return getStorage<T>().get(handle); }
+    
+    template<typename T>
+    const T* get(Handle<T> handle) const { return getStorage<T>().get(handle); }
+    
+    template<typename T>
+    SlotMap<T>& getStorage() { return std::get<SlotMap<T>>(m_storage); }
+    
+    template<typename T>
+    const SlotMap<T>& getStorage() const { return std::get<SlotMap<T>>(m_storage); }
+    
+    // Visit fn(object) for every live object of every type
+    template<typename Fn>
+    void forEach(Fn&& fn)
+    {
+        std::apply([&](auto&... storages)
+        {
+            (visit(storages, fn), ...);
+        }, m_storage);
+    }
+    
+    // Destroy everything (objects release their GL resources, call on the GL thread)
+    void clear()
+    {
+        std::apply([](auto&... storages)
+        {
+            (storages.clear(), ...);
+        }, m_storage);
+    }
+    
+    size_t size() const
+    {
+        return std::apply([](const auto&... storages)
+        {
+            return (storages.size() + ... + 0);
+        }, m_storage);
+    }
+    
+private:
+    template<typename T, typename Fn>
+    static void visit(SlotMap<T>& storage, Fn& fn)
+    {
+        for (T& object : storage)
+        {
+            fn(object);
+        }
+    }
+    
+    std::tuple<SlotMap<Types>...> m_storage;
+};
@@ -0,0 +1,325 @@
+#include "occlusion_culler.h"
+#include "job_system.h"
+#include "libs/maths/matrix.h"
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define OCCLUSION_USE_SSE2
+    #include <emmintrin.h>
+#endif
+
+namespace
+{
+    // Triangles with a vertex this close to the camera plane are dropped
+    // (an occluder may only ever hide less than it really does)
+    const float MIN_CLIP_W = 1e-4f;
+}
+
+OcclusionCuller::OcclusionCuller()
+    : m_depth(WIDTH * HEIGHT, 1.0f)
+    , m_tileMaxDepth(TILES_X * TILES_Y, 1.0f)
+{
+    for (int i = 0; i < 16; ++i)
+    {
+        m_viewProjection[i] = (i % 5 == 0) ? 1.0f : 0.0f;
+    }
+}
+
+void OcclusionCuller::beginFrame(const float* viewMatrix, const float* projectionMatrix)
+{
+    multiplyMatrix(m_viewProjection, projectionMatrix, viewMatrix);
+    m_triangles.clear();
+}
+
+void OcclusionCuller::transformToClip(float* clip, const float* point, const float* modelMatrix) const
+{
+    const float* m = modelMatrix;
+    float wx = m[0] * point[0] + m[4] * point[1] + m[8] * point[2] + m[12];
+    float wy = m[1] * point[0] + m[5] * point[1] + m[9] * point[2] + m[13];
+    float wz = m[2] * point[0] + m[6] * point[1] + m[10] * point[2] + m[14];
+    
+    const float* vp = m_viewProjection;
+    clip[0] = vp[0] * wx + vp[4] * wy + vp[8] * wz + vp[12];
+    clip[1] = vp[1] * wx + vp[5] * wy + vp[9] * wz + vp[13];
+    clip[2] = vp[2] * wx + vp[6] * wy + vp[10] * wz + vp[14];
+    clip[3] = vp[3] * wx + vp[7] * wy + vp[11] * wz + vp[15];
+}
+
+void OcclusionCuller::addOccluder(const float* positions, const uint32_t* indices, int indexCount, const float* modelMatrix)
+{
+    for (int i = 0; i + 2 < indexCount; i += 3)
+    {
+        float a[4], b[4], c[4];
+        transformToClip(a, &positions[indices[i] * 3], modelMatrix);
+        transformToClip(b, &positions[indices[i + 1] * 3], modelMatrix);
+        transformToClip(c, &positions[indices[i + 2] * 3], modelMatrix);
+        addTriangle(a, b, c);
+    }
+}
+
+void OcclusionCuller::addBoxOccluder(const float* boundsMin, const float* boundsMax, const float* modelMatrix)
+{
+    // Corner i takes max on axis k when bit k is set
+    float corners[8][4];
+    for (int i = 0; i < 8; ++i)
+    {
+        float point[3] = {
+            (i & 1) ? boundsMax[0] : boundsMin[0],
+            (i & 2) ? boundsMax[1] : boundsMin[1],
+            (i & 4) ? boundsMax[2] : boundsMin[2]
+        };
+        transformToClip(corners[i], point, modelMatrix);
+    }
+    
+    // Two CCW (outward facing) triangles per face
+    static const int BOX_INDICES[36] = {
+        0, 2, 3,  3, 1, 0,   // -Z
+        4, 5, 7,  7, 6, 4,   // +Z
+        0, 4, 6,  6, 2, 0,   // -X
+        1, 3, 7,  7, 5, 1,   // +X
+        0, 1, 5,  5, 4, 0,   // -Y
+        2, 6, 7,  7, 3, 2    // +Y
+    };
+    for (int i = 0; i < 36; i += 3)
+    {
+        addTriangle(corners[BOX_INDICES[i]], corners[BOX_INDICES[i + 1]], corners[BOX_INDICES[i + 2]]);
+    }
+}
+
+void OcclusionCuller::addTriangle(const float* a, const float* b, const float* c)
+{
+    if (a[3] < MIN_CLIP_W || b[3] < MIN_CLIP_W || c[3] < MIN_CLIP_W)
+        return;
+    
+    ScreenTriangle tri;
+    const float* v[3] = {a, b, c};
+    for (int i = 0; i < 3; ++i)
+    {
+        float invW = 1.0f / v[i][3];
+        tri.x[i] = (v[i][0] * invW * 0.5f + 0.5f) * WIDTH;
+        tri.y[i] = (v[i][1] * invW * 0.5f + 0.5f) * HEIGHT;
+        tri.z[i] = v[i][2] * invW * 0.5f + 0.5f;
+    }
+    
+    // Back faces are always behind the front faces of a closed occluder
+    float area = (tri.x[1] - tri.x[0]) * (tri.y[2] - tri.y[0]) - (tri.x[2] - tri.x[0]) * (tri.y[1] - tri.y[0]);
+    if (area <= 0.0f)
+        return;
+    
+    // Pixel centers sit at +0.5, bounds cover the pixels whose centers may be inside
+    float minX = std::min({tri.x[0], tri.x[1], tri.x[2]});
+    float maxX = std::max({tri.x[0], tri.x[1], tri.x[2]});
+    float minY = std::min({tri.y[0], tri.y[1], tri.y[2]});
+    float maxY = std::max({tri.y[0], tri.y[1], tri.y[2]});
+    tri.minX = std::max((int)std::floor(minX - 0.5f) + 1, 0);
+    tri.maxX = std::min((int)std::ceil(maxX - 0.5f) - 1, WIDTH - 1);
+    tri.minY = std::max((int)std::floor(minY - 0.5f) + 1, 0);
+    tri.maxY = std::min((int)std::ceil(maxY - 0.5f) - 1, HEIGHT - 1);
+    if (tri.minX > tri.maxX || tri.minY > tri.maxY)
+        return;
+    
+    // Nothing to hide beyond the far plane
+    if (std::min({tri.z[0], tri.z[1], tri.z[2]}) >= 1.0f)
+        return;
+    
+    m_triangles.push_back(tri);
+}
+
+void OcclusionCuller::rasterize()
+{
+    // Bands own disjoint rows and tile rows, so jobs never share memory
+    int bandCount = (HEIGHT + BAND_HEIGHT - 1) / BAND_HEIGHT;
+    JobSystem::getInstance().parallelFor(bandCount, 1, [this](int begin, int end)
+    {
+        for (int band = begin; band < end; ++band)
+        {
+            int y0 = band * BAND_HEIGHT;
+            int y1 = std::min(y0 + BAND_HEIGHT, HEIGHT);
+            rasterizeBand(y0, y1);
+            updateTiles(y0 / TILE_SIZE, y1 / TILE_SIZE);
+        }
+    });
+}
+
+void OcclusionCuller::rasterizeBand(int bandY0, int bandY1)
+{
+    std::fill(m_depth.begin() + bandY0 * WIDTH, m_depth.begin() + bandY1 * WIDTH, 1.0f);
+    
+    for (const ScreenTriangle& tri : m_triangles)
+    {
+        if (tri.maxY < bandY0 || tri.minY >= bandY1)
+            continue;
+        rasterizeTriangle(tri, std::max(tri.minY, bandY0), std::min(tri.maxY + 1, bandY1));
+    }
+}
+
+void OcclusionCuller::rasterizeTriangle(const ScreenTriangle& tri, int rowBegin, int rowEnd)
+{
+    // Edge functions e = A * x + B * y + C, non-negative inside (CCW)
+    float edgeA[3], edgeB[3], edgeC[3];
+    for (int i = 0; i < 3; ++i)
+    {
+        int j = (i + 1) % 3;
+        edgeA[i] = tri.y[i] - tri.y[j];
+        edgeB[i] = tri.x[j] - tri.x[i];
+        edgeC[i] = tri.x[i] * tri.y[j] - tri.x[j] * tri.y[i];
+    }
+    
+    // Depth is affine in screen space: z = z0 + dzdx * (x - x0) + dzdy * (y - y0)
+    float area = edgeC[0] + edgeC[1] + edgeC[2];
+    float dzdx = (tri.z[0] * edgeA[1] + tri.z[1] * edgeA[2] + tri.z[2] * edgeA[0]) / area;
+    float dzdy = (tri.z[0] * edgeB[1] + tri.z[1] * edgeB[2] + tri.z[2] * edgeB[0]) / area;
+    float zOrigin = tri.z[0] - dzdx * tri.x[0] - dzdy * tri.y[0];
+    
+    // Process whole groups of 4 pixels, the column bounds mask the rest
+    int startX = tri.minX & ~3;
+
+#ifdef OCCLUSION_USE_SSE2
+    const __m128 laneOffsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+    const __m128i laneIndices = _mm_setr_epi32(0, 1, 2, 3);
+    const __m128i minColumn = _mm_set1_epi32(tri.minX - 1);
+    const __m128i maxColumn = _mm_set1_epi32(tri.maxX + 1);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 a0 = _mm_set1_ps(edgeA[0]), a1 = _mm_set1_ps(edgeA[1]), a2 = _mm_set1_ps(edgeA[2]);
+    const __m128 dzdx4 = _mm_set1_ps(dzdx);
+    
+    for (int y = rowBegin; y < rowEnd; ++y)
+    {
+        float py = y + 0.5f;
+        __m128 rowE0 = _mm_set1_ps(edgeB[0] * py + edgeC[0]);
+        __m128 rowE1 = _mm_set1_ps(edgeB[1] * py + edgeC[1]);
+        __m128 rowE2 = _mm_set1_ps(edgeB[2] * py + edgeC[2]);
+        __m128 rowZ = _mm_set1_ps(zOrigin + dzdy * py);
+        float* row = &m_depth[y * WIDTH];
+        
+        for (int x = startX; x <= tri.maxX; x += 4)
+        {
+            __m128 px = _mm_add_ps(_mm_set1_ps((float)x), laneOffsets);
+            __m128 e0 = _mm_add_ps(_mm_mul_ps(a0, px), rowE0);
+            __m128 e1 = _mm_add_ps(_mm_mul_ps(a1, px), rowE1);
+            __m128 e2 = _mm_add_ps(_mm_mul_ps(a2, px), rowE2);
+            __m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(e0, zero), _mm_cmpge_ps(e1, zero)),
+                                       _mm_cmpge_ps(e2, zero));
+            
+            __m128i column = _mm_add_epi32(_mm_set1_epi32(x), laneIndices);
+            __m128i inColumns = _mm_and_si128(_mm_cmpgt_epi32(column, minColumn), _mm_cmplt_epi32(column, maxColumn));
+            inside = _mm_and_ps(inside, _mm_castsi128_ps(inColumns));
+            if (_mm_movemask_ps(inside) == 0)
+                continue;
+            
+            // Keep the nearest depth where the triangle covers the pixel
+            __m128 depth = _mm_add_ps(_mm_mul_ps(dzdx4, px), rowZ);
+            __m128 stored = _mm_loadu_ps(row + x);
+            __m128 nearest = _mm_min_ps(stored, depth);
+            _mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, nearest), _mm_andnot_ps(inside, stored)));
+        }
+    }
+#else
+    for (int y = rowBegin; y < rowEnd; ++y)
+    {
+        float py = y + 0.5f;
+        float* row = &m_depth[y * WIDTH];
+        
+        for (int x = startX; x <= tri.maxX; ++x)
+        {
+            if (x < tri.minX)
+                continue;
+            
+            float px = x + 0.5f;
+            if (edgeA[0] * px + edgeB[0] * py + edgeC[0] < 0.0f ||
+                edgeA[1] * px + edgeB[1] * py + edgeC[1] < 0.0f ||
+                edgeA[2] * px + edgeB[2] * py + edgeC[2] < 0.0f)
+                continue;
+            
+            float depth = zOrigin + dzdx * px + dzdy * py;
+            row[x] = std::min(row[x], depth);
+        }
+    }
+#endif
+}
+
+void OcclusionCuller::updateTiles(int tileRowBegin, int tileRowEnd)
+{
+    for (int ty = tileRowBegin; ty < tileRowEnd; ++ty)
+    {
+        for (int tx = 0; tx < TILES_X; ++tx)
+        {
+            float maxDepth = 0.0f;
+            for (int y = ty * TILE_SIZE; y < (ty + 1) * TILE_SIZE; ++y)
+            {
+                const float* row = &m_depth[y * WIDTH + tx * TILE_SIZE];
+                for (int x = 0; x < TILE_SIZE; ++x)
+                {
+                    maxDepth = std::max(maxDepth, row[x]);
+                }
+            }
+            m_tileMaxDepth[ty * TILES_X + tx] = maxDepth;
+        }
+    }
+}
+
+bool OcclusionCuller::isVisible(const float* boundsMin, const float* boundsMax, const float* modelMatrix) const
+{
+    float minX = 1e30f, maxX = -1e30f;
+    float minY = 1e30f, maxY = -1e30f;
+    float nearestDepth = 1e30f;
+    
+    for (int i = 0; i < 8; ++i)
+    {
+        float point[3] = {
+            (i & 1) ? boundsMax[0] : boundsMin[0],
+            (i & 2) ? boundsMax[1] : boundsMin[1],
+            (i & 4) ? boundsMax[2] : boundsMin[2]
+        };
+        float clip[4];
+        transformToClip(clip, point, modelMatrix);
+        
+        // Crossing the camera plane: the screen bounds are unbounded
+        if (clip[3] < MIN_CLIP_W)
+            return true;
+        
+        float invW = 1.0f / clip[3];
+        float sx = (clip[0] * invW * 0.5f + 0.5f) * WIDTH;
+        float sy = (clip[1] * invW * 0.5f + 0.5f) * HEIGHT;
+        minX = std::min(minX, sx);
+        maxX = std::max(maxX, sx);
+        minY = std::min(minY, sy);
+        maxY = std::max(maxY, sy);
+        nearestDepth = std::min(nearestDepth, clip[2] * invW * 0.5f + 0.5f);
+    }
+    
+    // Outside the view
+    if (maxX < 0.0f || minX > WIDTH || maxY < 0.0f || minY > HEIGHT || nearestDepth > 1.0f)
+        return false;
+    
+    // Pixel rectangle touched by the bounds, grown by one pixel to stay conservative
+    int x0 = std::max((int)std::floor(minX) - 1, 0);
+    int x1 = std::min((int)std::ceil(maxX) + 1, WIDTH - 1);
+    int y0 = std::max((int)std::floor(minY) - 1, 0);
+    int y1 = std::min((int)std::ceil(maxY) + 1, HEIGHT - 1);
+    
+    for (int ty = y0 / TILE_SIZE; ty <= y1 / TILE_SIZE; ++ty)
+    {
+        for (int tx = x0 / TILE_SIZE; tx <= x1 / TILE_SIZE; ++tx)
+        {
+            // Whole tile in front of the object's nearest point
+            if (nearestDepth > m_tileMaxDepth[ty * TILES_X + tx])
+                continue;
+            
+            // Otherwise check the covered pixels of this tile
+            int px0 = std::max(x0, tx * TILE_SIZE), px1 = std::min(x1, tx * TILE_SIZE + TILE_SIZE - 1);
+            int py0 = std::max(y0, ty * TILE_SIZE), py1 = std::min(y1, ty * TILE_SIZE + TILE_SIZE - 1);
+            for (int y = py0; y <= py1; ++y)
+            {
+                const float* row = &m_depth[y * WIDTH];
+                for (int x = px0; x <= px1; ++x)
+                {
+                    if (nearestDepth <= row[x])
+                        return true;
+                }
+            }
+        }
+    }
+    return false;
+}
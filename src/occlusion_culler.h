@@ -0,0 +1,68 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+// Software occlusion culling, CPU only (no GL calls, usable headless).
+// Occluders are rasterized into a small depth buffer with a max-depth
+// hierarchy on top; candidates are tested by their screen-space bounds.
+// Depth is NDC z remapped to [0, 1], rows run bottom to top like GL.
+class OcclusionCuller
+{
+public:
+    // Depth buffer resolution and hierarchy tile size
+    static constexpr int WIDTH = 256;
+    static constexpr int HEIGHT = 144;
+    static constexpr int TILE_SIZE = 8;
+    static constexpr int TILES_X = WIDTH / TILE_SIZE;
+    static constexpr int TILES_Y = HEIGHT / TILE_SIZE;
+    
+    // Rows rasterized by one job, a multiple of TILE_SIZE
+    static constexpr int BAND_HEIGHT = 16;
+    
+    OcclusionCuller();
+    
+    // Start a frame: clear occluders and depth, set the camera
+    void beginFrame(const float* viewMatrix, const float* projectionMatrix);
+    
+    // Add an indexed triangle mesh occluder (positions xyz, CCW front faces)
+    void addOccluder(const float* positions, const uint32_t* indices, int indexCount, const float* modelMatrix);
+    
+    // Add a solid box occluder given in local space
+    void addBoxOccluder(const float* boundsMin, const float* boundsMax, const float* modelMatrix);
+    
+    // Rasterize all occluders and build the depth hierarchy (multithreaded)
+    void rasterize();
+    
+    // Whether a local-space box may be visible; false when it is fully
+    // hidden behind occluders or outside the view. Safe to call from
+    // several threads after rasterize().
+    bool isVisible(const float* boundsMin, const float* boundsMax, const float* modelMatrix) const;
+    
+    // Debug access
+    const float* getDepthBuffer() const { return m_depth.data(); }
+    const float* getTileDepths() const { return m_tileMaxDepth.data(); }
+    int getTriangleCount() const { return (int)m_triangles.size(); }
+    
+private:
+    // Occluder triangle in screen space, front facing with positive area
+    struct ScreenTriangle
+    {
+        float x[3], y[3], z[3];
+        int minX, maxX, minY, maxY;
+    };
+    
+    void addTriangle(const float* a, const float* b, const float* c);
+    void rasterizeBand(int bandY0, int bandY1);
+    void rasterizeTriangle(const ScreenTriangle& tri, int rowBegin, int rowEnd);
+    void updateTiles(int tileRowBegin, int tileRowEnd);
+    
+    // Transform a point to clip space with model then view-projection
+    void transformToClip(float* clip, const float* point, const float* modelMatrix) const;
+    
+    float m_viewProjection[16];
+    
+    std::vector<ScreenTriangle> m_triangles;
+    std::vector<float> m_depth;          // WIDTH * HEIGHT, nearest occluder depth
+    std::vector<float> m_tileMaxDepth;   // TILES_X * TILES_Y, farthest depth per tile
+};
@@ -0,0 +1,188 @@
+#include "palette_chunk.h"
+#include <algorithm>
+#include <unordered_map>
+
+PaletteChunk::PaletteChunk()
+    : m_palette(1, BLOCK_AIR)
+    , m_bits(0)
+{
+}
+
+int PaletteChunk::bitsForPaletteSize(size_t size)
+{
+    if (size <= 1) return 0;
+    if (size <= 2) return 1;
+    if (size <= 4) return 2;
+    if (size <= 16) return 4;
+    if (size <= 256) return 8;
+    return 16;
+}
+
+void PaletteChunk::set(int x, int y, int z, BlockId block)
+{
+    auto it = std::find(m_palette.begin(), m_palette.end(), block);
+    uint32_t index = (uint32_t)(it - m_palette.begin());
+    if (it == m_palette.end())
+    {
+        m_palette.push_back(block);
+        int bits = bitsForPaletteSize(m_palette.size());
+        if (bits != m_bits)
+            repack(bits);
+    }
+    setIndex(chunkCellIndex(x, y, z), index);
+}
+
+void PaletteChunk::setIndex(int cell, uint32_t index)
+{
+    if (m_bits == 0)
+        return;
+    
+    int perWord = 64 / m_bits;
+    int shift = (cell % perWord) * m_bits;
+    uint64_t mask = ((1ull << m_bits) - 1) << shift;
+    uint64_t& word = m_words[cell / perWord];
+    word = (word & ~mask) | (((uint64_t)index << shift) & mask);
+}
+
+void PaletteChunk::repack(int bits)
+{
+    std::vector<uint32_t> indices(CHUNK_CELLS);
+    for (int cell = 0; cell < CHUNK_CELLS; ++cell)
+    {
+        indices[cell] = getIndex(cell);
+    }
+    
+    m_bits = bits;
+    m_words.assign(bits == 0 ? 0 : CHUNK_CELLS * bits / 64, 0);
+    for (int cell = 0; cell < CHUNK_CELLS; ++cell)
+    {
+        setIndex(cell, indices[cell]);
+    }
+}
+
+bool PaletteChunk::reset(const BlockId* palette, int paletteSize, int bits)
+{
+    if (paletteSize < 1 || bits != bitsForPaletteSize(paletteSize))
+        return false;
+    
+    m_palette.assign(palette, palette + paletteSize);
+    m_bits = bits;
+    m_words.resize(bits == 0 ? 0 : CHUNK_CELLS * bits / 64);
+    return true;
+}
+
+bool PaletteChunk::validate() const
+{
+    // Only widths with spare codes can hold out-of-range indices
+    if (m_bits == 0 || (size_t)1 << m_bits == m_palette.size())
+        return true;
+    
+    bool valid = true;
+    for (int cell = 0; cell < CHUNK_CELLS && valid; ++cell)
+    {
+        valid = getIndex(cell) < m_palette.size();
+    }
+    return valid;
+}
+
+void PaletteChunk::fromDense(const BlockId* blocks)
+{
+    // Palette in order of first appearance
+    std::unordered_map<BlockId, uint32_t> lookup;
+    m_palette.clear();
+    for (int cell = 0; cell < CHUNK_CELLS; ++cell)
+    {
+        if (lookup.emplace(blocks[cell], (uint32_t)m_palette.size()).second)
+            m_palette.push_back(blocks[cell]);
+    }
+    
+    m_bits = bitsForPaletteSize(m_palette.size());
+    m_words.assign(m_bits == 0 ? 0 : CHUNK_CELLS * m_bits / 64, 0);
+    if (m_bits == 0)
+        return;
+    
+    BlockId previous = blocks[0];
+    uint32_t index = lookup[previous];
+    for (int cell = 0; cell < CHUNK_CELLS; ++cell)
+    {
+        if (blocks[cell] != previous)
+        {
+            previous = blocks[cell];
+            index = lookup[previous];
+        }
+        setIndex(cell, index);
+    }
+}
+
+void PaletteChunk::toDense(BlockId* blocks) const
+{
+    forEachRun([&](int first, int count, BlockId block)
+    {
+        std::fill(blocks + first, blocks + first + count, block);
+    });
+}
+
+void PaletteChunk::fromOctree(const VoxelOctree& octree)
+{
+    std::vector<BlockId> blocks(CHUNK_CELLS, BLOCK_AIR);
+    for (const VoxelOctree::Leaf& leaf : octree.leaves())
+    {
+        for (int y = leaf.y; y < leaf.y + leaf.sizeY; ++y)
+        {
+            for (int z = leaf.z; z < leaf.z + leaf.sizeZ; ++z)
+            {
+                BlockId* row = &blocks[chunkCellIndex(0, y, z)];
+                std::fill(row + leaf.x, row + leaf.x + leaf.sizeX, leaf.block);
+            }
+        }
+    }
+    fromDense(blocks.data());
+}
+
+void PaletteChunk::toOctree(VoxelOctree& octree) const
+{
+    octree.clear();
+    
+    // One fill per run, split at row ends (runs may wrap to the next row)
+    forEachRun([&](int first, int count, BlockId block)
+    {
+        if (block == BLOCK_AIR)
+            return;
+        
+        int cell = first, end = first + count;
+        while (cell < end)
+        {
+            int x = cell % CHUNK_SIZE;
+            int row = cell / CHUNK_SIZE;
+            int z = row % CHUNK_SIZE;
+            int y = row / CHUNK_SIZE;
+            int length = std::min(end - cell, CHUNK_SIZE - x);
+            
+            int runMin[3] = {x, y, z};
+            int runMax[3] = {x + length, y + 1, z + 1};
+            octree.fill(runMin, runMax, block);
+            cell += length;
+        }
+    });
+}
+
+size_t PaletteChunk::getMemoryUsage() const
+{
+    return sizeof(*this) + m_palette.capacity() * sizeof(BlockId) + m_words.capacity() * sizeof(uint64_t);
+}
+
+int PaletteChunk::getSolidLayers() const
+{
+    // y varies slowest in cell order, so the non-air prefix of the runs
+    // covers whole layers from the bottom up
+    int solidCells = 0;
+    bool prefix = true;
+    forEachRun([&](int firstCell, int cellCount, BlockId block)
+    {
+        if (prefix && block != BLOCK_AIR)
+            solidCells = firstCell + cellCount;
+        else
+            prefix = false;
+    });
+    return solidCells / (CHUNK_SIZE * CHUNK_SIZE);
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+#include "voxel_octree.h"
+#include "chunk_codec.h"
+
+// Compact chunk storage: a palette of the block types present and one
+// palette index per cell, bit-packed at 0, 1, 2, 4, 8 or 16 bits. A chunk
+// with a single block type stores no indices at all. Cells are ordered as
+// in chunkCellIndex(), the packed words are little-endian bit streams.
+class PaletteChunk
+{
+public:
+    PaletteChunk();
+    
+    // Point access
+    BlockId get(int x, int y, int z) const { return m_palette[getIndex(chunkCellIndex(x, y, z))]; }
+    void set(int x, int y, int z, BlockId block);
+    
+    // Conversions
+    void fromOctree(const VoxelOctree& octree);
+    void toOctree(VoxelOctree& octree) const;
+    void fromDense(const BlockId* blocks);
+    void toDense(BlockId* blocks) const;
+    
+    // Visit runs of equal blocks in cell order without expanding:
+    // fn(firstCell, cellCount, block). Whole words that continue the
+    // current run are skipped with a single compare.
+    template<typename Fn>
+    void forEachRun(Fn&& fn) const
+    {
+        if (m_bits == 0)
+        {
+            fn(0, CHUNK_CELLS, m_palette[0]);
+            return;
+        }
+        
+        const int perWord = 64 / m_bits;
+        const uint64_t mask = (m_bits == 64) ? ~0ull : ((1ull << m_bits) - 1);
+        const uint64_t spread = ~0ull / mask;   // 0x0101... for 8 bits
+        
+        uint32_t current = (uint32_t)(m_words[0] & mask);
+        int start = 0;
+        for (size_t w = 0; w < m_words.size(); ++w)
+        {
+            uint64_t word = m_words[w];
+            if (word == current * spread)
+                continue;
+            
+            int cell = (int)w * perWord;
+            for (int slot = 0; slot < perWord; ++slot, ++cell)
+            {
+                uint32_t index = (uint32_t)((word >> (slot * m_bits)) & mask);
+                if (index != current)
+                {
+                    fn(start, cell - start, m_palette[current]);
+                    start = cell;
+                    current = index;
+                }
+            }
+        }
+        fn(start, CHUNK_CELLS - start, m_palette[current]);
+    }
+    
+    // Palette and packed indices, used by the codec
+    const std::vector<BlockId>& getPalette() const { return m_palette; }
+    int getBitsPerBlock() const { return m_bits; }
+    const uint8_t* getPackedData() const { return reinterpret_cast<const uint8_t*>(m_words.data()); }
+    size_t getPackedSize() const { return m_words.size() * sizeof(uint64_t); }
+    
+    // Replace the contents with a palette and uninitialized packed storage to
+    // be filled through getPackedDataForWrite(); false if bits is not valid
+    bool reset(const BlockId* palette, int paletteSize, int bits);
+    uint8_t* getPackedDataForWrite() { return reinterpret_cast<uint8_t*>(m_words.data()); }
+    
+    // Whether every packed index points into the palette
+    bool validate() const;
+    
+    // Bits needed for a palette of the given size (0, 1, 2, 4, 8 or 16)
+    static int bitsForPaletteSize(size_t size);
+    
+    size_t getMemoryUsage() const;
+    
+    // Number of fully solid layers from the bottom (y = 0) up
+    int getSolidLayers() const;
+    
+private:
+    uint32_t getIndex(int cell) const
+    {
+        if (m_bits == 0)
+            return 0;
+        int perWord = 64 / m_bits;
+        uint64_t word = m_words[cell / perWord];
+        return (uint32_t)((word >> ((cell % perWord) * m_bits)) & ((1ull << m_bits) - 1));
+    }
+    void setIndex(int cell, uint32_t index);
+    
+    // Re-pack at a new width, keeping all indices
+    void repack(int bits);
+    
+    std::vector<BlockId> m_palette;
+    int m_bits;
+    std::vector<uint64_t> m_words;
+};
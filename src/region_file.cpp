@@ -0,0 +1,108 @@
+#include "region_file.h"
+#include "atomic_file.h"
+#include <cstring>
+
+namespace
+{
+    constexpr uint32_t REGION_MAGIC = 0x47525347; // "GSRG"
+    constexpr uint32_t REGION_VERSION = 1;
+    
+    struct RegionHeader
+    {
+        uint32_t magic;
+        uint32_t version;
+    };
+}
+
+bool RegionFile::open(const std::string& path)
+{
+    m_table.clear();
+    if (!m_file.open(path))
+        return false;
+    
+    size_t tableBytes = CHUNKS_PER_REGION * sizeof(TableEntry);
+    size_t dataStart = sizeof(RegionHeader) + tableBytes;
+    
+    RegionHeader header;
+    bool valid = m_file.getSize() >= dataStart;
+    if (valid)
+    {
+        std::memcpy(&header, m_file.getData(), sizeof(header));
+        valid = header.magic == REGION_MAGIC && header.version == REGION_VERSION;
+    }
+    
+    if (valid)
+    {
+        m_table.resize(CHUNKS_PER_REGION);
+        std::memcpy(m_table.data(), m_file.getData() + sizeof(RegionHeader), tableBytes);
+        
+        // Reject tables pointing outside the file
+        for (const TableEntry& entry : m_table)
+        {
+            if (entry.offset != 0 && (entry.offset < dataStart || (size_t)entry.offset + entry.size > m_file.getSize()))
+            {
+                valid = false;
+                break;
+            }
+        }
+    }
+    
+    if (!valid)
+    {
+        m_table.clear();
+        m_file.close();
+    }
+    return valid;
+}
+
+bool RegionFile::getChunk(int localX, int localZ, const uint8_t*& data, size_t& size) const
+{
+    if (!isOpen() || localX < 0 || localZ < 0 || localX >= REGION_SIZE || localZ >= REGION_SIZE)
+        return false;
+    
+    const TableEntry& entry = m_table[localZ * REGION_SIZE + localX];
+    if (entry.offset == 0)
+        return false;
+    
+    data = m_file.getData() + entry.offset;
+    size = entry.size;
+    return true;
+}
+
+bool RegionFile::write(const std::string& path, const std::vector<std::vector<uint8_t>>& chunks)
+{
+    if ((int)chunks.size() != CHUNKS_PER_REGION)
+        return false;
+    
+    RegionHeader header = {REGION_MAGIC, REGION_VERSION};
+    std::vector<TableEntry> table(CHUNKS_PER_REGION, TableEntry{0, 0});
+    
+    uint32_t offset = (uint32_t)(sizeof(RegionHeader) + CHUNKS_PER_REGION * sizeof(TableEntry));
+    for (int i = 0; i < CHUNKS_PER_REGION; ++i)
+    {
+        if (chunks[i].empty())
+            continue;
+        table[i] = {offset, (uint32_t)chunks[i].size()};
+        offset += (uint32_t)chunks[i].size();
+    }
+    
+    // offset is now the total size, one buffer holds the whole region
+    std::vector<uint8_t> bytes;
+    bytes.reserve(offset);
+    const uint8_t* headerBytes = reinterpret_cast<const uint8_t*>(&header);
+    bytes.insert(bytes.end(), headerBytes, headerBytes + sizeof(header));
+    const uint8_t* tableBytes = reinterpret_cast<const uint8_t*>(table.data());
+    bytes.insert(bytes.end(), tableBytes, tableBytes + table.size() * sizeof(TableEntry));
+    for (const std::vector<uint8_t>& chunk : chunks)
+    {
+        bytes.insert(bytes.end(), chunk.begin(), chunk.end());
+    }
+    return writeFileAtomically(path, bytes);
+}
+
+std::string RegionFile::getFileName(int chunkX, int chunkZ)
+{
+    char fileName[48];
+    std::snprintf(fileName, sizeof(fileName), "r.%d.%d.region", toRegion(chunkX), toRegion(chunkZ));
+    return fileName;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+#include "mapped_file.h"
+
+// Region file: REGION_SIZE x REGION_SIZE chunk columns packed into one file.
+//   header  "GSRG", version
+//   table   REGION_SIZE^2 entries of (offset, size), offset 0 = chunk absent
+//   data    encoded chunks, back to back
+class RegionFile
+{
+public:
+    static constexpr int REGION_SIZE = 16;
+    static constexpr int CHUNKS_PER_REGION = REGION_SIZE * REGION_SIZE;
+    
+    // Map a region file and validate its offset table
+    bool open(const std::string& path);
+    bool isOpen() const { return m_file.isOpen(); }
+    
+    // Encoded bytes of a chunk inside the mapping, false if absent.
+    // The pointer stays valid while the RegionFile is alive.
+    bool getChunk(int localX, int localZ, const uint8_t*& data, size_t& size) const;
+    
+    // Write a region, chunks holds CHUNKS_PER_REGION blobs (empty = absent)
+    // indexed by localZ * REGION_SIZE + localX
+    static bool write(const std::string& path, const std::vector<std::vector<uint8_t>>& chunks);
+    
+    // File name of the region holding chunk column (chunkX, chunkZ)
+    static std::string getFileName(int chunkX, int chunkZ);
+    
+    // Region coordinate of a chunk coordinate (floor division)
+    static int toRegion(int chunk) { return chunk >= 0 ? chunk / REGION_SIZE : (chunk - REGION_SIZE + 1) / REGION_SIZE; }
+    
+private:
+    struct TableEntry
+    {
+        uint32_t offset;
+        uint32_t size;
+    };
+    
+    MappedFile m_file;
+    std::vector<TableEntry> m_table;
+};
@@ -0,0 +1,177 @@
+// Silence OpenGL deprecation warnings on macOS
+#define GL_SILENCE_DEPRECATION
+
+#include "render_queue.h"
+#include "render_stats.h"
+#include "gl_state.h"
+#include <algorithm>
+
+void RenderQueue::sortFrontToBack(const float* viewMatrix)
+{
+    // Distance in front of the camera: -(view * origin).z
+    for (DrawItem& item : m_items)
+    {
+        const float* m = item.modelMatrix;
+        item.viewDepth = -(viewMatrix[2] * m[12] + viewMatrix[6] * m[13] + viewMatrix[10] * m[14] + viewMatrix[14]);
+    }
+    
+    // Grouped by program first: interleaving programs by depth would rebind
+    // them and rerun their per-program setup for almost every item
+    std::sort(m_items.begin(), m_items.end(), [](const DrawItem& a, const DrawItem& b)
+    {
+        if (a.program != b.program)
+            return a.program < b.program;
+        return a.viewDepth < b.viewDepth;
+    });
+}
+
+void RenderQueue::renderDepth(GLuint depthProgram, const float* viewMatrix, const float* projectionMatrix) const
+{
+    if (depthProgram == 0 || m_items.empty())
+        return;
+    
+    GLState& state = GLState::getInstance();
+    state.colorMask(false);
+    state.depthMask(true);
+    state.depthFunc(GL_LESS);
+    
+    RenderStats& stats = RenderStats::getInstance();
+    GLuint currentProgram = 0;
+    GLint modelLoc = -1;
+    
+    for (const DrawItem& item : m_items)
+    {
+        GLuint program = (item.depthProgram != 0) ? item.depthProgram : depthProgram;
+        if (program != currentProgram)
+        {
+            currentProgram = program;
+            state.useProgram(currentProgram);
+            modelLoc = glGetUniformLocation(currentProgram, "model");
+            glUniformMatrix4fv(glGetUniformLocation(currentProgram, "view"), 1, GL_FALSE, viewMatrix);
+            glUniformMatrix4fv(glGetUniformLocation(currentProgram, "projection"), 1, GL_FALSE, projectionMatrix);
+            stats.countUniforms(2);
+        }
+        
+        state.bindVertexArray(item.depthVao);
+        if (item.instanceCount > 0)
+        {
+            glDrawElementsInstanced(GL_TRIANGLES, item.indexCount, GL_UNSIGNED_INT, 0, item.instanceCount);
+            stats.countDraw(item.indexCount, item.instanceCount);
+        }
+        else
+        {
+            glUniformMatrix4fv(modelLoc, 1, GL_FALSE, item.modelMatrix);
+            glDrawElements(GL_TRIANGLES, item.indexCount, GL_UNSIGNED_INT, 0);
+            stats.countUniforms(1);
+            stats.countDraw(item.indexCount);
+        }
+    }
+    
+    state.colorMask(true);
+}
+
+void RenderQueue::renderIds(GLuint idProgram, GLuint instancedProgram, const float* viewMatrix,
+                            const float* projectionMatrix) const
+{
+    if (idProgram == 0 || m_items.empty())
+        return;
+    
+    GLState& state = GLState::getInstance();
+    state.depthMask(true);
+    state.depthFunc(GL_LESS);
+    
+    RenderStats& stats = RenderStats::getInstance();
+    GLuint currentProgram = 0;
+    GLint modelLoc = -1;
+    GLint idLoc = -1;
+    
+    for (const DrawItem& item : m_items)
+    {
+        // Instanced items only occlude, skipped until their program is ready
+        GLuint program = (item.instanceCount > 0) ? instancedProgram : idProgram;
+        if (program == 0)
+            continue;
+        if (program != currentProgram)
+        {
+            currentProgram = program;
+            state.useProgram(currentProgram);
+            modelLoc = glGetUniformLocation(currentProgram, "model");
+            idLoc = glGetUniformLocation(currentProgram, "objectId");
+            glUniformMatrix4fv(glGetUniformLocation(currentProgram, "view"), 1, GL_FALSE, viewMatrix);
+            glUniformMatrix4fv(glGetUniformLocation(currentProgram, "projection"), 1, GL_FALSE, projectionMatrix);
+            stats.countUniforms(2);
+        }
+        
+        state.bindVertexArray(item.depthVao);
+        if (item.instanceCount > 0)
+        {
+            glUniform1ui(idLoc, 0);
+            glDrawElementsInstanced(GL_TRIANGLES, item.indexCount, GL_UNSIGNED_INT, 0, item.instanceCount);
+            stats.countUniforms(1);
+            stats.countDraw(item.indexCount, item.instanceCount);
+        }
+        else
+        {
+            glUniform1ui(idLoc, item.pickId);
+            glUniformMatrix4fv(modelLoc, 1, GL_FALSE, item.modelMatrix);
+            glDrawElements(GL_TRIANGLES, item.indexCount, GL_UNSIGNED_INT, 0);
+            stats.countUniforms(2);
+            stats.countDraw(item.indexCount);
+        }
+    }
+}
+
+void RenderQueue::renderItems(const float* viewMatrix, const float* projectionMatrix, bool depthEqual,
+                              SetupFunction setupProgram, void* context) const
+{
+    GLState& state = GLState::getInstance();
+    if (depthEqual)
+    {
+        state.depthFunc(GL_EQUAL);
+        state.depthMask(false);
+    }
+    
+    RenderStats& stats = RenderStats::getInstance();
+    GLuint currentProgram = 0;
+    GLint modelLoc = -1;
+    GLint normalLoc = -1;
+    
+    for (const DrawItem& item : m_items)
+    {
+        // Per-program state is only set when the program changes
+        if (item.program != currentProgram)
+        {
+            currentProgram = item.program;
+            state.useProgram(currentProgram);
+            
+            modelLoc = glGetUniformLocation(currentProgram, "model");
+            normalLoc = glGetUniformLocation(currentProgram, "normalMatrix");
+            glUniformMatrix4fv(glGetUniformLocation(currentProgram, "view"), 1, GL_FALSE, viewMatrix);
+            glUniformMatrix4fv(glGetUniformLocation(currentProgram, "projection"), 1, GL_FALSE, projectionMatrix);
+            stats.countUniforms(2);
+            
+            setupProgram(context, currentProgram);
+        }
+        
+        state.bindVertexArray(item.vao);
+        if (item.instanceCount > 0)
+        {
+            glDrawElementsInstanced(GL_TRIANGLES, item.indexCount, GL_UNSIGNED_INT, 0, item.instanceCount);
+            stats.countDraw(item.indexCount, item.instanceCount);
+        }
+        else
+        {
+            glUniformMatrix4fv(modelLoc, 1, GL_FALSE, item.modelMatrix);
+            glUniformMatrix3fv(normalLoc, 1, GL_FALSE, item.normalMatrix);
+            glDrawElements(GL_TRIANGLES, item.indexCount, GL_UNSIGNED_INT, 0);
+            stats.countUniforms(2);
+            stats.countDraw(item.indexCount);
+        }
+    }
+    
+    if (depthEqual)
+    {
+        state.depthFunc(GL_LESS);
+        state.depthMask(true);
+    }
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+// Silence OpenGL deprecation warnings on macOS
+#define GL_SILENCE_DEPRECATION
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#if defined(__APPLE__)
+    #include <OpenGL/gl3.h>
+#else
+    #include <SDL3/SDL_opengl.h>
+#endif
+
+// One indexed opaque draw, referencing the owner's GL objects and matrices
+struct DrawItem
+{
+    GLuint program = 0;       // lit program
+    GLuint vao = 0;           // full vertex layout (position, color, normal)
+    GLuint depthVao = 0;      // position-only stream for the depth pre-pass
+    GLsizei indexCount = 0;
+    GLsizei instanceCount = 0;  // > 0 draws instanced, the VAO supplies the model matrices
+    GLuint depthProgram = 0;    // pre-pass program override (instanced variant), 0 = the pass's program
+    const float* modelMatrix = nullptr;
+    const float* normalMatrix = nullptr;
+    uint32_t pickId = 0;      // written by the ID pass, 0 = occludes but can't be picked
+    float viewDepth = 0.0f;   // set by sortFrontToBack
+};
+
+// Per-frame list of opaque draws with optional depth pre-pass and sorting
+class RenderQueue
+{
+public:
+    // Remove all items (keeps the allocation)
+    void clear() { m_items.clear(); }
+    
+    void add(const DrawItem& item) { m_items.push_back(item); }
+    size_t size() const { return m_items.size(); }
+    
+    // Group items by program, nearest first within each program by the view
+    // depth of their origin
+    void sortFrontToBack(const float* viewMatrix);
+    
+    // Depth-only pass: color writes off, position-only stream, trivial shader
+    void renderDepth(GLuint depthProgram, const float* viewMatrix, const float* projectionMatrix) const;
+    
+    // Object ID pass into an integer target: every item writes its pickId
+    // (instanced items use instancedProgram and write 0)
+    void renderIds(GLuint idProgram, GLuint instancedProgram, const float* viewMatrix, const float* projectionMatrix) const;
+    
+    // Lit pass. With depthEqual the pre-pass depth is reused (GL_EQUAL, no depth
+    // writes) so every pixel is shaded once. setupProgram(program) runs on
+    // program changes and is called through a pointer (no std::function).
+    template<typename SetupFn>
+    void render(const float* viewMatrix, const float* projectionMatrix, bool depthEqual,
+                SetupFn&& setupProgram) const
+    {
+        using Callable = std::remove_reference_t<SetupFn>;
+        renderItems(viewMatrix, projectionMatrix, depthEqual, [](void* context, GLuint program)
+        {
+            (*static_cast<Callable*>(context))(program);
+        }, const_cast<void*>(static_cast<const void*>(&setupProgram)));
+    }
+    
+private:
+    using SetupFunction = void (*)(void* context, GLuint program);
+    
+    void renderItems(const float* viewMatrix, const float* projectionMatrix, bool depthEqual,
+                     SetupFunction setupProgram, void* context) const;
+    
+    std::vector<DrawItem> m_items;
+};
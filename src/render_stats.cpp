@@ -0,0 +1,101 @@
+#include "render_stats.h"
+
+#include <algorithm>
+
+#include <SDL3/SDL.h>
+
+RenderStats& RenderStats::getInstance()
+{
+    static RenderStats instance;
+    return instance;
+}
+
+RenderStats::RenderStats()
+    : m_bufferBytes(0)
+    , m_exportStart(0)
+    , m_intervalStart(0)
+    , m_intervalMilliseconds(1000)
+    , m_intervalFrames(0)
+    , m_exportedLines(0)
+{
+}
+
+void RenderStats::endFrame()
+{
+    m_current.bufferBytes = m_bufferBytes.exchange(0, std::memory_order_relaxed);
+    m_lastFrame = m_current;
+    m_current = RenderCounters();
+    
+    if (!m_exportFile.is_open())
+        return;
+    
+    m_intervalTotals.drawCalls += m_lastFrame.drawCalls;
+    m_intervalTotals.instances += m_lastFrame.instances;
+    m_intervalTotals.triangles += m_lastFrame.triangles;
+    m_intervalTotals.programBinds += m_lastFrame.programBinds;
+    m_intervalTotals.vertexArrayBinds += m_lastFrame.vertexArrayBinds;
+    m_intervalTotals.uniformUploads += m_lastFrame.uniformUploads;
+    m_intervalTotals.bufferBytes += m_lastFrame.bufferBytes;
+    m_intervalTotals.culledObjects += m_lastFrame.culledObjects;
+    m_intervalFrames++;
+    
+    uint64_t now = SDL_GetTicks();
+    if (now - m_intervalStart >= m_intervalMilliseconds)
+        writeInterval(now);
+}
+
+bool RenderStats::startExport(const std::string& path, float intervalSeconds)
+{
+    stopExport();
+    
+    m_exportFile.open(path, std::ios::trunc);
+    if (!m_exportFile)
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Couldn't write render stats to %s", path.c_str());
+        m_exportFile.close();
+        return false;
+    }
+    
+    m_exportPath = path;
+    m_exportStart = SDL_GetTicks();
+    m_intervalStart = m_exportStart;
+    m_intervalMilliseconds = (uint64_t)(std::max(intervalSeconds, 0.01f) * 1000.0f);
+    m_intervalTotals = RenderCounters();
+    m_intervalFrames = 0;
+    m_exportedLines = 0;
+    return true;
+}
+
+void RenderStats::stopExport()
+{
+    if (!m_exportFile.is_open())
+        return;
+    
+    // The partial interval still holds measured frames
+    if (m_intervalFrames > 0)
+        writeInterval(SDL_GetTicks());
+    m_exportFile.close();
+}
+
+void RenderStats::writeInterval(uint64_t now)
+{
+    // Formatted into a fixed buffer, exporting must not allocate per frame
+    double frames = (double)m_intervalFrames;
+    char line[512];
+    int length = SDL_snprintf(line, sizeof(line),
+        "{\"time\":%.3f,\"frames\":%d,\"drawCalls\":%.1f,\"instances\":%.1f,\"triangles\":%.1f,"
+        "\"programBinds\":%.1f,\"vertexArrayBinds\":%.1f,\"uniformUploads\":%.1f,\"bufferBytes\":%.1f,"
+        "\"culledObjects\":%.1f}\n",
+        (double)(now - m_exportStart) / 1000.0, m_intervalFrames,
+        m_intervalTotals.drawCalls / frames, m_intervalTotals.instances / frames,
+        m_intervalTotals.triangles / frames, m_intervalTotals.programBinds / frames,
+        m_intervalTotals.vertexArrayBinds / frames, m_intervalTotals.uniformUploads / frames,
+        m_intervalTotals.bufferBytes / frames, m_intervalTotals.culledObjects / frames);
+    m_exportFile.write(line, std::min(length, (int)sizeof(line) - 1));
+    m_exportFile.flush();
+    
+    m_intervalStart = now;
+    m_intervalTotals = RenderCounters();
+    m_intervalFrames = 0;
+    m_exportedLines++;
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <string>
+#include <fstream>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+// Renderer work of one frame
+struct RenderCounters
+{
+    uint64_t drawCalls = 0;
+    uint64_t instances = 0;         // non-instanced draws count one
+    uint64_t triangles = 0;
+    uint64_t programBinds = 0;      // issued by GLState, redundant ones never reach GL
+    uint64_t vertexArrayBinds = 0;  // likewise, unbinds aren't counted
+    uint64_t uniformUploads = 0;    // glUniform* calls
+    uint64_t bufferBytes = 0;       // glBufferData / glBufferSubData sources
+    uint64_t culledObjects = 0;
+};
+
+// Counters incremented next to the GL calls they count, so a regression such
+// as a per-object glUseProgram shows up as a number. endFrame() closes a
+// frame; the export appends one JSON object per interval to a file (JSON
+// lines), averaged per frame. Counting is GL thread only except for buffer
+// uploads, which the loader thread makes too.
+class RenderStats
+{
+public:
+    // Get singleton instance
+    static RenderStats& getInstance();
+    
+    // Delete copy constructor and assignment operator
+    RenderStats(const RenderStats&) = delete;
+    RenderStats& operator=(const RenderStats&) = delete;
+    
+    // Counting
+    void countDraw(int indexCount, int instanceCount = 1)
+    {
+        m_current.drawCalls++;
+        m_current.instances += (uint64_t)instanceCount;
+        m_current.triangles += (uint64_t)(indexCount / 3) * (uint64_t)instanceCount;
+    }
+    void countProgramBind() { m_current.programBinds++; }
+    void countVertexArrayBind() { m_current.vertexArrayBinds++; }
+    void countUniforms(int count = 1) { m_current.uniformUploads += (uint64_t)count; }
+    void countCulled(int count) { m_current.culledObjects += (uint64_t)count; }
+    void countBufferUpload(size_t bytes) { m_bufferBytes.fetch_add(bytes, std::memory_order_relaxed); }
+    
+    // Close the frame: its counters become getLastFrame() and feed the export
+    void endFrame();
+    const RenderCounters& getLastFrame() const { return m_lastFrame; }
+    
+    // Append averages every intervalSeconds to path (truncated), false when
+    // it can't be opened
+    bool startExport(const std::string& path, float intervalSeconds);
+    void stopExport();
+    bool isExporting() const { return m_exportFile.is_open(); }
+    const std::string& getExportPath() const { return m_exportPath; }
+    int getExportedLines() const { return m_exportedLines; }
+    
+private:
+    RenderStats();
+    ~RenderStats() = default;
+    
+    void writeInterval(uint64_t now);
+    
+    RenderCounters m_current;
+    RenderCounters m_lastFrame;
+    std::atomic<uint64_t> m_bufferBytes;
+    
+    // Export
+    std::ofstream m_exportFile;
+    std::string m_exportPath;
+    uint64_t m_exportStart;         // milliseconds
+    uint64_t m_intervalStart;
+    uint64_t m_intervalMilliseconds;
+    RenderCounters m_intervalTotals;
+    int m_intervalFrames;
+    int m_exportedLines;
+};
@@ -0,0 +1,121 @@
+#include "scene_file.h"
+#include "atomic_file.h"
+#include <cstring>
+
+namespace
+{
+    constexpr uint32_t SCENE_MAGIC = 0x43535347; // "GSSC"
+    constexpr uint64_t SECTION_ALIGNMENT = 16;
+    
+    uint64_t alignSection(uint64_t offset)
+    {
+        return (offset + SECTION_ALIGNMENT - 1) & ~(SECTION_ALIGNMENT - 1);
+    }
+    
+    // Whether [offset, offset + count * elementSize) is aligned and inside the file
+    bool isSectionValid(uint64_t offset, uint64_t count, uint64_t elementSize, uint64_t fileSize)
+    {
+        return offset % SECTION_ALIGNMENT == 0 && offset <= fileSize &&
+               count <= (fileSize - offset) / elementSize;
+    }
+}
+
+bool SceneFile::open(const std::string& path)
+{
+    close();
+    if (!m_file.open(path))
+        return false;
+    
+    uint64_t size = m_file.getSize();
+    bool valid = size >= sizeof(SceneHeader);
+    if (valid)
+    {
+        std::memcpy(&m_header, m_file.getData(), sizeof(m_header));
+        valid = m_header.magic == SCENE_MAGIC && m_header.version == VERSION &&
+                isSectionValid(m_header.meshOffset, m_header.meshCount, sizeof(SceneMesh), size) &&
+                isSectionValid(m_header.materialOffset, m_header.materialCount, sizeof(SceneMaterial), size) &&
+                isSectionValid(m_header.transformOffset, m_header.objectCount, sizeof(SceneTransform), size) &&
+                isSectionValid(m_header.materialIdOffset, m_header.objectCount, sizeof(uint32_t), size);
+    }
+    
+    // Mesh ranges must stay inside the object arrays; material ids are
+    // clamped by the shader, so they aren't scanned here
+    if (valid)
+    {
+        const SceneMesh* meshes = getMeshes();
+        for (uint32_t i = 0; i < m_header.meshCount && valid; ++i)
+        {
+            valid = meshes[i].firstObject <= m_header.objectCount &&
+                    meshes[i].objectCount <= m_header.objectCount - meshes[i].firstObject;
+        }
+    }
+    
+    if (!valid)
+        close();
+    return valid;
+}
+
+void SceneFile::close()
+{
+    m_file.close();
+    m_header = SceneHeader{};
+}
+
+bool SceneFile::write(const std::string& path, const SceneData& scene)
+{
+    uint32_t meshCount = (uint32_t)scene.meshes.size();
+    uint32_t materialCount = (uint32_t)scene.materials.size();
+    uint32_t objectCount = (uint32_t)scene.objects.size();
+    
+    // Counting sort of the objects by mesh, stable within a mesh
+    std::vector<SceneMesh> meshes = scene.meshes;
+    std::vector<uint32_t> cursor(meshCount, 0);
+    for (const SceneData::Object& object : scene.objects)
+    {
+        if (object.mesh >= meshCount || object.material >= materialCount)
+            return false;
+        cursor[object.mesh]++;
+    }
+    uint32_t first = 0;
+    for (uint32_t i = 0; i < meshCount; ++i)
+    {
+        meshes[i].firstObject = first;
+        meshes[i].objectCount = cursor[i];
+        cursor[i] = first;
+        first += meshes[i].objectCount;
+    }
+    
+    std::vector<SceneTransform> transforms(objectCount);
+    std::vector<uint32_t> materialIds(objectCount);
+    for (const SceneData::Object& object : scene.objects)
+    {
+        uint32_t slot = cursor[object.mesh]++;
+        transforms[slot] = object.transform;
+        materialIds[slot] = object.material;
+    }
+    
+    SceneHeader header{};
+    header.magic = SCENE_MAGIC;
+    header.version = VERSION;
+    header.objectCount = objectCount;
+    header.meshCount = meshCount;
+    header.materialCount = materialCount;
+    header.meshOffset = alignSection(sizeof(SceneHeader));
+    header.materialOffset = alignSection(header.meshOffset + meshCount * sizeof(SceneMesh));
+    header.transformOffset = alignSection(header.materialOffset + materialCount * sizeof(SceneMaterial));
+    header.materialIdOffset = alignSection(header.transformOffset + (uint64_t)objectCount * sizeof(SceneTransform));
+    
+    // Sections are copied to their offsets, the gaps stay zero padding
+    std::vector<uint8_t> bytes(header.materialIdOffset + (uint64_t)objectCount * sizeof(uint32_t));
+    auto writeSection = [&](uint64_t offset, const void* data, size_t size)
+    {
+        if (size > 0)
+            std::memcpy(bytes.data() + offset, data, size);
+    };
+    writeSection(0, &header, sizeof(header));
+    writeSection(header.meshOffset, meshes.data(), meshes.size() * sizeof(SceneMesh));
+    writeSection(header.materialOffset, scene.materials.data(), scene.materials.size() * sizeof(SceneMaterial));
+    writeSection(header.transformOffset, transforms.data(), transforms.size() * sizeof(SceneTransform));
+    writeSection(header.materialIdOffset, materialIds.data(), materialIds.size() * sizeof(uint32_t));
+    return writeFileAtomically(path, bytes);
+}
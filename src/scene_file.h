@@ -0,0 +1,115 @@
+#pragma once
+
+#include <bit>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+#include "mapped_file.h"
+
+// Binary scene, little-endian, every section 16-byte aligned and read in
+// place from the mapping:
+//   SceneHeader
+//   SceneMesh[meshCount]           mesh references, each owning a range of objects
+//   SceneMaterial[materialCount]
+//   SceneTransform[objectCount]    objects grouped by mesh
+//   uint32_t[objectCount]          material index per object
+// Transforms can be uploaded as an instance buffer without any conversion.
+// Sections are used in host byte order, so only little-endian hosts can read
+// or write the format.
+static_assert(std::endian::native == std::endian::little, "SceneFile maps little-endian data in place");
+
+// Shape of a mesh reference, built by the MeshLibrary
+enum SceneMeshKind : uint32_t
+{
+    SCENE_MESH_CUBE = 0,    // unit cube centered on the origin
+    SCENE_MESH_TORUS = 1    // params: outer radius, inner radius
+};
+
+struct SceneMesh
+{
+    uint32_t kind;          // SceneMeshKind
+    uint32_t firstObject;   // objects [firstObject, firstObject + objectCount) use this mesh
+    uint32_t objectCount;
+    float params[2];
+    uint32_t reserved;
+};
+
+struct SceneMaterial
+{
+    float color[3];
+    float reserved;
+};
+
+// Column-major model matrix (rotation and uniform scale, then translation)
+struct SceneTransform
+{
+    float model[16];
+};
+
+struct SceneHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t objectCount;
+    uint32_t meshCount;
+    uint32_t materialCount;
+    uint32_t reserved;
+    uint64_t meshOffset;
+    uint64_t materialOffset;
+    uint64_t transformOffset;
+    uint64_t materialIdOffset;
+};
+
+static_assert(sizeof(SceneMesh) == 24, "SceneMesh layout is part of the file format");
+static_assert(sizeof(SceneMaterial) == 16, "SceneMaterial layout is part of the file format");
+static_assert(sizeof(SceneTransform) == 64, "SceneTransform layout is part of the file format");
+static_assert(sizeof(SceneHeader) == 56, "SceneHeader layout is part of the file format");
+
+// Scene contents on the writing side, objects in any order
+struct SceneData
+{
+    struct Object
+    {
+        SceneTransform transform;
+        uint32_t mesh;
+        uint32_t material;
+    };
+    
+    std::vector<SceneMesh> meshes;          // kind and params, ranges are filled on write
+    std::vector<SceneMaterial> materials;
+    std::vector<Object> objects;
+};
+
+// Memory mapped scene file. open() only validates the header and ranges;
+// the arrays are used straight from the mapping.
+class SceneFile
+{
+public:
+    static constexpr uint32_t VERSION = 1;
+    
+    bool open(const std::string& path);
+    void close();
+    bool isOpen() const { return m_file.isOpen(); }
+    
+    // Views into the mapping, valid while the file is open
+    uint32_t getObjectCount() const { return m_header.objectCount; }
+    uint32_t getMeshCount() const { return m_header.meshCount; }
+    uint32_t getMaterialCount() const { return m_header.materialCount; }
+    const SceneMesh* getMeshes() const { return section<SceneMesh>(m_header.meshOffset); }
+    const SceneMaterial* getMaterials() const { return section<SceneMaterial>(m_header.materialOffset); }
+    const SceneTransform* getTransforms() const { return section<SceneTransform>(m_header.transformOffset); }
+    const uint32_t* getMaterialIds() const { return section<uint32_t>(m_header.materialIdOffset); }
+    
+    // Group objects by mesh and write the file (temporary file, then rename).
+    // Fails on I/O errors or out of range mesh and material indices.
+    static bool write(const std::string& path, const SceneData& scene);
+    
+private:
+    template<typename T>
+    const T* section(uint64_t offset) const { return reinterpret_cast<const T*>(m_file.getData() + offset); }
+    
+    MappedFile m_file;
+    SceneHeader m_header{};
+};
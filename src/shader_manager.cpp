@@ -2,10 +2,77 @@
 #define GL_SILENCE_DEPRECATION
 
 #include "shader_manager.h"
+#include "atomic_file.h"
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
 #include <fstream>
 #include <sstream>
+#include <string>
+#include <vector>
 #include <SDL3/SDL.h>
 
+// KHR_parallel_shader_compile / ARB_parallel_shader_compile
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+#ifndef APIENTRY
+#define APIENTRY
+#endif
+
+namespace
+{
+    // Header written in front of every cached program binary
+    struct ProgramBinaryHeader
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint64_t key;
+        uint32_t binaryFormat;
+        uint32_t binaryLength;
+    };
+    
+    constexpr uint32_t PROGRAM_BINARY_MAGIC = 0x42505347; // "GSPB"
+    constexpr uint32_t PROGRAM_BINARY_VERSION = 1;
+    
+    // Cache entries not loaded or stored for this long are deleted (SDL_Time is in ns)
+    constexpr SDL_Time BINARY_CACHE_MAX_AGE = SDL_NS_PER_SECOND * 60 * 60 * 24 * 30;
+    
+    typedef void (APIENTRY* MaxShaderCompilerThreadsFn)(GLuint count);
+    
+    // Unlit program drawn until a requested program has finished linking
+    const char* FALLBACK_VERTEX_SOURCE = R"(#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aColor;
+
+out vec3 vertexColor;
+
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+
+invariant gl_Position;
+
+void main()
+{
+    gl_Position = projection * view * model * vec4(aPos, 1.0);
+    vertexColor = aColor;
+}
+)";
+    
+    const char* FALLBACK_FRAGMENT_SOURCE = R"(#version 330 core
+in vec3 vertexColor;
+
+out vec4 FragColor;
+
+void main()
+{
+    FragColor = vec4(vertexColor * 0.6, 1.0);
+}
+)";
+}
+
 ShaderManager& ShaderManager::getInstance()
 {
     static ShaderManager instance;
@@ -17,43 +84,183 @@ ShaderManager::~ShaderManager()
     cleanup();
 }
 
-std::string ShaderManager::makeCacheKey(const std::string& vertexPath, const std::string& fragmentPath)
+ShaderPathId ShaderManager::registerShaderPath(const std::string& path)
 {
-    return vertexPath + "|" + fragmentPath;
+    auto it = m_pathIds.find(path);
+    if (it != m_pathIds.end())
+    {
+        return it->second;
+    }
+    
+    ShaderPathId id = (ShaderPathId)m_paths.size();
+    m_paths.push_back(path);
+    m_pathIds[path] = id;
+    return id;
 }
 
-GLuint ShaderManager::getShaderProgram(const std::string& vertexPath, const std::string& fragmentPath)
+ShaderHandle ShaderManager::requestShaderProgram(const std::string& vertexPath, const std::string& fragmentPath,
+                                                 const ShaderDefines& defines)
 {
-    // Check if shader program is already cached
-    std::string cacheKey = makeCacheKey(vertexPath, fragmentPath);
+    return requestShaderProgram(registerShaderPath(vertexPath), registerShaderPath(fragmentPath), defines);
+}
+
+ShaderHandle ShaderManager::requestShaderProgram(ShaderPathId vertexPath, ShaderPathId fragmentPath,
+                                                 const ShaderDefines& defines)
+{
+    if (vertexPath >= m_paths.size() || fragmentPath >= m_paths.size())
+        return INVALID_SHADER_HANDLE;
     
-    auto it = m_shaderCache.find(cacheKey);
-    if (it != m_shaderCache.end())
+    // Check if this variant was already requested
+    ShaderHandle handle = makeShaderHandle(vertexPath, fragmentPath, defines);
+    
+    auto it = m_programs.find(handle);
+    if (it != m_programs.end())
     {
-        // Return cached shader program
-        return it->second;
+        const ProgramEntry& existing = it->second;
+        if (existing.vertexPath != vertexPath || existing.fragmentPath != fragmentPath ||
+            existing.defines.hash() != defines.hash())
+        {
+            // Handing out the existing handle would draw with the other variant
+            SDL_LogError(SDL_LOG_CATEGORY_RENDER, "Shader handle collision between %s and %s",
+                         describeProgram(existing).c_str(), m_paths[vertexPath].c_str());
+            return INVALID_SHADER_HANDLE;
+        }
+        return handle;
+    }
+    
+    if (!m_compilerInitialized)
+    {
+        initializeCompiler();
     }
     
-    // Create new shader program
-    GLuint program = createShaderProgram(vertexPath.c_str(), fragmentPath.c_str());
+    // Submit compile and link without waiting for the result
+    ProgramEntry& entry = m_programs[handle];
+    entry.vertexPath = vertexPath;
+    entry.fragmentPath = fragmentPath;
+    entry.defines = defines;
+    submitProgram(entry);
+    
+    return handle;
+}
+
+GLuint ShaderManager::getProgram(ShaderHandle handle)
+{
+    auto it = m_programs.find(handle);
+    if (it == m_programs.end())
+        return 0;
+    
+    const ProgramEntry& entry = it->second;
+    if (entry.state == ProgramState::Ready)
+        return entry.program;
+    
+    return getFallbackProgram();
+}
+
+bool ShaderManager::isProgramReady(ShaderHandle handle) const
+{
+    auto it = m_programs.find(handle);
+    return it != m_programs.end() && it->second.state == ProgramState::Ready;
+}
+
+void ShaderManager::update()
+{
+    // Without the parallel compile extension the status query blocks until the
+    // driver is done, so finish at most one program per frame to spread the cost
+    int blockingBudget = 1;
     
-    if (program != 0)
+    for (auto& pair : m_programs)
+    {
+        ProgramEntry& entry = pair.second;
+        if (entry.state != ProgramState::Pending)
+            continue;
+        
+        if (m_parallelCompile)
+        {
+            GLint completed = GL_FALSE;
+            glGetProgramiv(entry.program, GL_COMPLETION_STATUS_KHR, &completed);
+            if (!completed)
+                continue;
+        }
+        else if (blockingBudget-- <= 0)
+        {
+            break;
+        }
+        
+        finalizeProgram(entry);
+    }
+}
+
+bool ShaderManager::hasPendingPrograms() const
+{
+    for (const auto& pair : m_programs)
+    {
+        if (pair.second.state == ProgramState::Pending)
+            return true;
+    }
+    return false;
+}
+
+void ShaderManager::setBinaryCacheDirectory(const std::string& directory)
+{
+    m_binaryCacheDir = directory;
+    if (!m_binaryCacheDir.empty() && m_binaryCacheDir.back() != '/' && m_binaryCacheDir.back() != '\\')
     {
-        // Cache the shader program
-        m_shaderCache[cacheKey] = program;
+        m_binaryCacheDir += '/';
     }
     
-    return program;
+    if (!m_binaryCacheDir.empty() && !SDL_CreateDirectory(m_binaryCacheDir.c_str()))
+    {
+        SDL_Log("Shader binary cache disabled, can't create %s: %s", m_binaryCacheDir.c_str(), SDL_GetError());
+        m_binaryCacheDir.clear();
+    }
 }
 
 void ShaderManager::cleanup()
 {
-    // Delete all shader programs
-    for (auto& pair : m_shaderCache)
+    pruneBinaryCache();
+    
+    // Delete all shader programs, including ones still compiling
+    for (auto& pair : m_programs)
     {
-        glDeleteProgram(pair.second);
+        ProgramEntry& entry = pair.second;
+        if (entry.vertexShader != 0)
+            glDeleteShader(entry.vertexShader);
+        if (entry.fragmentShader != 0)
+            glDeleteShader(entry.fragmentShader);
+        if (entry.program != 0)
+            glDeleteProgram(entry.program);
+    }
+    m_programs.clear();
+    
+    if (m_fallbackProgram != 0)
+    {
+        glDeleteProgram(m_fallbackProgram);
+        m_fallbackProgram = 0;
+    }
+    m_fallbackBuilt = false;
+}
+
+void ShaderManager::initializeCompiler()
+{
+    m_compilerInitialized = true;
+    m_parallelCompile = SDL_GL_ExtensionSupported("GL_KHR_parallel_shader_compile")
+                     || SDL_GL_ExtensionSupported("GL_ARB_parallel_shader_compile");
+    
+    if (m_parallelCompile)
+    {
+        // Let the driver choose how many compiler threads to use
+        MaxShaderCompilerThreadsFn maxShaderCompilerThreads =
+            reinterpret_cast<MaxShaderCompilerThreadsFn>(SDL_GL_GetProcAddress("glMaxShaderCompilerThreadsKHR"));
+        if (!maxShaderCompilerThreads)
+        {
+            maxShaderCompilerThreads =
+                reinterpret_cast<MaxShaderCompilerThreadsFn>(SDL_GL_GetProcAddress("glMaxShaderCompilerThreadsARB"));
+        }
+        if (maxShaderCompilerThreads)
+        {
+            maxShaderCompilerThreads(0xFFFFFFFFu);
+        }
     }
-    m_shaderCache.clear();
 }
 
 std::string ShaderManager::readShaderFile(const char* filepath)
@@ -61,9 +268,7 @@ std::string ShaderManager::readShaderFile(const char* filepath)
     std::ifstream file(filepath);
     if (!file.is_open())
     {
-        char errorMsg[256];
-        SDL_snprintf(errorMsg, sizeof(errorMsg), "Failed to open shader file: %s", filepath);
-        SDL_ShowSimpleMessageBox(SDL_MESSAGEBOX_ERROR, "Shader Load Error", errorMsg, NULL);
+        SDL_LogError(SDL_LOG_CATEGORY_RENDER, "Failed to open shader file: %s", filepath);
         return "";
     }
     
@@ -72,56 +277,414 @@ std::string ShaderManager::readShaderFile(const char* filepath)
     return buffer.str();
 }
 
+std::string ShaderManager::loadShaderSource(const std::string& path, const ShaderDefines& defines)
+{
+    std::string source;
+    std::unordered_set<std::string> included;
+    if (!resolveIncludes(path, source, included, 0))
+    {
+        return "";
+    }
+    
+    if (defines.size() == 0)
+    {
+        return source;
+    }
+    
+    // Defines must follow the #version directive, which has to come first
+    std::string defineBlock;
+    for (int i = 0; i < defines.size(); ++i)
+    {
+        defineBlock += "#define ";
+        defineBlock += defines[i].name;
+        defineBlock += "\n";
+    }
+    
+    size_t versionPos = source.find("#version");
+    if (versionPos == std::string::npos)
+    {
+        return defineBlock + "#line 1\n" + source;
+    }
+    
+    size_t lineEnd = source.find('\n', versionPos);
+    if (lineEnd == std::string::npos)
+    {
+        return source + "\n" + defineBlock;
+    }
+    
+    // Count lines up to #version so compiler messages keep the original numbering
+    int versionLine = 1;
+    for (size_t i = 0; i < lineEnd; ++i)
+    {
+        if (source[i] == '\n')
+            versionLine++;
+    }
+    
+    return source.substr(0, lineEnd + 1) + defineBlock +
+           "#line " + std::to_string(versionLine + 1) + "\n" + source.substr(lineEnd + 1);
+}
+
+bool ShaderManager::resolveIncludes(const std::string& path, std::string& output,
+                                    std::unordered_set<std::string>& included, int depth)
+{
+    const int MAX_INCLUDE_DEPTH = 16;
+    if (depth > MAX_INCLUDE_DEPTH)
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_RENDER, "Shader include depth exceeded at %s", path.c_str());
+        return false;
+    }
+    
+    // Each file is pasted once, which also breaks include cycles
+    if (!included.insert(path).second)
+    {
+        return true;
+    }
+    
+    std::string source = readShaderFile(path.c_str());
+    if (source.empty())
+    {
+        return false;
+    }
+    
+    // Includes are resolved relative to the including file
+    size_t slash = path.find_last_of("/\\");
+    std::string directory = (slash != std::string::npos) ? path.substr(0, slash + 1) : "";
+    
+    std::istringstream lines(source);
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(lines, line))
+    {
+        lineNumber++;
+        
+        size_t start = line.find_first_not_of(" \t");
+        if (start != std::string::npos && line.compare(start, 8, "#include") == 0)
+        {
+            size_t open = line.find('"', start + 8);
+            size_t close = (open != std::string::npos) ? line.find('"', open + 1) : std::string::npos;
+            if (close == std::string::npos)
+            {
+                SDL_LogError(SDL_LOG_CATEGORY_RENDER, "Malformed #include in %s:%d", path.c_str(), lineNumber);
+                return false;
+            }
+            
+            std::string includePath = directory + line.substr(open + 1, close - open - 1);
+            output += "#line 1\n";
+            if (!resolveIncludes(includePath, output, included, depth + 1))
+            {
+                return false;
+            }
+            output += "#line " + std::to_string(lineNumber + 1) + "\n";
+            continue;
+        }
+        
+        output += line;
+        output += '\n';
+    }
+    
+    return true;
+}
+
 GLuint ShaderManager::compileShader(GLenum type, const char* source)
 {
+    // Compile status is checked in finalizeProgram() so this doesn't block
     GLuint shader = glCreateShader(type);
     glShaderSource(shader, 1, &source, NULL);
     glCompileShader(shader);
     
+    return shader;
+}
+
+void ShaderManager::submitProgram(ProgramEntry& entry)
+{
+    std::string vertexCode = loadShaderSource(m_paths[entry.vertexPath], entry.defines);
+    std::string fragmentCode = loadShaderSource(m_paths[entry.fragmentPath], entry.defines);
+    
+    if (vertexCode.empty() || fragmentCode.empty())
+    {
+        entry.state = ProgramState::Failed;
+        return;
+    }
+    
+    // Try the program binary cache before compiling from source
+    if (isBinaryCacheEnabled())
+    {
+        entry.binaryKey = makeBinaryKey(vertexCode, fragmentCode);
+        entry.program = loadCachedProgram(entry.binaryKey);
+        if (entry.program != 0)
+        {
+            entry.state = ProgramState::Ready;
+            return;
+        }
+    }
+    
+    entry.vertexShader = compileShader(GL_VERTEX_SHADER, vertexCode.c_str());
+    entry.fragmentShader = compileShader(GL_FRAGMENT_SHADER, fragmentCode.c_str());
+    
+    entry.program = glCreateProgram();
+    glAttachShader(entry.program, entry.vertexShader);
+    glAttachShader(entry.program, entry.fragmentShader);
+    if (entry.binaryKey != 0)
+    {
+        glProgramParameteri(entry.program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+    glLinkProgram(entry.program);
+    
+    entry.state = ProgramState::Pending;
+}
+
+bool ShaderManager::checkShader(GLuint shader, const std::string& name)
+{
     GLint success;
     glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
     if (!success)
     {
         char infoLog[512];
         glGetShaderInfoLog(shader, 512, NULL, infoLog);
-        SDL_ShowSimpleMessageBox(SDL_MESSAGEBOX_ERROR, "Shader Compilation Failed", infoLog, NULL);
+        SDL_LogError(SDL_LOG_CATEGORY_RENDER, "Shader compilation failed (%s): %s", name.c_str(), infoLog);
     }
     
-    return shader;
+    return success;
 }
 
-GLuint ShaderManager::createShaderProgram(const char* vertexPath, const char* fragmentPath)
+void ShaderManager::finalizeProgram(ProgramEntry& entry)
 {
-    std::string vertexCode = readShaderFile(vertexPath);
-    std::string fragmentCode = readShaderFile(fragmentPath);
+    std::string name = describeProgram(entry);
+    checkShader(entry.vertexShader, name);
+    checkShader(entry.fragmentShader, name);
     
-    if (vertexCode.empty() || fragmentCode.empty())
+    GLint success;
+    glGetProgramiv(entry.program, GL_LINK_STATUS, &success);
+    if (!success)
     {
-        return 0;
+        char infoLog[512];
+        glGetProgramInfoLog(entry.program, 512, NULL, infoLog);
+        SDL_LogError(SDL_LOG_CATEGORY_RENDER, "Shader linking failed (%s): %s", name.c_str(), infoLog);
+        
+        // Keep drawing with the fallback program
+        glDeleteProgram(entry.program);
+        entry.program = 0;
+        entry.state = ProgramState::Failed;
+    }
+    else
+    {
+        if (entry.binaryKey != 0)
+        {
+            storeCachedProgram(entry.binaryKey, entry.program);
+        }
+        entry.state = ProgramState::Ready;
     }
     
-    const char* vertexShaderSource = vertexCode.c_str();
-    const char* fragmentShaderSource = fragmentCode.c_str();
+    glDeleteShader(entry.vertexShader);
+    glDeleteShader(entry.fragmentShader);
+    entry.vertexShader = 0;
+    entry.fragmentShader = 0;
+}
+
+std::string ShaderManager::describeProgram(const ProgramEntry& entry) const
+{
+    std::string description = m_paths[entry.vertexPath] + "|" + m_paths[entry.fragmentPath];
+    for (int i = 0; i < entry.defines.size(); ++i)
+    {
+        description += i == 0 ? " [" : ", ";
+        description += entry.defines[i].name;
+    }
+    if (entry.defines.size() > 0)
+    {
+        description += "]";
+    }
+    return description;
+}
+
+GLuint ShaderManager::getFallbackProgram()
+{
+    if (m_fallbackBuilt)
+        return m_fallbackProgram;
+    m_fallbackBuilt = true;
     
-    GLuint vertexShader = compileShader(GL_VERTEX_SHADER, vertexShaderSource);
-    GLuint fragmentShader = compileShader(GL_FRAGMENT_SHADER, fragmentShaderSource);
+    // Small enough to compile synchronously the first time it is needed
+    GLuint vertexShader = compileShader(GL_VERTEX_SHADER, FALLBACK_VERTEX_SOURCE);
+    GLuint fragmentShader = compileShader(GL_FRAGMENT_SHADER, FALLBACK_FRAGMENT_SOURCE);
     
     GLuint program = glCreateProgram();
     glAttachShader(program, vertexShader);
     glAttachShader(program, fragmentShader);
     glLinkProgram(program);
     
+    bool compiled = checkShader(vertexShader, "fallback") && checkShader(fragmentShader, "fallback");
+    
     GLint success;
     glGetProgramiv(program, GL_LINK_STATUS, &success);
-    if (!success)
+    if (!compiled || !success)
     {
-        char infoLog[512];
-        glGetProgramInfoLog(program, 512, NULL, infoLog);
-        SDL_ShowSimpleMessageBox(SDL_MESSAGEBOX_ERROR, "Shader Linking Failed", infoLog, NULL);
+        SDL_LogError(SDL_LOG_CATEGORY_RENDER, "Failed to build fallback shader program");
+        glDeleteProgram(program);
+        program = 0;
     }
     
     glDeleteShader(vertexShader);
     glDeleteShader(fragmentShader);
     
+    m_fallbackProgram = program;
+    return m_fallbackProgram;
+}
+
+bool ShaderManager::isBinaryCacheEnabled()
+{
+    if (m_binaryCacheDir.empty())
+        return false;
+    
+    // Query driver support once; zero formats means binaries can't be reloaded
+    if (m_binaryFormatCount < 0)
+    {
+        m_binaryFormatCount = 0;
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &m_binaryFormatCount);
+        
+        const char* renderer = reinterpret_cast<const char*>(glGetString(GL_RENDERER));
+        const char* version = reinterpret_cast<const char*>(glGetString(GL_VERSION));
+        m_driverSignature = std::string(renderer ? renderer : "") + "|" + (version ? version : "");
+    }
+    
+    return m_binaryFormatCount > 0;
+}
+
+uint64_t ShaderManager::makeBinaryKey(const std::string& vertexCode, const std::string& fragmentCode)
+{
+    // Sources already contain any defines, so editing either shader or
+    // switching driver/GPU produces a different key and the old entry is ignored
+    uint64_t hash = fnv1a64(m_driverSignature);
+    hash = fnv1a64(std::string_view("|vs|"), hash);
+    hash = fnv1a64(vertexCode, hash);
+    hash = fnv1a64(std::string_view("|fs|"), hash);
+    hash = fnv1a64(fragmentCode, hash);
+    return hash;
+}
+
+std::string ShaderManager::makeBinaryPath(uint64_t key) const
+{
+    char fileName[32];
+    SDL_snprintf(fileName, sizeof(fileName), "%016" SDL_PRIx64 ".bin", key);
+    return m_binaryCacheDir + fileName;
+}
+
+GLuint ShaderManager::loadCachedProgram(uint64_t key)
+{
+    std::string path = makeBinaryPath(key);
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open())
+        return 0;
+    
+    ProgramBinaryHeader header;
+    bool valid = static_cast<bool>(file.read(reinterpret_cast<char*>(&header), sizeof(header)))
+              && header.magic == PROGRAM_BINARY_MAGIC
+              && header.version == PROGRAM_BINARY_VERSION
+              && header.key == key
+              && header.binaryLength > 0;
+    
+    std::vector<char> binary;
+    if (valid)
+    {
+        binary.resize(header.binaryLength);
+        valid = static_cast<bool>(file.read(binary.data(), binary.size()));
+    }
+    file.close();
+    
+    GLuint program = 0;
+    if (valid)
+    {
+        program = glCreateProgram();
+        glProgramBinary(program, header.binaryFormat, binary.data(), (GLsizei)binary.size());
+        
+        // The driver may reject binaries after an update, fall back to source then
+        GLint success;
+        glGetProgramiv(program, GL_LINK_STATUS, &success);
+        if (!success)
+        {
+            glDeleteProgram(program);
+            program = 0;
+        }
+    }
+    
+    if (program == 0)
+    {
+        std::remove(path.c_str());
+    }
+    else
+    {
+        // Entries age from their last use, see pruneBinaryCache()
+        std::error_code error;
+        std::filesystem::last_write_time(path, std::filesystem::file_time_type::clock::now(), error);
+    }
+    
     return program;
 }
+
+void ShaderManager::storeCachedProgram(uint64_t key, GLuint program)
+{
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0)
+        return;
+    
+    // The binary is read straight into the file contents, behind the header
+    std::vector<uint8_t> bytes(sizeof(ProgramBinaryHeader) + length);
+    GLenum binaryFormat = 0;
+    glGetProgramBinary(program, length, &length, &binaryFormat, bytes.data() + sizeof(ProgramBinaryHeader));
+    if (length <= 0)
+        return;
+    bytes.resize(sizeof(ProgramBinaryHeader) + length);
+    
+    ProgramBinaryHeader header;
+    header.magic = PROGRAM_BINARY_MAGIC;
+    header.version = PROGRAM_BINARY_VERSION;
+    header.key = key;
+    header.binaryFormat = binaryFormat;
+    header.binaryLength = (uint32_t)length;
+    std::memcpy(bytes.data(), &header, sizeof(header));
+    
+    writeFileAtomically(makeBinaryPath(key), bytes);
+}
+
+void ShaderManager::pruneBinaryCache()
+{
+    // Keys hash the sources and the driver, so edits and driver updates leave
+    // old entries behind. Another build sharing the directory may still use
+    // them, so only entries unused for BINARY_CACHE_MAX_AGE go; loading an
+    // entry refreshes its modification time
+    std::unordered_set<uint64_t> usedKeys;
+    for (const auto& pair : m_programs)
+    {
+        if (pair.second.binaryKey != 0)
+            usedKeys.insert(pair.second.binaryKey);
+    }
+    if (usedKeys.empty())
+        return;
+    
+    int count = 0;
+    char** files = SDL_GlobDirectory(m_binaryCacheDir.c_str(), "*.bin", 0, &count);
+    if (!files)
+        return;
+    
+    SDL_Time now = 0;
+    SDL_GetCurrentTime(&now);
+    
+    int pruned = 0;
+    for (int i = 0; i < count; ++i)
+    {
+        char* end = nullptr;
+        uint64_t key = SDL_strtoull(files[i], &end, 16);
+        if (end && SDL_strcmp(end, ".bin") == 0 && usedKeys.count(key) != 0)
+            continue;
+        
+        std::string path = m_binaryCacheDir + files[i];
+        SDL_PathInfo info;
+        if (!SDL_GetPathInfo(path.c_str(), &info) || now - info.modify_time < BINARY_CACHE_MAX_AGE)
+            continue;
+        if (std::remove(path.c_str()) == 0)
+            pruned++;
+    }
+    SDL_free(files);
+    
+    if (pruned > 0)
+        SDL_Log("Pruned %d stale shader binaries from %s", pruned, m_binaryCacheDir.c_str());
+}
@@ -5,7 +5,13 @@
 
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
 #include <memory>
+#include <vector>
+#include <cstdint>
+#include <initializer_list>
+
+#include "libs/hash/fnv1a.h"
 
 #if defined(__APPLE__)
     #include <OpenGL/gl3.h>
@@ -13,6 +19,85 @@
     #include <SDL3/SDL_opengl.h>
 #endif
 
+// Index of a shader source file registered with the ShaderManager
+using ShaderPathId = uint32_t;
+constexpr ShaderPathId INVALID_SHADER_PATH = 0xFFFFFFFFu;
+
+// Precomputed key of a program variant (vertex path, fragment path, defines)
+using ShaderHandle = uint64_t;
+constexpr ShaderHandle INVALID_SHADER_HANDLE = 0;
+
+// A #define injected into a shader variant, hashed at compile time.
+// The name must have static storage duration (a string literal).
+struct ShaderDefine
+{
+    const char* name;
+    uint64_t hash;
+    
+    constexpr ShaderDefine() : name(nullptr), hash(0) {}
+    constexpr ShaderDefine(const char* defineName) : name(defineName), hash(fnv1a64(defineName)) {}
+};
+
+// Set of defines making up a variant; the hash doesn't depend on the order
+class ShaderDefines
+{
+public:
+    static constexpr int MAX_DEFINES = 16;
+    
+    constexpr ShaderDefines() = default;
+    constexpr ShaderDefines(std::initializer_list<ShaderDefine> defines)
+    {
+        for (const ShaderDefine& define : defines)
+        {
+            add(define);
+        }
+    }
+    
+    // Add a define (duplicates are ignored, defines past MAX_DEFINES are dropped)
+    constexpr ShaderDefines& add(const ShaderDefine& define)
+    {
+        for (int i = 0; i < m_count; ++i)
+        {
+            if (m_defines[i].hash == define.hash)
+                return *this;
+        }
+        if (m_count < MAX_DEFINES)
+        {
+            m_defines[m_count++] = define;
+            m_hash += define.hash;
+        }
+        return *this;
+    }
+    
+    constexpr uint64_t hash() const { return m_hash; }
+    constexpr int size() const { return m_count; }
+    constexpr const ShaderDefine& operator[](int index) const { return m_defines[index]; }
+    
+private:
+    ShaderDefine m_defines[MAX_DEFINES] = {};
+    int m_count = 0;
+    uint64_t m_hash = 0;
+};
+
+// Combine path ids and define set into a variant handle (splitmix64 finalizer)
+constexpr ShaderHandle makeShaderHandle(ShaderPathId vertexPath, ShaderPathId fragmentPath, const ShaderDefines& defines)
+{
+    uint64_t h = defines.hash() ^ (((uint64_t)vertexPath << 32) | fragmentPath);
+    h ^= h >> 30;
+    h *= 0xbf58476d1ce4e5b9ull;
+    h ^= h >> 27;
+    h *= 0x94d049bb133111ebull;
+    h ^= h >> 31;
+    return h != INVALID_SHADER_HANDLE ? h : 1;
+}
+
+// Defines understood by the shaders in shaders/
+constexpr ShaderDefine SHADER_DEFINE_NORMAL_MATRIX("USE_NORMAL_MATRIX");         // normals use the normalMatrix uniform
+constexpr ShaderDefine SHADER_DEFINE_NO_SPECULAR("NO_SPECULAR");                 // skip the specular lighting term
+constexpr ShaderDefine SHADER_DEFINE_CLUSTERED_LIGHTING("CLUSTERED_LIGHTING");   // point lights from LightSystem clusters
+constexpr ShaderDefine SHADER_DEFINE_INSTANCED("INSTANCED");                     // model matrix and material per instance
+constexpr ShaderDefine SHADER_DEFINE_BLOCK_TEXTURES("BLOCK_TEXTURES");           // color from the block texture array
+
 class ShaderManager
 {
 public:
@@ -23,24 +108,96 @@ public:
     ShaderManager(const ShaderManager&) = delete;
     ShaderManager& operator=(const ShaderManager&) = delete;
     
-    // Load or get cached shader program
-    GLuint getShaderProgram(const std::string& vertexPath, const std::string& fragmentPath);
+    // Register a shader source file, returns the same id for the same path
+    ShaderPathId registerShaderPath(const std::string& path);
+    
+    // Request a program variant, compile and link run in the background.
+    // The handle stays valid until cleanup. INVALID_SHADER_HANDLE for unknown
+    // paths or when the handle collides with a different variant's.
+    ShaderHandle requestShaderProgram(ShaderPathId vertexPath, ShaderPathId fragmentPath,
+                                      const ShaderDefines& defines = {});
+    ShaderHandle requestShaderProgram(const std::string& vertexPath, const std::string& fragmentPath,
+                                      const ShaderDefines& defines = {});
+    
+    // Program to draw with: the real program once linked, the fallback until then
+    GLuint getProgram(ShaderHandle handle);
+    
+    // Whether the requested program finished linking successfully
+    bool isProgramReady(ShaderHandle handle) const;
+    
+    // Poll pending compiles, call once per frame on the GL thread
+    void update();
+    
+    // Whether any requested program is still compiling
+    bool hasPendingPrograms() const;
     
     // Cleanup all shaders
     void cleanup();
     
+    // Directory for the on-disk program binary cache (empty disables caching)
+    void setBinaryCacheDirectory(const std::string& directory);
+    
 private:
     ShaderManager() = default;
     ~ShaderManager();
     
+    enum class ProgramState
+    {
+        Pending,
+        Ready,
+        Failed
+    };
+    
+    struct ProgramEntry
+    {
+        ShaderPathId vertexPath = INVALID_SHADER_PATH;
+        ShaderPathId fragmentPath = INVALID_SHADER_PATH;
+        ShaderDefines defines;
+        GLuint program = 0;
+        GLuint vertexShader = 0;
+        GLuint fragmentShader = 0;
+        uint64_t binaryKey = 0;
+        ProgramState state = ProgramState::Pending;
+    };
+    
     // Helper functions
+    void initializeCompiler();
     std::string readShaderFile(const char* filepath);
+    std::string loadShaderSource(const std::string& path, const ShaderDefines& defines);
+    bool resolveIncludes(const std::string& path, std::string& output,
+                         std::unordered_set<std::string>& included, int depth);
     GLuint compileShader(GLenum type, const char* source);
-    GLuint createShaderProgram(const char* vertexPath, const char* fragmentPath);
+    void submitProgram(ProgramEntry& entry);
+    void finalizeProgram(ProgramEntry& entry);
+    bool checkShader(GLuint shader, const std::string& name);
+    std::string describeProgram(const ProgramEntry& entry) const;
+    GLuint getFallbackProgram();
+    
+    // Program binary cache helpers
+    bool isBinaryCacheEnabled();
+    uint64_t makeBinaryKey(const std::string& vertexCode, const std::string& fragmentCode);
+    std::string makeBinaryPath(uint64_t key) const;
+    GLuint loadCachedProgram(uint64_t key);
+    void storeCachedProgram(uint64_t key, GLuint program);
+    void pruneBinaryCache();
+    
+    // Registered source files, indexed by ShaderPathId
+    std::vector<std::string> m_paths;
+    std::unordered_map<std::string, ShaderPathId> m_pathIds;
+    
+    // Program variants keyed by their precomputed handle
+    std::unordered_map<ShaderHandle, ProgramEntry> m_programs;
+    
+    // Cheap unlit program drawn while real programs are still compiling
+    GLuint m_fallbackProgram = 0;
+    bool m_fallbackBuilt = false;
     
-    // Cache: key is "vertexPath|fragmentPath", value is shader program ID
-    std::unordered_map<std::string, GLuint> m_shaderCache;
+    // KHR_parallel_shader_compile support, queried on the first request
+    bool m_compilerInitialized = false;
+    bool m_parallelCompile = false;
     
-    // Generate cache key from paths
-    std::string makeCacheKey(const std::string& vertexPath, const std::string& fragmentPath);
+    // Program binary cache state
+    std::string m_binaryCacheDir;
+    std::string m_driverSignature;   // GL_RENDERER + GL_VERSION, part of every binary key
+    GLint m_binaryFormatCount = -1;  // -1 until queried from the driver
 };
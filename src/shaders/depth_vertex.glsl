@@ -0,0 +1,19 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+#ifdef INSTANCED
+layout (location = 3) in mat4 aModel;
+#define model aModel
+#else
+uniform mat4 model;
+#endif
+
+uniform mat4 view;
+uniform mat4 projection;
+
+// Must match vertex.glsl bit for bit, the lit pass tests with GL_EQUAL
+invariant gl_Position;
+
+void main()
+{
+    gl_Position = projection * view * model * vec4(aPos, 1.0);
+}
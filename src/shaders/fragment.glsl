@@ -2,31 +2,60 @@
 in vec3 vertexColor;
 in vec3 fragNormal;
 in vec3 fragPos;
+#ifdef CLUSTERED_LIGHTING
+in float viewDepth;
+#endif
+#ifdef BLOCK_TEXTURES
+in vec3 texCoord;
+
+// One layer per block texture, bound once for the whole world
+uniform sampler2DArray blockTextures;
+#endif
 
 out vec4 FragColor;
 
+#ifdef CLUSTERED_LIGHTING
+// Light lists built by LightSystem
+uniform samplerBuffer lightData;     // per light: (position, radius), (color, 0)
+uniform usamplerBuffer clusterGrid;  // per cluster: (offset, count)
+uniform usamplerBuffer lightIndices;
+uniform uvec3 clusterDims;
+uniform vec2 screenSize;
+uniform vec2 clusterDepthParams;     // slice = log(depth) * x + y
+#else
 uniform vec3 lightPos;
+#endif
 uniform vec3 viewPos;
 
+#include "lighting.glsl"
+
 void main()
 {
-    // Ambient lighting
-    float ambientStrength = 0.3;
-    vec3 ambient = ambientStrength * vertexColor;
+#ifdef BLOCK_TEXTURES
+    vec3 albedo = vertexColor * texture(blockTextures, texCoord).rgb;
+#else
+    vec3 albedo = vertexColor;
+#endif
+
+#ifdef CLUSTERED_LIGHTING
+    // Find this fragment's cluster
+    uvec2 tile = uvec2(clamp(gl_FragCoord.xy / screenSize, 0.0, 0.9999) * vec2(clusterDims.xy));
+    float slice = clamp(log(viewDepth) * clusterDepthParams.x + clusterDepthParams.y, 0.0, float(clusterDims.z - 1u));
+    uint cluster = tile.x + clusterDims.x * (tile.y + clusterDims.y * uint(slice));
+    uvec2 range = texelFetch(clusterGrid, int(cluster)).xy;
     
-    // Diffuse lighting
+    // Only the lights touching the cluster are shaded
     vec3 norm = normalize(fragNormal);
-    vec3 lightDir = normalize(lightPos - fragPos);
-    float diff = max(dot(norm, lightDir), 0.0);
-    vec3 diffuse = diff * vertexColor;
-    
-    // Specular lighting
-    float specularStrength = 0.5;
-    vec3 viewDir = normalize(viewPos - fragPos);
-    vec3 reflectDir = reflect(-lightDir, norm);
-    float spec = pow(max(dot(viewDir, reflectDir), 0.0), 32);
-    vec3 specular = specularStrength * spec * vec3(1.0, 1.0, 1.0);
-    
-    vec3 result = ambient + diffuse + specular;
+    vec3 result = computeAmbient(albedo);
+    for (uint i = 0u; i < range.y; ++i)
+    {
+        int lightIndex = int(texelFetch(lightIndices, int(range.x + i)).r);
+        vec4 positionRadius = texelFetch(lightData, lightIndex * 2);
+        vec3 color = texelFetch(lightData, lightIndex * 2 + 1).rgb;
+        result += computePointLight(albedo, norm, fragPos, viewPos, positionRadius, color);
+    }
+#else
+    vec3 result = computeLighting(albedo, fragNormal, fragPos, lightPos, viewPos);
+#endif
     FragColor = vec4(result, 1.0);
 }
@@ -0,0 +1,50 @@
+// Shared Phong lighting, included by fragment shaders
+// Define NO_SPECULAR to compile a variant without the specular term
+
+// Ambient lighting
+vec3 computeAmbient(vec3 baseColor)
+{
+    float ambientStrength = 0.3;
+    return ambientStrength * baseColor;
+}
+
+// Diffuse and specular terms for one light (norm and lightDir normalized)
+vec3 computeDirect(vec3 baseColor, vec3 norm, vec3 position, vec3 lightDir, vec3 viewPosition)
+{
+    // Diffuse lighting
+    float diff = max(dot(norm, lightDir), 0.0);
+    vec3 diffuse = diff * baseColor;
+
+#ifdef NO_SPECULAR
+    return diffuse;
+#else
+    // Specular lighting
+    float specularStrength = 0.5;
+    vec3 viewDir = normalize(viewPosition - position);
+    vec3 reflectDir = reflect(-lightDir, norm);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), 32);
+    vec3 specular = specularStrength * spec * vec3(1.0, 1.0, 1.0);
+    
+    return diffuse + specular;
+#endif
+}
+
+vec3 computeLighting(vec3 baseColor, vec3 normal, vec3 position, vec3 lightPosition, vec3 viewPosition)
+{
+    vec3 norm = normalize(normal);
+    vec3 lightDir = normalize(lightPosition - position);
+    return computeAmbient(baseColor) + computeDirect(baseColor, norm, position, lightDir, viewPosition);
+}
+
+// Point light fading smoothly to zero at its radius
+vec3 computePointLight(vec3 baseColor, vec3 norm, vec3 position, vec3 viewPosition, vec4 positionRadius, vec3 color)
+{
+    vec3 toLight = positionRadius.xyz - position;
+    float distance = length(toLight);
+    float ratio = distance / positionRadius.w;
+    float falloff = clamp(1.0 - ratio * ratio, 0.0, 1.0);
+    falloff *= falloff;
+    
+    vec3 lightDir = toLight / max(distance, 0.0001);
+    return computeDirect(baseColor, norm, position, lightDir, viewPosition) * color * falloff;
+}
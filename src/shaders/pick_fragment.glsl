@@ -0,0 +1,11 @@
+#version 330 core
+
+// Object ID pass for GPU picking, 0 marks the background and occluders
+uniform uint objectId;
+
+out uint fragId;
+
+void main()
+{
+    fragId = objectId;
+}
@@ -0,0 +1,13 @@
+#version 330 core
+
+// Scene rendered at the dynamic resolution, filtered by a bilinear sampler
+uniform sampler2D sceneColor;
+
+in vec2 texCoord;
+
+out vec4 FragColor;
+
+void main()
+{
+    FragColor = vec4(texture(sceneColor, texCoord).rgb, 1.0);
+}
@@ -2,19 +2,65 @@
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aColor;
 layout (location = 2) in vec3 aNormal;
+#ifdef INSTANCED
+// Per-instance model matrix (locations 3-6) and material index
+layout (location = 3) in mat4 aModel;
+layout (location = 7) in uint aMaterial;
+#endif
+#ifdef BLOCK_TEXTURES
+// Texture coordinate in cells and block texture array layer
+layout (location = 8) in vec3 aTexCoord;
+#endif
 
 out vec3 vertexColor;
 out vec3 fragNormal;
 out vec3 fragPos;
+#ifdef CLUSTERED_LIGHTING
+out float viewDepth;
+#endif
+#ifdef BLOCK_TEXTURES
+out vec3 texCoord;
+#endif
 
+#ifdef INSTANCED
+#define model aModel
+uniform samplerBuffer materials;   // per material: (color, unused)
+uniform int materialCount;
+#else
 uniform mat4 model;
+#endif
 uniform mat4 view;
 uniform mat4 projection;
 
+// Same position math as depth_vertex.glsl so the depth pre-pass matches exactly
+invariant gl_Position;
+
+#ifdef USE_NORMAL_MATRIX
+// Inverse-transpose of mat3(model), computed once per object on the CPU
+uniform mat3 normalMatrix;
+#endif
+
 void main()
 {
     fragPos = vec3(model * vec4(aPos, 1.0));
+#if defined(INSTANCED)
+    // Scene transforms are rotation and uniform scale, the fragment shader renormalizes
+    fragNormal = mat3(model) * aNormal;
+#elif defined(USE_NORMAL_MATRIX)
+    fragNormal = normalMatrix * aNormal;
+#else
     fragNormal = mat3(transpose(inverse(model))) * aNormal;
+#endif
     gl_Position = projection * view * model * vec4(aPos, 1.0);
+#ifdef INSTANCED
+    vertexColor = aColor * texelFetch(materials, min(int(aMaterial), materialCount - 1)).rgb;
+#else
     vertexColor = aColor;
+#endif
+#ifdef CLUSTERED_LIGHTING
+    viewDepth = -(view * vec4(fragPos, 1.0)).z;
+#endif
+#ifdef BLOCK_TEXTURES
+    texCoord = aTexCoord;
+#endif
 }
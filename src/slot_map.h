@@ -0,0 +1,152 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// Generational handle to an object in a SlotMap<T>. A handle goes stale when
+// its object is destroyed and never resolves to a later object in the slot.
+template<typename T>
+struct Handle
+{
+    static constexpr uint32_t INVALID_INDEX = 0xFFFFFFFFu;
+    
+    uint32_t index = INVALID_INDEX;
+    uint32_t generation = 0;
+    
+    bool isNull() const { return index == INVALID_INDEX; }
+    bool operator==(const Handle& other) const { return index == other.index && generation == other.generation; }
+    bool operator!=(const Handle& other) const { return !(*this == other); }
+};
+
+// Objects packed densely in a vector and addressed through generational
+// handles. create, destroy and lookup are O(1); destroy moves the last object
+// into the hole, so iteration stays linear over live objects only. Pointers
+// into the map are invalidated by create and destroy, handles are not.
+template<typename T>
+class SlotMap
+{
+public:
+    SlotMap() = default;
+    
+    // Delete copy constructor and assignment operator
+    SlotMap(const SlotMap&) = delete;
+    SlotMap& operator=(const SlotMap&) = delete;
+    
+    template<typename... Args>
+    Handle<T> create(Args&&... args)
+    {
+        // Reuse a free slot (its generation was bumped on destroy)
+        uint32_t slotIndex;
+        if (m_freeHead != Handle<T>::INVALID_INDEX)
+        {
+            slotIndex = m_freeHead;
+            m_freeHead = m_slots[slotIndex].target;
+        }
+        else
+        {
+            slotIndex = (uint32_t)m_slots.size();
+            m_slots.push_back({0, 1});
+        }
+        
+        m_objects.emplace_back(std::forward<Args>(args)...);
+        m_denseToSlot.push_back(slotIndex);
+        m_slots[slotIndex].target = (uint32_t)m_objects.size() - 1;
+        return {slotIndex, m_slots[slotIndex].generation};
+    }
+    
+    // Destroy an object, false if the handle is stale
+    bool destroy(Handle<T> handle)
+    {
+        if (!contains(handle))
+            return false;
+        
+        Slot& slot = m_slots[handle.index];
+        uint32_t denseIndex = slot.target;
+        uint32_t lastIndex = (uint32_t)m_objects.size() - 1;
+        if (denseIndex != lastIndex)
+        {
+            m_objects[denseIndex] = std::move(m_objects[lastIndex]);
+            m_denseToSlot[denseIndex] = m_denseToSlot[lastIndex];
+            m_slots[m_denseToSlot[denseIndex]].target = denseIndex;
+        }
+        m_objects.pop_back();
+        m_denseToSlot.pop_back();
+        
+        // Skip generation 0 on wrap so default handles never match
+        slot.generation = (slot.generation + 1 != 0) ? slot.generation + 1 : 1;
+        slot.target = m_freeHead;
+        m_freeHead = handle.index;
+        return true;
+    }
+    
+    bool contains(Handle<T> handle) const
+    {
+        return handle.index < m_slots.size() && m_slots[handle.index].generation == handle.generation &&
+               isLive(handle.index);
+    }
+    
+    // Object of a handle, nullptr if stale
+    T* get(Handle<T> handle) { return contains(handle) ? &m_objects[m_slots[handle.index].target] : nullptr; }
+    const T* get(Handle<T> handle) const { return contains(handle) ? &m_objects[m_slots[handle.index].target] : nullptr; }
+    
+    // Handle of the object at a dense position (0 <= denseIndex < size())
+    Handle<T> getHandle(size_t denseIndex) const
+    {
+        uint32_t slotIndex = m_denseToSlot[denseIndex];
+        return {slotIndex, m_slots[slotIndex].generation};
+    }
+    
+    // Current handle of a slot, null if the slot is out of range or free
+    Handle<T> getSlotHandle(uint32_t slotIndex) const
+    {
+        if (slotIndex >= m_slots.size() || !isLive(slotIndex))
+            return {};
+        return {slotIndex, m_slots[slotIndex].generation};
+    }
+    
+    void clear()
+    {
+        while (!m_objects.empty())
+        {
+            destroy(getHandle(m_objects.size() - 1));
+        }
+    }
+    
+    void reserve(size_t count)
+    {
+        m_objects.reserve(count);
+        m_denseToSlot.reserve(count);
+        m_slots.reserve(count);
+    }
+    
+    // Dense iteration over live objects
+    size_t size() const { return m_objects.size(); }
+    bool empty() const { return m_objects.empty(); }
+    T& operator[](size_t denseIndex) { return m_objects[denseIndex]; }
+    const T& operator[](size_t denseIndex) const { return m_objects[denseIndex]; }
+    auto begin() { return m_objects.begin(); }
+    auto end() { return m_objects.end(); }
+    auto begin() const { return m_objects.begin(); }
+    auto end() const { return m_objects.end(); }
+    
+private:
+    // Live slots point at their dense index, free slots at the next free slot
+    struct Slot
+    {
+        uint32_t target;
+        uint32_t generation;
+    };
+    
+    bool isLive(uint32_t slotIndex) const
+    {
+        uint32_t denseIndex = m_slots[slotIndex].target;
+        return denseIndex < m_denseToSlot.size() && m_denseToSlot[denseIndex] == slotIndex;
+    }
+    
+    std::vector<T> m_objects;
+    std::vector<uint32_t> m_denseToSlot;
+    std::vector<Slot> m_slots;
+    uint32_t m_freeHead = Handle<T>::INVALID_INDEX;
+};
@@ -0,0 +1,225 @@
+// Silence OpenGL deprecation warnings on macOS
+#define GL_SILENCE_DEPRECATION
+
+#include "static_scene.h"
+#include "gl_state.h"
+#include "mesh_library.h"
+#include "render_stats.h"
+
+#include <SDL3/SDL.h>
+
+namespace
+{
+    // Instanced draws have no single origin, the queue sorts them as if at the origin
+    const float IDENTITY_MATRIX[16] = {
+        1.0f, 0.0f, 0.0f, 0.0f,
+        0.0f, 1.0f, 0.0f, 0.0f,
+        0.0f, 0.0f, 1.0f, 0.0f,
+        0.0f, 0.0f, 0.0f, 1.0f
+    };
+    const float IDENTITY_NORMAL_MATRIX[9] = {
+        1.0f, 0.0f, 0.0f,
+        0.0f, 1.0f, 0.0f,
+        0.0f, 0.0f, 1.0f
+    };
+}
+
+StaticScene::StaticScene(const std::string& vertexShaderPath, const std::string& fragmentShaderPath,
+                         const std::string& depthVertexShaderPath, const std::string& depthFragmentShaderPath)
+    : m_shaderHandle(INVALID_SHADER_HANDLE)
+    , m_clusteredShaderHandle(INVALID_SHADER_HANDLE)
+    , m_depthShaderHandle(INVALID_SHADER_HANDLE)
+    , m_transformBuffer(0)
+    , m_materialIdBuffer(0)
+    , m_materialBuffer(0)
+    , m_materialTexture(0)
+    , m_loadMilliseconds(0.0)
+{
+    ShaderManager& shaderManager = ShaderManager::getInstance();
+    m_shaderHandle = shaderManager.requestShaderProgram(
+        vertexShaderPath, fragmentShaderPath, { SHADER_DEFINE_INSTANCED });
+    m_clusteredShaderHandle = shaderManager.requestShaderProgram(
+        vertexShaderPath, fragmentShaderPath, { SHADER_DEFINE_INSTANCED, SHADER_DEFINE_CLUSTERED_LIGHTING });
+    m_depthShaderHandle = shaderManager.requestShaderProgram(
+        depthVertexShaderPath, depthFragmentShaderPath, { SHADER_DEFINE_INSTANCED });
+}
+
+StaticScene::~StaticScene()
+{
+    unload();
+}
+
+bool StaticScene::load(const std::string& path)
+{
+    unload();
+    
+    Uint64 start = SDL_GetPerformanceCounter();
+    if (!m_file.open(path))
+    {
+        SDL_Log("Failed to open scene %s", path.c_str());
+        return false;
+    }
+    
+    // The arrays go to GL straight from the mapping
+    GLState& state = GLState::getInstance();
+    uint32_t objectCount = m_file.getObjectCount();
+    glGenBuffers(1, &m_transformBuffer);
+    glGenBuffers(1, &m_materialIdBuffer);
+    glGenBuffers(1, &m_materialBuffer);
+    glGenTextures(1, &m_materialTexture);
+    
+    state.bindBuffer(GL_ARRAY_BUFFER, m_transformBuffer);
+    glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)objectCount * sizeof(SceneTransform), m_file.getTransforms(), GL_STATIC_DRAW);
+    state.bindBuffer(GL_ARRAY_BUFFER, m_materialIdBuffer);
+    glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)objectCount * sizeof(uint32_t), m_file.getMaterialIds(), GL_STATIC_DRAW);
+    
+    // Always at least one material so the shader's clamp stays in range
+    static const SceneMaterial DEFAULT_MATERIAL = {{1.0f, 1.0f, 1.0f}, 0.0f};
+    uint32_t materialCount = m_file.getMaterialCount();
+    state.bindBuffer(GL_TEXTURE_BUFFER, m_materialBuffer);
+    glBufferData(GL_TEXTURE_BUFFER, (GLsizeiptr)(materialCount > 0 ? materialCount : 1) * sizeof(SceneMaterial),
+                 materialCount > 0 ? m_file.getMaterials() : &DEFAULT_MATERIAL, GL_STATIC_DRAW);
+    RenderStats::getInstance().countBufferUpload((size_t)objectCount * (sizeof(SceneTransform) + sizeof(uint32_t)) +
+                                                 (materialCount > 0 ? materialCount : 1) * sizeof(SceneMaterial));
+    state.bindTexture(0, GL_TEXTURE_BUFFER, m_materialTexture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, m_materialBuffer);
+    state.bindTexture(0, GL_TEXTURE_BUFFER, 0);
+    
+    // One VAO pair per mesh reference, instance attributes offset to its range
+    const SceneMesh* meshes = m_file.getMeshes();
+    for (uint32_t i = 0; i < m_file.getMeshCount(); ++i)
+    {
+        const SceneMesh& sceneMesh = meshes[i];
+        if (sceneMesh.objectCount == 0)
+            continue;
+        
+        const LibraryMesh* mesh = nullptr;
+        if (sceneMesh.kind == SCENE_MESH_CUBE)
+            mesh = &MeshLibrary::getInstance().getCube();
+        else if (sceneMesh.kind == SCENE_MESH_TORUS)
+            mesh = &MeshLibrary::getInstance().getTorus(sceneMesh.params[0], sceneMesh.params[1]);
+        if (!mesh)
+        {
+            SDL_Log("Scene %s: skipping mesh %u of unknown kind %u", path.c_str(), i, sceneMesh.kind);
+            continue;
+        }
+        
+        Batch batch;
+        batch.indexCount = mesh->indexCount;
+        batch.instanceCount = (GLsizei)sceneMesh.objectCount;
+        glGenVertexArrays(1, &batch.VAO);
+        glGenVertexArrays(1, &batch.depthVAO);
+        
+        state.bindVertexArray(batch.VAO);
+        state.bindBuffer(GL_ARRAY_BUFFER, mesh->VBO);
+        state.bindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->EBO);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 9 * sizeof(float), (void*)0);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 9 * sizeof(float), (void*)(3 * sizeof(float)));
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, 9 * sizeof(float), (void*)(6 * sizeof(float)));
+        glEnableVertexAttribArray(2);
+        setupInstanceAttributes(sceneMesh.firstObject, true);
+        
+        state.bindVertexArray(batch.depthVAO);
+        state.bindBuffer(GL_ARRAY_BUFFER, mesh->depthVBO);
+        state.bindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->EBO);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+        glEnableVertexAttribArray(0);
+        setupInstanceAttributes(sceneMesh.firstObject, false);
+        
+        m_batches.push_back(batch);
+    }
+    
+    m_loadMilliseconds = (double)(SDL_GetPerformanceCounter() - start) * 1000.0 / (double)SDL_GetPerformanceFrequency();
+    SDL_Log("Loaded scene %s: %u objects in %d draws, %.2f ms",
+            path.c_str(), objectCount, (int)m_batches.size(), m_loadMilliseconds);
+    return true;
+}
+
+void StaticScene::setupInstanceAttributes(uint32_t firstObject, bool withMaterial)
+{
+    GLState& state = GLState::getInstance();
+    // mat4 takes four attribute slots (3-6), one column each
+    state.bindBuffer(GL_ARRAY_BUFFER, m_transformBuffer);
+    size_t transformOffset = (size_t)firstObject * sizeof(SceneTransform);
+    for (int column = 0; column < 4; ++column)
+    {
+        glVertexAttribPointer(3 + column, 4, GL_FLOAT, GL_FALSE, sizeof(SceneTransform),
+                              (void*)(transformOffset + column * 4 * sizeof(float)));
+        glEnableVertexAttribArray(3 + column);
+        glVertexAttribDivisor(3 + column, 1);
+    }
+    
+    if (withMaterial)
+    {
+        state.bindBuffer(GL_ARRAY_BUFFER, m_materialIdBuffer);
+        glVertexAttribIPointer(7, 1, GL_UNSIGNED_INT, sizeof(uint32_t), (void*)((size_t)firstObject * sizeof(uint32_t)));
+        glEnableVertexAttribArray(7);
+        glVertexAttribDivisor(7, 1);
+    }
+}
+
+void StaticScene::unload()
+{
+    GLState& state = GLState::getInstance();
+    for (Batch& batch : m_batches)
+    {
+        state.deleteVertexArrays(1, &batch.VAO);
+        state.deleteVertexArrays(1, &batch.depthVAO);
+    }
+    m_batches.clear();
+    
+    if (m_transformBuffer != 0)
+    {
+        state.deleteBuffers(1, &m_transformBuffer);
+        state.deleteBuffers(1, &m_materialIdBuffer);
+        state.deleteBuffers(1, &m_materialBuffer);
+        state.deleteTextures(1, &m_materialTexture);
+        m_transformBuffer = 0;
+        m_materialIdBuffer = 0;
+        m_materialBuffer = 0;
+        m_materialTexture = 0;
+    }
+    
+    m_file.close();
+}
+
+void StaticScene::submit(RenderQueue& queue, bool clusteredLighting) const
+{
+    ShaderManager& shaderManager = ShaderManager::getInstance();
+    ShaderHandle shaderHandle = clusteredLighting ? m_clusteredShaderHandle : m_shaderHandle;
+    
+    // The fallback program isn't instanced, wait for the real ones
+    if (!shaderManager.isProgramReady(shaderHandle) || !shaderManager.isProgramReady(m_depthShaderHandle))
+        return;
+    
+    for (const Batch& batch : m_batches)
+    {
+        DrawItem item;
+        item.program = shaderManager.getProgram(shaderHandle);
+        item.depthProgram = shaderManager.getProgram(m_depthShaderHandle);
+        item.vao = batch.VAO;
+        item.depthVao = batch.depthVAO;
+        item.indexCount = batch.indexCount;
+        item.instanceCount = batch.instanceCount;
+        item.modelMatrix = IDENTITY_MATRIX;
+        item.normalMatrix = IDENTITY_NORMAL_MATRIX;
+        queue.add(item);
+    }
+}
+
+void StaticScene::bind(GLuint program) const
+{
+    GLState& state = GLState::getInstance();
+    if (m_materialTexture == 0 || program == 0)
+        return;
+    
+    state.bindTexture(MATERIAL_UNIT, GL_TEXTURE_BUFFER, m_materialTexture);
+    state.activeTexture(0);
+    
+    uint32_t materialCount = m_file.getMaterialCount();
+    glUniform1i(glGetUniformLocation(program, "materials"), MATERIAL_UNIT);
+    glUniform1i(glGetUniformLocation(program, "materialCount"), (GLint)(materialCount > 0 ? materialCount : 1));
+    RenderStats::getInstance().countUniforms(2);
+}
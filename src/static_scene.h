@@ -0,0 +1,81 @@
+#pragma once
+
+// Silence OpenGL deprecation warnings on macOS
+#define GL_SILENCE_DEPRECATION
+
+#include <string>
+#include <vector>
+
+#include "scene_file.h"
+#include "shader_manager.h"
+#include "render_queue.h"
+
+#if defined(__APPLE__)
+    #include <OpenGL/gl3.h>
+#else
+    #include <SDL3/SDL_opengl.h>
+#endif
+
+// Static objects from a binary scene file, drawn with one instanced draw per
+// mesh. Loading maps the file and hands the transform and material arrays
+// to GL as they are: no parsing and no per-object allocation.
+class StaticScene
+{
+public:
+    // Texture unit of the material buffer (LightSystem uses 1-3)
+    static constexpr int MATERIAL_UNIT = 4;
+    
+    // Shader paths of the lit and depth programs, the INSTANCED variants are used
+    StaticScene(const std::string& vertexShaderPath, const std::string& fragmentShaderPath,
+                const std::string& depthVertexShaderPath, const std::string& depthFragmentShaderPath);
+    ~StaticScene();
+    
+    // Delete copy constructor and assignment operator
+    StaticScene(const StaticScene&) = delete;
+    StaticScene& operator=(const StaticScene&) = delete;
+    
+    // Map a scene file and upload its arrays (GL thread), replacing the current scene
+    bool load(const std::string& path);
+    void unload();
+    
+    // Queue one instanced draw per mesh
+    void submit(RenderQueue& queue, bool clusteredLighting) const;
+    
+    // Bind the material buffer for a program (call from the program setup)
+    void bind(GLuint program) const;
+    
+    // Getters
+    bool isLoaded() const { return m_file.isOpen(); }
+    const SceneFile& getFile() const { return m_file; }
+    uint32_t getObjectCount() const { return m_file.getObjectCount(); }
+    int getBatchCount() const { return (int)m_batches.size(); }
+    double getLoadMilliseconds() const { return m_loadMilliseconds; }
+    
+private:
+    // One instanced draw: a library mesh and the range of instances using it
+    struct Batch
+    {
+        GLuint VAO = 0;
+        GLuint depthVAO = 0;
+        GLsizei indexCount = 0;
+        GLsizei instanceCount = 0;
+    };
+    
+    // Point the per-instance attributes at the range starting at firstObject
+    void setupInstanceAttributes(uint32_t firstObject, bool withMaterial);
+    
+    SceneFile m_file;
+    std::vector<Batch> m_batches;
+    
+    ShaderHandle m_shaderHandle;
+    ShaderHandle m_clusteredShaderHandle;
+    ShaderHandle m_depthShaderHandle;
+    
+    // OpenGL objects
+    GLuint m_transformBuffer;
+    GLuint m_materialIdBuffer;
+    GLuint m_materialBuffer;
+    GLuint m_materialTexture;
+    
+    double m_loadMilliseconds;
+};
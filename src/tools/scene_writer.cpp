@@ -0,0 +1,113 @@
+// Writes a binary scene file (see scene_file.h) filled with a seeded field
+// of cubes and tori around the origin.
+//
+//   scene_writer <output> [objectCount]
+
+#include "scene_file.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+
+namespace
+{
+    // Column-major rotation about an axis, uniform scale, then translation
+    void makeTransform(SceneTransform& transform, const float* axis, float angle, float scale,
+                       float x, float y, float z)
+    {
+        float c = std::cos(angle), s = std::sin(angle), t = 1.0f - c;
+        float ax = axis[0], ay = axis[1], az = axis[2];
+        float* m = transform.model;
+        
+        m[0] = (t * ax * ax + c) * scale;
+        m[1] = (t * ax * ay + s * az) * scale;
+        m[2] = (t * ax * az - s * ay) * scale;
+        m[3] = 0.0f;
+        m[4] = (t * ax * ay - s * az) * scale;
+        m[5] = (t * ay * ay + c) * scale;
+        m[6] = (t * ay * az + s * ax) * scale;
+        m[7] = 0.0f;
+        m[8] = (t * ax * az + s * ay) * scale;
+        m[9] = (t * ay * az - s * ax) * scale;
+        m[10] = (t * az * az + c) * scale;
+        m[11] = 0.0f;
+        m[12] = x;
+        m[13] = y;
+        m[14] = z;
+        m[15] = 1.0f;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2)
+    {
+        std::fprintf(stderr, "usage: %s <output> [objectCount]\n", argv[0]);
+        return 1;
+    }
+    
+    long objectCount = (argc > 2) ? std::strtol(argv[2], nullptr, 10) : 1000000;
+    if (objectCount < 0 || objectCount > 0x7FFFFFFF)
+    {
+        std::fprintf(stderr, "objectCount out of range\n");
+        return 1;
+    }
+    
+    SceneData scene;
+    scene.meshes = {
+        {SCENE_MESH_CUBE, 0, 0, {0.0f, 0.0f}, 0},
+        {SCENE_MESH_TORUS, 0, 0, {0.5f, 0.2f}, 0},
+        {SCENE_MESH_TORUS, 0, 0, {0.5f, 0.35f}, 0}
+    };
+    scene.materials = {
+        {{0.90f, 0.30f, 0.25f}, 0.0f},
+        {{0.25f, 0.60f, 0.90f}, 0.0f},
+        {{0.95f, 0.80f, 0.30f}, 0.0f},
+        {{0.40f, 0.80f, 0.45f}, 0.0f},
+        {{0.75f, 0.45f, 0.85f}, 0.0f},
+        {{0.85f, 0.85f, 0.85f}, 0.0f}
+    };
+    
+    // Square grid with jitter, one object per cell, centered on the origin
+    std::mt19937 random(20240601);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    int side = (int)std::ceil(std::sqrt((double)objectCount));
+    const float spacing = 1.5f;
+    float half = side * spacing * 0.5f;
+    
+    scene.objects.resize((size_t)objectCount);
+    for (long i = 0; i < objectCount; ++i)
+    {
+        SceneData::Object& object = scene.objects[(size_t)i];
+        float x = (i % side) * spacing - half + (unit(random) - 0.5f) * spacing * 0.4f;
+        float z = (i / side) * spacing - half + (unit(random) - 0.5f) * spacing * 0.4f;
+        float y = 4.0f + unit(random) * 3.0f;
+        
+        float axis[3] = {unit(random) - 0.5f, unit(random) - 0.5f, unit(random) - 0.5f};
+        float length = std::sqrt(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+        if (length < 1e-4f)
+        {
+            axis[0] = 0.0f;
+            axis[1] = 1.0f;
+            axis[2] = 0.0f;
+            length = 1.0f;
+        }
+        for (float& component : axis)
+        {
+            component /= length;
+        }
+        
+        makeTransform(object.transform, axis, unit(random) * 6.2831853f, 0.3f + unit(random) * 0.5f, x, y, z);
+        object.mesh = (uint32_t)(random() % scene.meshes.size());
+        object.material = (uint32_t)(random() % scene.materials.size());
+    }
+    
+    if (!SceneFile::write(argv[1], scene))
+    {
+        std::fprintf(stderr, "failed to write %s\n", argv[1]);
+        return 1;
+    }
+    std::printf("wrote %ld objects to %s\n", objectCount, argv[1]);
+    return 0;
+}
@@ -3,6 +3,7 @@
 
 #include "voxel.h"
 #include "shader_manager.h"
+#include "libs/maths/matrix.h"
 #include "imgui.h"
 #include <cmath>
 #include <cstring>
@@ -10,21 +11,19 @@
 Voxel::Voxel(const std::string& name, float x, float y, float z, float size,
              const std::string& vertexShaderPath, const std::string& fragmentShaderPath)
     : m_name(name)
-    , m_vertexShaderPath(vertexShaderPath)
-    , m_fragmentShaderPath(fragmentShaderPath)
-    , m_shaderProgram(0)
+    , m_shaderHandle(INVALID_SHADER_HANDLE)
     , m_posX(x), m_posY(y), m_posZ(z)
     , m_size(size)
     , m_rotX(0.0f), m_rotY(0.0f), m_rotZ(0.0f)
+    , m_eulerDirty(false)
     , m_autoRotate(false)
     , m_rotationSpeed(20.0f)
     , m_colorR(1.0f), m_colorG(1.0f), m_colorB(1.0f)
-    , m_VAO(0), m_VBO(0), m_EBO(0)
-    , m_ownsShader(false)
+    , m_mesh(nullptr)
     , m_initialized(false)
-    , m_windowVisible(true)
 {
     std::memset(m_modelMatrix, 0, sizeof(m_modelMatrix));
+    std::memset(m_normalMatrix, 0, sizeof(m_normalMatrix));
     
     // Initialize quaternion to identity (no rotation)
     m_quat[0] = 1.0f; // w
@@ -33,11 +32,10 @@ Voxel::Voxel(const std::string& name, float x, float y, float z, float size,
     m_quat[3] = 0.0f; // z
     
     // Load shader if paths are provided
-    if (!m_vertexShaderPath.empty() && !m_fragmentShaderPath.empty())
+    if (!vertexShaderPath.empty() && !fragmentShaderPath.empty())
     {
-        m_shaderProgram = ShaderManager::getInstance().getShaderProgram(
-            m_vertexShaderPath, m_fragmentShaderPath);
-        m_ownsShader = true;
+        m_shaderHandle = ShaderManager::getInstance().requestShaderProgram(
+            vertexShaderPath, fragmentShaderPath, { SHADER_DEFINE_NORMAL_MATRIX });
     }
     
     initialize();
@@ -51,29 +49,24 @@ Voxel::~Voxel()
 
 Voxel::Voxel(Voxel&& other) noexcept
     : m_name(std::move(other.m_name))
-    , m_vertexShaderPath(std::move(other.m_vertexShaderPath))
-    , m_fragmentShaderPath(std::move(other.m_fragmentShaderPath))
-    , m_shaderProgram(other.m_shaderProgram)
+    , m_shaderHandle(other.m_shaderHandle)
     , m_posX(other.m_posX), m_posY(other.m_posY), m_posZ(other.m_posZ)
     , m_size(other.m_size)
     , m_rotX(other.m_rotX), m_rotY(other.m_rotY), m_rotZ(other.m_rotZ)
+    , m_eulerDirty(other.m_eulerDirty)
     , m_autoRotate(other.m_autoRotate)
     , m_rotationSpeed(other.m_rotationSpeed)
     , m_colorR(other.m_colorR), m_colorG(other.m_colorG), m_colorB(other.m_colorB)
-    , m_VAO(other.m_VAO), m_VBO(other.m_VBO), m_EBO(other.m_EBO)
-    , m_ownsShader(other.m_ownsShader)
+    , m_mesh(other.m_mesh)
     , m_initialized(other.m_initialized)
-    , m_windowVisible(other.m_windowVisible)
 {
     std::memcpy(m_modelMatrix, other.m_modelMatrix, sizeof(m_modelMatrix));
+    std::memcpy(m_normalMatrix, other.m_normalMatrix, sizeof(m_normalMatrix));
     std::memcpy(m_quat, other.m_quat, sizeof(m_quat));
     
     // Reset other's resources
-    other.m_shaderProgram = 0;
-    other.m_VAO = 0;
-    other.m_VBO = 0;
-    other.m_EBO = 0;
-    other.m_ownsShader = false;
+    other.m_shaderHandle = INVALID_SHADER_HANDLE;
+    other.m_mesh = nullptr;
     other.m_initialized = false;
 }
 
@@ -84,9 +77,7 @@ Voxel& Voxel::operator=(Voxel&& other) noexcept
         cleanup();
         
         m_name = std::move(other.m_name);
-        m_vertexShaderPath = std::move(other.m_vertexShaderPath);
-        m_fragmentShaderPath = std::move(other.m_fragmentShaderPath);
-        m_shaderProgram = other.m_shaderProgram;
+        m_shaderHandle = other.m_shaderHandle;
         m_posX = other.m_posX;
         m_posY = other.m_posY;
         m_posZ = other.m_posZ;
@@ -94,26 +85,21 @@ Voxel& Voxel::operator=(Voxel&& other) noexcept
         m_rotX = other.m_rotX;
         m_rotY = other.m_rotY;
         m_rotZ = other.m_rotZ;
+        m_eulerDirty = other.m_eulerDirty;
         m_autoRotate = other.m_autoRotate;
         m_rotationSpeed = other.m_rotationSpeed;
         m_colorR = other.m_colorR;
         m_colorG = other.m_colorG;
         m_colorB = other.m_colorB;
-        m_VAO = other.m_VAO;
-        m_VBO = other.m_VBO;
-        m_EBO = other.m_EBO;
-        m_ownsShader = other.m_ownsShader;
+        m_mesh = other.m_mesh;
         m_initialized = other.m_initialized;
-        m_windowVisible = other.m_windowVisible;
         
         std::memcpy(m_modelMatrix, other.m_modelMatrix, sizeof(m_modelMatrix));
+        std::memcpy(m_normalMatrix, other.m_normalMatrix, sizeof(m_normalMatrix));
         std::memcpy(m_quat, other.m_quat, sizeof(m_quat));
         
-        other.m_shaderProgram = 0;
-        other.m_VAO = 0;
-        other.m_VBO = 0;
-        other.m_EBO = 0;
-        other.m_ownsShader = false;
+        other.m_shaderHandle = INVALID_SHADER_HANDLE;
+        other.m_mesh = nullptr;
         other.m_initialized = false;
     }
     return *this;
@@ -124,106 +110,16 @@ void Voxel::initialize()
     if (m_initialized)
         return;
     
-    // Create cube vertices (position + color + normal)
-    // Each face has a different color
-    float cubeVertices[] = {
-        // Front face (red)
-        -0.5f, -0.5f,  0.5f,  1.0f, 0.0f, 0.0f,  0.0f,  0.0f,  1.0f,
-         0.5f, -0.5f,  0.5f,  1.0f, 0.0f, 0.0f,  0.0f,  0.0f,  1.0f,
-         0.5f,  0.5f,  0.5f,  1.0f, 0.0f, 0.0f,  0.0f,  0.0f,  1.0f,
-        -0.5f,  0.5f,  0.5f,  1.0f, 0.0f, 0.0f,  0.0f,  0.0f,  1.0f,
-        
-        // Back face (green)
-        -0.5f, -0.5f, -0.5f,  0.0f, 1.0f, 0.0f,  0.0f,  0.0f, -1.0f,
-         0.5f, -0.5f, -0.5f,  0.0f, 1.0f, 0.0f,  0.0f,  0.0f, -1.0f,
-         0.5f,  0.5f, -0.5f,  0.0f, 1.0f, 0.0f,  0.0f,  0.0f, -1.0f,
-        -0.5f,  0.5f, -0.5f,  0.0f, 1.0f, 0.0f,  0.0f,  0.0f, -1.0f,
-        
-        // Left face (blue)
-        -0.5f, -0.5f, -0.5f,  0.0f, 0.0f, 1.0f, -1.0f,  0.0f,  0.0f,
-        -0.5f, -0.5f,  0.5f,  0.0f, 0.0f, 1.0f, -1.0f,  0.0f,  0.0f,
-        -0.5f,  0.5f,  0.5f,  0.0f, 0.0f, 1.0f, -1.0f,  0.0f,  0.0f,
-        -0.5f,  0.5f, -0.5f,  0.0f, 0.0f, 1.0f, -1.0f,  0.0f,  0.0f,
-        
-        // Right face (yellow)
-         0.5f, -0.5f, -0.5f,  1.0f, 1.0f, 0.0f,  1.0f,  0.0f,  0.0f,
-         0.5f, -0.5f,  0.5f,  1.0f, 1.0f, 0.0f,  1.0f,  0.0f,  0.0f,
-         0.5f,  0.5f,  0.5f,  1.0f, 1.0f, 0.0f,  1.0f,  0.0f,  0.0f,
-         0.5f,  0.5f, -0.5f,  1.0f, 1.0f, 0.0f,  1.0f,  0.0f,  0.0f,
-        
-        // Top face (cyan)
-        -0.5f,  0.5f, -0.5f,  0.0f, 1.0f, 1.0f,  0.0f,  1.0f,  0.0f,
-        -0.5f,  0.5f,  0.5f,  0.0f, 1.0f, 1.0f,  0.0f,  1.0f,  0.0f,
-         0.5f,  0.5f,  0.5f,  0.0f, 1.0f, 1.0f,  0.0f,  1.0f,  0.0f,
-         0.5f,  0.5f, -0.5f,  0.0f, 1.0f, 1.0f,  0.0f,  1.0f,  0.0f,
-        
-        // Bottom face (magenta)
-        -0.5f, -0.5f, -0.5f,  1.0f, 0.0f, 1.0f,  0.0f, -1.0f,  0.0f,
-        -0.5f, -0.5f,  0.5f,  1.0f, 0.0f, 1.0f,  0.0f, -1.0f,  0.0f,
-         0.5f, -0.5f,  0.5f,  1.0f, 0.0f, 1.0f,  0.0f, -1.0f,  0.0f,
-         0.5f, -0.5f, -0.5f,  1.0f, 0.0f, 1.0f,  0.0f, -1.0f,  0.0f
-    };
-    
-    // Cube indices for drawing with triangles
-    unsigned int cubeIndices[] = {
-        // Front face
-        0, 1, 2,  2, 3, 0,
-        // Back face
-        4, 6, 5,  6, 4, 7,
-        // Left face
-        8, 9, 10,  10, 11, 8,
-        // Right face
-        12, 14, 13,  14, 12, 15,
-        // Top face
-        16, 17, 18,  18, 19, 16,
-        // Bottom face
-        20, 22, 21,  22, 20, 23
-    };
-    
-    // Create VAO, VBO, and EBO
-    glGenVertexArrays(1, &m_VAO);
-    glGenBuffers(1, &m_VBO);
-    glGenBuffers(1, &m_EBO);
-    
-    glBindVertexArray(m_VAO);
-    
-    glBindBuffer(GL_ARRAY_BUFFER, m_VBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(cubeVertices), cubeVertices, GL_STATIC_DRAW);
-    
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_EBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(cubeIndices), cubeIndices, GL_STATIC_DRAW);
-    
-    // Position attribute (location 0)
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 9 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-    
-    // Color attribute (location 1)
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 9 * sizeof(float), (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
-    
-    // Normal attribute (location 2)
-    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, 9 * sizeof(float), (void*)(6 * sizeof(float)));
-    glEnableVertexAttribArray(2);
-    
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
-    
+    // Every voxel draws the same face-colored cube, built once by the library
+    m_mesh = &MeshLibrary::getInstance().getColoredCube();
     m_initialized = true;
 }
 
 void Voxel::cleanup()
 {
-    if (m_initialized)
-    {
-        glDeleteVertexArrays(1, &m_VAO);
-        glDeleteBuffers(1, &m_VBO);
-        glDeleteBuffers(1, &m_EBO);
-        
-        m_VAO = 0;
-        m_VBO = 0;
-        m_EBO = 0;
-        m_initialized = false;
-    }
+    // The mesh belongs to the MeshLibrary
+    m_mesh = nullptr;
+    m_initialized = false;
 }
 
 void Voxel::updateModelMatrix()
@@ -256,9 +152,12 @@ void Voxel::updateModelMatrix()
     m_modelMatrix[13] = m_posY;
     m_modelMatrix[14] = m_posZ;
     m_modelMatrix[15] = 1.0f;
+    
+    // Rotation only (scale is uniform), so the normal matrix is the rotation itself
+    normalMatrixFromQuaternion(m_normalMatrix, m_quat);
 }
 
-void Voxel::updateEulerFromQuaternion()
+void Voxel::updateEulerFromQuaternion() const
 {
     // Convert quaternion to Euler angles (ZYX order)
     float w = m_quat[0], x = m_quat[1], y = m_quat[2], z = m_quat[3];
@@ -284,40 +183,32 @@ void Voxel::updateEulerFromQuaternion()
     if (m_rotX < 0.0f) m_rotX += 360.0f;
     if (m_rotY < 0.0f) m_rotY += 360.0f;
     if (m_rotZ < 0.0f) m_rotZ += 360.0f;
+    
+    m_eulerDirty = false;
 }
 
-void Voxel::render(GLuint shaderProgram, const float* viewMatrix, const float* projectionMatrix)
+void Voxel::getLocalBounds(float* boundsMin, float* boundsMax) const
 {
-    if (!m_initialized)
-        return;
-    
-    // Use provided shader or voxel's own shader
-    GLuint programToUse = (shaderProgram != 0) ? shaderProgram : m_shaderProgram;
-    
-    if (programToUse == 0)
-        return; // No shader available
-    
-    // Use shader program and set uniforms
-    glUseProgram(programToUse);
-    
-    GLint modelLoc = glGetUniformLocation(programToUse, "model");
-    GLint viewLoc = glGetUniformLocation(programToUse, "view");
-    GLint projLoc = glGetUniformLocation(programToUse, "projection");
-    
-    glUniformMatrix4fv(modelLoc, 1, GL_FALSE, m_modelMatrix);
-    glUniformMatrix4fv(viewLoc, 1, GL_FALSE, viewMatrix);
-    glUniformMatrix4fv(projLoc, 1, GL_FALSE, projectionMatrix);
-    
-    // Draw voxel
-    glBindVertexArray(m_VAO);
-    glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_INT, 0);
-    glBindVertexArray(0);
+    boundsMin[0] = boundsMin[1] = boundsMin[2] = -0.5f;
+    boundsMax[0] = boundsMax[1] = boundsMax[2] = 0.5f;
 }
 
-void Voxel::render(const float* viewMatrix, const float* projectionMatrix)
+void Voxel::submit(RenderQueue& queue, GLuint shaderProgram, uint32_t pickId) const
 {
-    // Use voxel's own shader
-    render(0, viewMatrix, projectionMatrix);
+    if (!m_initialized)
+        return;
+    
+    DrawItem item;
+    item.program = (shaderProgram != 0) ? shaderProgram : getShaderProgram();
+    item.vao = m_mesh->VAO;
+    item.depthVao = m_mesh->depthVAO;
+    item.indexCount = m_mesh->indexCount;
+    item.modelMatrix = m_modelMatrix;
+    item.normalMatrix = m_normalMatrix;
+    item.pickId = pickId;
+    
+    if (item.program != 0)
+        queue.add(item);
 }
 
 void Voxel::setPosition(float x, float y, float z)
@@ -339,6 +230,7 @@ void Voxel::setRotation(float angleX, float angleY, float angleZ)
     m_rotX = angleX;
     m_rotY = angleY;
     m_rotZ = angleZ;
+    m_eulerDirty = false;
     
     // Convert Euler angles to quaternion (Z * Y * X order)
     float radX = angleX * 3.14159265359f / 180.0f;
@@ -366,6 +258,11 @@ void Voxel::setColor(float r, float g, float b)
     // You could extend this to update colors dynamically if needed
 }
 
+GLuint Voxel::getShaderProgram() const
+{
+    return ShaderManager::getInstance().getProgram(m_shaderHandle);
+}
+
 void Voxel::getPosition(float& x, float& y, float& z) const
 {
     x = m_posX;
@@ -373,61 +270,65 @@ void Voxel::getPosition(float& x, float& y, float& z) const
     z = m_posZ;
 }
 
-void Voxel::showControls()
+void Voxel::getRotation(float& x, float& y, float& z) const
 {
-    // Only show window if visible
-    if (!m_windowVisible)
-        return;
+    if (m_eulerDirty)
+        updateEulerFromQuaternion();
+    x = m_rotX;
+    y = m_rotY;
+    z = m_rotZ;
+}
+
+void Voxel::showInspector()
+{
+    // Auto-rotation and dragging only touch the quaternion
+    if (m_eulerDirty)
+        updateEulerFromQuaternion();
     
-    // Create individual window for this voxel with close button
-    if (ImGui::Begin(m_name.c_str(), &m_windowVisible))
+    // Position controls
+    ImGui::Text("Position:");
+    ImGui::PushItemWidth(100);
+    if (ImGui::DragFloat("X##pos", &m_posX, 0.1f, -10.0f, 10.0f))
+        updateModelMatrix();
+    ImGui::SameLine();
+    if (ImGui::DragFloat("Y##pos", &m_posY, 0.1f, -10.0f, 10.0f))
+        updateModelMatrix();
+    ImGui::SameLine();
+    if (ImGui::DragFloat("Z##pos", &m_posZ, 0.1f, -10.0f, 10.0f))
+        updateModelMatrix();
+    ImGui::PopItemWidth();
+    
+    // Rotation controls
+    ImGui::Text("Rotation:");
+    ImGui::PushItemWidth(100);
+    if (ImGui::DragFloat("X##rot", &m_rotX, 1.0f, 0.0f, 360.0f))
+        setRotation(m_rotX, m_rotY, m_rotZ);
+    ImGui::SameLine();
+    if (ImGui::DragFloat("Y##rot", &m_rotY, 1.0f, 0.0f, 360.0f))
+        setRotation(m_rotX, m_rotY, m_rotZ);
+    ImGui::SameLine();
+    if (ImGui::DragFloat("Z##rot", &m_rotZ, 1.0f, 0.0f, 360.0f))
+        setRotation(m_rotX, m_rotY, m_rotZ);
+    ImGui::PopItemWidth();
+    
+    // Size control
+    if (ImGui::SliderFloat("Size", &m_size, 0.1f, 5.0f))
+        updateModelMatrix();
+    
+    // Color control (note: doesn't update vertex buffer yet)
+    ImGui::ColorEdit3("Color", &m_colorR);
+    
+    ImGui::Separator();
+    
+    // Auto-rotation controls
+    ImGui::Checkbox("Auto Rotate", &m_autoRotate);
+    if (m_autoRotate)
     {
-        // Position controls
-        ImGui::Text("Position:");
-        ImGui::PushItemWidth(100);
-        if (ImGui::DragFloat("X##pos", &m_posX, 0.1f, -10.0f, 10.0f))
-            updateModelMatrix();
-        ImGui::SameLine();
-        if (ImGui::DragFloat("Y##pos", &m_posY, 0.1f, -10.0f, 10.0f))
-            updateModelMatrix();
-        ImGui::SameLine();
-        if (ImGui::DragFloat("Z##pos", &m_posZ, 0.1f, -10.0f, 10.0f))
-            updateModelMatrix();
-        ImGui::PopItemWidth();
-        
-        // Rotation controls
-        ImGui::Text("Rotation:");
-        ImGui::PushItemWidth(100);
-        if (ImGui::DragFloat("X##rot", &m_rotX, 1.0f, 0.0f, 360.0f))
-            setRotation(m_rotX, m_rotY, m_rotZ);
-        ImGui::SameLine();
-        if (ImGui::DragFloat("Y##rot", &m_rotY, 1.0f, 0.0f, 360.0f))
-            setRotation(m_rotX, m_rotY, m_rotZ);
-        ImGui::SameLine();
-        if (ImGui::DragFloat("Z##rot", &m_rotZ, 1.0f, 0.0f, 360.0f))
-            setRotation(m_rotX, m_rotY, m_rotZ);
-        ImGui::PopItemWidth();
-        
-        // Size control
-        if (ImGui::SliderFloat("Size", &m_size, 0.1f, 5.0f))
-            updateModelMatrix();
-        
-        // Color control (note: doesn't update vertex buffer yet)
-        ImGui::ColorEdit3("Color", &m_colorR);
-        
-        ImGui::Separator();
-        
-        // Auto-rotation controls
-        ImGui::Checkbox("Auto Rotate", &m_autoRotate);
-        if (m_autoRotate)
-        {
-            ImGui::SliderFloat("Rotation Speed", &m_rotationSpeed, 0.0f, 100.0f);
-        }
+        ImGui::SliderFloat("Rotation Speed", &m_rotationSpeed, 0.0f, 100.0f);
     }
-    ImGui::End();
 }
 
-void Voxel::update(float deltaTime)
+bool Voxel::update(float deltaTime)
 {
     if (m_autoRotate)
     {
@@ -459,11 +360,13 @@ void Voxel::update(float deltaTime)
         m_quat[2] = qNew[2] / len;
         m_quat[3] = qNew[3] / len;
         
-        // Update Euler angles for ImGui display
-        updateEulerFromQuaternion();
+        // Euler angles are only needed by the inspector
+        m_eulerDirty = true;
         
         updateModelMatrix();
+        return true;
     }
+    return false;
 }
 
 void Voxel::rotateScreenSpace(float horizontalDelta, float verticalDelta, const float* cameraRight, const float* cameraUp)
@@ -517,8 +420,8 @@ void Voxel::rotateScreenSpace(float horizontalDelta, float verticalDelta, const
     m_quat[2] = qNew[2] / len;
     m_quat[3] = qNew[3] / len;
     
-    // Update Euler angles for ImGui display
-    updateEulerFromQuaternion();
+    // Euler angles are only needed by the inspector
+    m_eulerDirty = true;
     
     updateModelMatrix();
 }
@@ -5,6 +5,11 @@
 
 #include <vector>
 #include <string>
+#include <cstdint>
+
+#include "shader_manager.h"
+#include "render_queue.h"
+#include "mesh_library.h"
 
 #if defined(__APPLE__)
     #include <OpenGL/gl3.h>
@@ -32,18 +37,12 @@ public:
     Voxel(Voxel&& other) noexcept;
     Voxel& operator=(Voxel&& other) noexcept;
     
-    // Render the voxel (uses internal shader if shaderProgram is 0)
-    void render(GLuint shaderProgram, const float* viewMatrix, const float* projectionMatrix);
-    
-    // Render with voxel's own shader
-    void render(const float* viewMatrix, const float* projectionMatrix);
+    // Queue the voxel for sorted drawing (uses internal shader if shaderProgram is 0),
+    // pickId is written by the GPU picking pass
+    void submit(RenderQueue& queue, GLuint shaderProgram = 0, uint32_t pickId = 0) const;
     
-    // Show ImGui controls for this voxel in its own window
-    void showControls();
-    
-    // Window visibility control
-    void setWindowVisible(bool visible) { m_windowVisible = visible; }
-    bool isWindowVisible() const { return m_windowVisible; }
+    // Show ImGui controls for this voxel inside the current window
+    void showInspector();
     
     // Ray intersection test for picking
     bool intersectsRay(const float* rayOrigin, const float* rayDirection, float& distance) const;
@@ -58,34 +57,42 @@ public:
     // Screen-space rotation (rotates around camera's horizontal and vertical axes)
     void rotateScreenSpace(float horizontalDelta, float verticalDelta, const float* cameraRight, const float* cameraUp);
     
-    // Update for auto-rotation (call each frame with deltaTime)
-    void update(float deltaTime);
+    // Update for auto-rotation (call each frame with deltaTime), true if the object moved
+    bool update(float deltaTime);
     
     // Getters
     void getPosition(float& x, float& y, float& z) const;
     float getSize() const { return m_size; }
-    void getRotation(float& x, float& y, float& z) const { x = m_rotX; y = m_rotY; z = m_rotZ; }
+    void getRotation(float& x, float& y, float& z) const;
     const std::string& getName() const { return m_name; }
-    GLuint getShaderProgram() const { return m_shaderProgram; }
+    const float* getModelMatrix() const { return m_modelMatrix; }
+    const float* getNormalMatrix() const { return m_normalMatrix; }
+    
+    // Axis-aligned bounds of the mesh in model space (before the model matrix)
+    void getLocalBounds(float* boundsMin, float* boundsMax) const;
+    
+    // Program to draw with (fallback program while the real one compiles)
+    GLuint getShaderProgram() const;
     
 private:
     void initialize();
     void cleanup();
     void updateModelMatrix();
-    void updateEulerFromQuaternion();
+    void updateEulerFromQuaternion() const;
     
     // Name for ImGui identification
     std::string m_name;
     
-    // Shader paths and program
-    std::string m_vertexShaderPath;
-    std::string m_fragmentShaderPath;
-    GLuint m_shaderProgram;
+    // Shader program variant
+    ShaderHandle m_shaderHandle;
     
     // Position and transform
     float m_posX, m_posY, m_posZ;
     float m_size;
-    float m_rotX, m_rotY, m_rotZ;
+    
+    // Euler angles for the UI, derived from the quaternion only when read
+    mutable float m_rotX, m_rotY, m_rotZ;
+    mutable bool m_eulerDirty;
     
     // Quaternion for screen-space rotation (w, x, y, z)
     float m_quat[4];
@@ -97,18 +104,15 @@ private:
     // Color (uniform for all faces, or can be extended)
     float m_colorR, m_colorG, m_colorB;
     
-    // OpenGL objects
-    GLuint m_VAO;
-    GLuint m_VBO;
-    GLuint m_EBO;
-    bool m_ownsShader; // Whether this voxel loaded its own shader
+    // Shared cube mesh from the MeshLibrary, so creating a voxel makes no GL calls
+    const LibraryMesh* m_mesh;
     
     // Model matrix
     float m_modelMatrix[16];
     
+    // Normal matrix (mat3), precomputed so the vertex shader skips inverse()
+    float m_normalMatrix[9];
+    
     // Flag to track if OpenGL resources are initialized
     bool m_initialized;
-    
-    // UI state
-    bool m_windowVisible;
 };
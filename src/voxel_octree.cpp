@@ -0,0 +1,319 @@
+#include "voxel_octree.h"
+#include <algorithm>
+
+namespace
+{
+    // Child slot of a cell at the level where children are (1 << shift) wide
+    inline int childSlot(int x, int y, int z, int shift)
+    {
+        return ((x >> shift) & 1) | (((y >> shift) & 1) << 1) | (((z >> shift) & 1) << 2);
+    }
+    
+    inline bool overlaps(int x, int y, int z, int size, const int* regionMin, const int* regionMax)
+    {
+        return x < regionMax[0] && x + size > regionMin[0] &&
+               y < regionMax[1] && y + size > regionMin[1] &&
+               z < regionMax[2] && z + size > regionMin[2];
+    }
+    
+    inline bool contains(int x, int y, int z, int size, const int* regionMin, const int* regionMax)
+    {
+        return x >= regionMin[0] && x + size <= regionMax[0] &&
+               y >= regionMin[1] && y + size <= regionMax[1] &&
+               z >= regionMin[2] && z + size <= regionMax[2];
+    }
+}
+
+VoxelOctree::VoxelOctree(int depth)
+    : m_depth(std::clamp(depth, 1, MAX_DEPTH))
+{
+    clear();
+}
+
+void VoxelOctree::clear()
+{
+    m_nodes.clear();
+    m_freeGroups.clear();
+    m_nodes.push_back({NO_CHILDREN, BLOCK_AIR});
+}
+
+BlockId VoxelOctree::get(int x, int y, int z) const
+{
+    int size = getSize();
+    if (x < 0 || y < 0 || z < 0 || x >= size || y >= size || z >= size)
+        return BLOCK_AIR;
+    
+    uint32_t node = ROOT;
+    for (int shift = m_depth - 1; !isLeaf(node); --shift)
+    {
+        node = m_nodes[node].firstChild + childSlot(x, y, z, shift);
+    }
+    return m_nodes[node].block;
+}
+
+void VoxelOctree::set(int x, int y, int z, BlockId block)
+{
+    int size = getSize();
+    if (x < 0 || y < 0 || z < 0 || x >= size || y >= size || z >= size)
+        return;
+    
+    // Descend, splitting homogeneous nodes that don't already hold block
+    uint32_t path[MAX_DEPTH];
+    int pathLength = 0;
+    uint32_t node = ROOT;
+    for (int shift = m_depth - 1; shift >= 0; --shift)
+    {
+        if (isLeaf(node))
+        {
+            if (m_nodes[node].block == block)
+                return;
+            split(node);
+        }
+        path[pathLength++] = node;
+        node = m_nodes[node].firstChild + childSlot(x, y, z, shift);
+    }
+    
+    if (m_nodes[node].block == block)
+        return;
+    m_nodes[node].block = block;
+    
+    // Merge back up while all eight siblings agree
+    while (pathLength > 0 && tryCollapse(path[--pathLength]))
+    {
+    }
+}
+
+void VoxelOctree::fill(const int* regionMin, const int* regionMax, BlockId block)
+{
+    if (regionMin[0] >= regionMax[0] || regionMin[1] >= regionMax[1] || regionMin[2] >= regionMax[2])
+        return;
+    
+    fillNode(ROOT, 0, 0, 0, getSize(), regionMin, regionMax, block);
+}
+
+void VoxelOctree::fillNode(uint32_t node, int x, int y, int z, int size,
+                           const int* regionMin, const int* regionMax, BlockId block)
+{
+    if (!overlaps(x, y, z, size, regionMin, regionMax))
+        return;
+    
+    // Fully covered: the whole subtree becomes one leaf
+    if (contains(x, y, z, size, regionMin, regionMax))
+    {
+        freeChildren(node);
+        m_nodes[node].block = block;
+        return;
+    }
+    
+    if (isLeaf(node))
+    {
+        if (m_nodes[node].block == block)
+            return;
+        split(node);
+    }
+    
+    int half = size / 2;
+    for (int slot = 0; slot < 8; ++slot)
+    {
+        // Re-read firstChild every time, recursion may grow m_nodes
+        uint32_t child = m_nodes[node].firstChild + slot;
+        fillNode(child,
+                 x + ((slot & 1) ? half : 0),
+                 y + ((slot & 2) ? half : 0),
+                 z + ((slot & 4) ? half : 0),
+                 half, regionMin, regionMax, block);
+    }
+    tryCollapse(node);
+}
+
+bool VoxelOctree::isRegionUniform(const int* regionMin, const int* regionMax, BlockId& block) const
+{
+    bool found = false;
+    block = BLOCK_AIR;
+    
+    // Parts of the region outside the volume are air
+    int size = getSize();
+    bool outside = regionMin[0] < 0 || regionMin[1] < 0 || regionMin[2] < 0 ||
+                   regionMax[0] > size || regionMax[1] > size || regionMax[2] > size;
+    if (outside)
+        found = true;
+    
+    return uniformNode(ROOT, 0, 0, 0, size, regionMin, regionMax, block, found);
+}
+
+bool VoxelOctree::isRegionSolid(const int* regionMin, const int* regionMax) const
+{
+    BlockId block;
+    return isRegionUniform(regionMin, regionMax, block) && block != BLOCK_AIR;
+}
+
+bool VoxelOctree::uniformNode(uint32_t node, int x, int y, int z, int size,
+                              const int* regionMin, const int* regionMax, BlockId& block, bool& found) const
+{
+    if (!overlaps(x, y, z, size, regionMin, regionMax))
+        return true;
+    
+    if (isLeaf(node))
+    {
+        if (!found)
+        {
+            block = m_nodes[node].block;
+            found = true;
+            return true;
+        }
+        return m_nodes[node].block == block;
+    }
+    
+    int half = size / 2;
+    uint32_t firstChild = m_nodes[node].firstChild;
+    for (int slot = 0; slot < 8; ++slot)
+    {
+        if (!uniformNode(firstChild + slot,
+                         x + ((slot & 1) ? half : 0),
+                         y + ((slot & 2) ? half : 0),
+                         z + ((slot & 4) ? half : 0),
+                         half, regionMin, regionMax, block, found))
+            return false;
+    }
+    return true;
+}
+
+uint32_t VoxelOctree::allocateGroup(BlockId block)
+{
+    uint32_t first;
+    if (!m_freeGroups.empty())
+    {
+        first = m_freeGroups.back();
+        m_freeGroups.pop_back();
+    }
+    else
+    {
+        first = (uint32_t)m_nodes.size();
+        m_nodes.resize(m_nodes.size() + 8);
+    }
+    
+    for (int i = 0; i < 8; ++i)
+    {
+        m_nodes[first + i] = {NO_CHILDREN, block};
+    }
+    return first;
+}
+
+void VoxelOctree::freeChildren(uint32_t node)
+{
+    uint32_t first = m_nodes[node].firstChild;
+    if (first == NO_CHILDREN)
+        return;
+    
+    for (int i = 0; i < 8; ++i)
+    {
+        freeChildren(first + i);
+    }
+    m_freeGroups.push_back(first);
+    m_nodes[node].firstChild = NO_CHILDREN;
+}
+
+void VoxelOctree::split(uint32_t node)
+{
+    // allocateGroup may reallocate m_nodes, so index again afterwards
+    uint32_t first = allocateGroup(m_nodes[node].block);
+    m_nodes[node].firstChild = first;
+}
+
+bool VoxelOctree::tryCollapse(uint32_t node)
+{
+    uint32_t first = m_nodes[node].firstChild;
+    if (first == NO_CHILDREN)
+        return true;
+    
+    BlockId block = m_nodes[first].block;
+    for (int i = 0; i < 8; ++i)
+    {
+        if (!isLeaf(first + i) || m_nodes[first + i].block != block)
+            return false;
+    }
+    
+    m_freeGroups.push_back(first);
+    m_nodes[node].firstChild = NO_CHILDREN;
+    m_nodes[node].block = block;
+    return true;
+}
+
+size_t VoxelOctree::getMemoryUsage() const
+{
+    return sizeof(*this) + m_nodes.capacity() * sizeof(Node) + m_freeGroups.capacity() * sizeof(uint32_t);
+}
+
+size_t VoxelOctree::countSolidCells() const
+{
+    size_t count = 0;
+    for (const Leaf& leaf : leaves())
+    {
+        count += (size_t)leaf.sizeX * leaf.sizeY * leaf.sizeZ;
+    }
+    return count;
+}
+
+VoxelOctree::LeafRange VoxelOctree::leaves() const
+{
+    int regionMin[3] = {0, 0, 0};
+    int regionMax[3] = {getSize(), getSize(), getSize()};
+    return {LeafIterator(this, regionMin, regionMax)};
+}
+
+VoxelOctree::LeafRange VoxelOctree::leaves(const int* regionMin, const int* regionMax) const
+{
+    return {LeafIterator(this, regionMin, regionMax)};
+}
+
+VoxelOctree::LeafIterator::LeafIterator(const VoxelOctree* tree, const int* regionMin, const int* regionMax)
+    : m_tree(tree)
+    , m_stackSize(0)
+    , m_valid(false)
+{
+    for (int i = 0; i < 3; ++i)
+    {
+        m_min[i] = regionMin[i];
+        m_max[i] = regionMax[i];
+    }
+    m_stack[m_stackSize++] = {ROOT, 0, 0, 0, tree->getSize()};
+    advance();
+}
+
+void VoxelOctree::LeafIterator::advance()
+{
+    while (m_stackSize > 0)
+    {
+        Frame frame = m_stack[--m_stackSize];
+        if (!overlaps(frame.x, frame.y, frame.z, frame.size, m_min, m_max))
+            continue;
+        
+        const Node& node = m_tree->m_nodes[frame.node];
+        if (node.firstChild == NO_CHILDREN)
+        {
+            if (node.block == BLOCK_AIR)
+                continue;
+            
+            // Clip the leaf box to the region
+            int x0 = std::max(frame.x, m_min[0]), x1 = std::min(frame.x + frame.size, m_max[0]);
+            int y0 = std::max(frame.y, m_min[1]), y1 = std::min(frame.y + frame.size, m_max[1]);
+            int z0 = std::max(frame.z, m_min[2]), z1 = std::min(frame.z + frame.size, m_max[2]);
+            m_leaf = {x0, y0, z0, x1 - x0, y1 - y0, z1 - z0, node.block};
+            m_valid = true;
+            return;
+        }
+        
+        int half = frame.size / 2;
+        for (int slot = 7; slot >= 0; --slot)
+        {
+            m_stack[m_stackSize++] = {
+                node.firstChild + slot,
+                frame.x + ((slot & 1) ? half : 0),
+                frame.y + ((slot & 2) ? half : 0),
+                frame.z + ((slot & 4) ? half : 0),
+                half
+            };
+        }
+    }
+    m_valid = false;
+}
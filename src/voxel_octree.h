@@ -0,0 +1,131 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// Block type stored per voxel cell, 0 is empty space
+using BlockId = uint16_t;
+constexpr BlockId BLOCK_AIR = 0;
+
+// Block types with a color in VoxelVolume's palette
+enum : BlockId
+{
+    BLOCK_STONE = 1,
+    BLOCK_DIRT = 2,
+    BLOCK_GRASS = 3,
+    BLOCK_SAND = 4,
+    BLOCK_TYPE_COUNT
+};
+
+// Sparse voxel octree over a cube of (1 << depth) cells per side.
+// Homogeneous regions collapse into a single leaf, so empty space and
+// solid interiors cost one node. Child nodes are allocated from a pool
+// in groups of eight and recycled through a free list.
+class VoxelOctree
+{
+public:
+    static constexpr int MAX_DEPTH = 16;
+    
+    // Solid leaf produced by iteration, clipped to the iterated region
+    struct Leaf
+    {
+        int x, y, z;            // minimum corner in cells
+        int sizeX, sizeY, sizeZ;
+        BlockId block;
+    };
+    
+    explicit VoxelOctree(int depth = 6);
+    
+    int getDepth() const { return m_depth; }
+    int getSize() const { return 1 << m_depth; }
+    
+    // Point access (cells outside the volume read as air)
+    BlockId get(int x, int y, int z) const;
+    void set(int x, int y, int z, BlockId block);
+    
+    // Set every cell in [min, max) to block, collapsing nodes on the way
+    void fill(const int* regionMin, const int* regionMax, BlockId block);
+    
+    // Reset to a single air leaf
+    void clear();
+    
+    // Whether [min, max) holds a single block type, returned in block
+    bool isRegionUniform(const int* regionMin, const int* regionMax, BlockId& block) const;
+    
+    // Whether every cell of [min, max) is non-air (cells outside count as air)
+    bool isRegionSolid(const int* regionMin, const int* regionMax) const;
+    
+    // Depth-first iteration over the solid leaves intersecting a region, so
+    // meshing can emit one box per homogeneous leaf instead of one per cell
+    class LeafIterator
+    {
+    public:
+        LeafIterator() : m_tree(nullptr), m_stackSize(0), m_valid(false) {}
+        LeafIterator(const VoxelOctree* tree, const int* regionMin, const int* regionMax);
+        
+        const Leaf& operator*() const { return m_leaf; }
+        const Leaf* operator->() const { return &m_leaf; }
+        LeafIterator& operator++() { advance(); return *this; }
+        // Only meaningful against end(): iterators are equal once both are exhausted
+        bool operator==(const LeafIterator& other) const { return m_valid == other.m_valid && !m_valid; }
+        bool operator!=(const LeafIterator& other) const { return !(*this == other); }
+        
+    private:
+        struct Frame
+        {
+            uint32_t node;
+            int x, y, z, size;
+        };
+        
+        void advance();
+        
+        const VoxelOctree* m_tree;
+        int m_min[3], m_max[3];
+        Frame m_stack[7 * MAX_DEPTH + 1];
+        int m_stackSize;
+        Leaf m_leaf;
+        bool m_valid;
+    };
+    
+    // Range over solid leaves, the whole volume or a region
+    struct LeafRange
+    {
+        LeafIterator first;
+        LeafIterator begin() const { return first; }
+        LeafIterator end() const { return LeafIterator(); }
+    };
+    LeafRange leaves() const;
+    LeafRange leaves(const int* regionMin, const int* regionMax) const;
+    
+    // Statistics
+    size_t getNodeCount() const { return m_nodes.size() - m_freeGroups.size() * 8; }
+    size_t getMemoryUsage() const;
+    size_t countSolidCells() const;
+    
+private:
+    // Leaf when firstChild is NO_CHILDREN, otherwise block is unused
+    struct Node
+    {
+        uint32_t firstChild;
+        BlockId block;
+    };
+    static constexpr uint32_t NO_CHILDREN = 0xFFFFFFFFu;
+    static constexpr uint32_t ROOT = 0;
+    
+    bool isLeaf(uint32_t node) const { return m_nodes[node].firstChild == NO_CHILDREN; }
+    
+    uint32_t allocateGroup(BlockId block);
+    void freeChildren(uint32_t node);
+    void split(uint32_t node);
+    bool tryCollapse(uint32_t node);
+    
+    void fillNode(uint32_t node, int x, int y, int z, int size,
+                  const int* regionMin, const int* regionMax, BlockId block);
+    bool uniformNode(uint32_t node, int x, int y, int z, int size,
+                     const int* regionMin, const int* regionMax, BlockId& block, bool& found) const;
+    
+    int m_depth;
+    std::vector<Node> m_nodes;          // root first, then groups of eight siblings
+    std::vector<uint32_t> m_freeGroups; // first index of each recycled group
+};
@@ -0,0 +1,374 @@
+// Silence OpenGL deprecation warnings on macOS
+#define GL_SILENCE_DEPRECATION
+
+#include "voxel_volume.h"
+#include "gl_state.h"
+#include "block_textures.h"
+#include "palette_chunk.h"
+#include "gpu_uploader.h"
+#include "render_stats.h"
+#include "libs/maths/matrix.h"
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+VoxelVolume::VoxelVolume(const std::string& name, int depth,
+                         float x, float y, float z, float cellSize,
+                         const std::string& vertexShaderPath, const std::string& fragmentShaderPath)
+    : m_name(name)
+    , m_shaderHandle(INVALID_SHADER_HANDLE)
+    , m_octree(depth)
+    , m_posX(x), m_posY(y), m_posZ(z)
+    , m_cellSize(cellSize)
+    , m_VAO(0), m_VBO(0), m_EBO(0)
+    , m_depthVAO(0), m_depthVBO(0)
+    , m_vertexCount(0)
+    , m_indexCount(0)
+    , m_solidHeight(0)
+    , m_initialized(false)
+{
+    std::memset(m_modelMatrix, 0, sizeof(m_modelMatrix));
+    std::memset(m_normalMatrix, 0, sizeof(m_normalMatrix));
+    
+    // Load shader if paths are provided
+    if (!vertexShaderPath.empty() && !fragmentShaderPath.empty())
+    {
+        m_shaderHandle = ShaderManager::getInstance().requestShaderProgram(
+            vertexShaderPath, fragmentShaderPath, { SHADER_DEFINE_NORMAL_MATRIX, SHADER_DEFINE_BLOCK_TEXTURES });
+    }
+    
+    initialize();
+    updateModelMatrix();
+}
+
+VoxelVolume::~VoxelVolume()
+{
+    cleanup();
+}
+
+void VoxelVolume::initialize()
+{
+    if (m_initialized)
+        return;
+    
+    // Create VAOs and buffers, filled by rebuildMesh
+    glGenVertexArrays(1, &m_VAO);
+    glGenBuffers(1, &m_VBO);
+    glGenBuffers(1, &m_EBO);
+    glGenVertexArrays(1, &m_depthVAO);
+    glGenBuffers(1, &m_depthVBO);
+    setupVertexArrays();
+    
+    m_initialized = true;
+}
+
+void VoxelVolume::setupVertexArrays()
+{
+    GLState& state = GLState::getInstance();
+    state.bindVertexArray(m_VAO);
+    state.bindBuffer(GL_ARRAY_BUFFER, m_VBO);
+    state.bindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_EBO);
+    
+    const GLsizei stride = VOXEL_VERTEX_FLOATS * sizeof(float);
+    
+    // Position attribute (location 0)
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void*)0);
+    glEnableVertexAttribArray(0);
+    
+    // Color attribute (location 1)
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride, (void*)(3 * sizeof(float)));
+    glEnableVertexAttribArray(1);
+    
+    // Normal attribute (location 2)
+    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, stride, (void*)(6 * sizeof(float)));
+    glEnableVertexAttribArray(2);
+    
+    // Texture coordinate and array layer (location 8, after the instancing attributes)
+    glVertexAttribPointer(8, 3, GL_FLOAT, GL_FALSE, stride, (void*)(9 * sizeof(float)));
+    glEnableVertexAttribArray(8);
+    
+    state.bindVertexArray(m_depthVAO);
+    state.bindBuffer(GL_ARRAY_BUFFER, m_depthVBO);
+    state.bindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_EBO);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+}
+
+void VoxelVolume::cleanup()
+{
+    GLState& state = GLState::getInstance();
+    if (m_initialized)
+    {
+        state.deleteVertexArrays(1, &m_VAO);
+        state.deleteBuffers(1, &m_VBO);
+        state.deleteBuffers(1, &m_EBO);
+        state.deleteVertexArrays(1, &m_depthVAO);
+        state.deleteBuffers(1, &m_depthVBO);
+        
+        m_VAO = 0;
+        m_VBO = 0;
+        m_EBO = 0;
+        m_depthVAO = 0;
+        m_depthVBO = 0;
+        m_initialized = false;
+    }
+}
+
+namespace
+{
+    // Append the visible faces of a box of cells. Faces are ordered
+    // -X, +X, -Y, +Y, -Z, +Z; faceVisible(face) decides which are emitted.
+    template<typename Visible>
+    void appendBox(MeshData& mesh, const int* boxMin, const int* boxMax, BlockId block, Visible&& faceVisible)
+    {
+        // Box corner i takes the max on axis k when bit k is set, faces are
+        // wound CCW seen from outside
+        static const int FACE_CORNERS[6][4] = {
+            {0, 4, 6, 2},   // -X
+            {1, 3, 7, 5},   // +X
+            {0, 1, 5, 4},   // -Y
+            {2, 6, 7, 3},   // +Y
+            {0, 2, 3, 1},   // -Z
+            {4, 5, 7, 6}    // +Z
+        };
+        static const float FACE_NORMALS[6][3] = {
+            {-1.0f, 0.0f, 0.0f}, {1.0f, 0.0f, 0.0f},
+            {0.0f, -1.0f, 0.0f}, {0.0f, 1.0f, 0.0f},
+            {0.0f, 0.0f, -1.0f}, {0.0f, 0.0f, 1.0f}
+        };
+        
+        for (int face = 0; face < 6; ++face)
+        {
+            if (!faceVisible(face))
+                continue;
+            
+            // The texture supplies the color; coordinates are in cells, so a
+            // merged box repeats its layer once per cell
+            float layer = (float)getBlockTextureLayer(block, face);
+            int axis = face / 2;
+            
+            unsigned int base = (unsigned int)(mesh.vertices.size() / VOXEL_VERTEX_FLOATS);
+            for (int i = 0; i < 4; ++i)
+            {
+                int corner = FACE_CORNERS[face][i];
+                float px = (float)((corner & 1) ? boxMax[0] : boxMin[0]);
+                float py = (float)((corner & 2) ? boxMax[1] : boxMin[1]);
+                float pz = (float)((corner & 4) ? boxMax[2] : boxMin[2]);
+                float u = (axis == 0) ? pz : px;
+                float v = (axis == 1) ? pz : py;
+                
+                mesh.vertices.insert(mesh.vertices.end(), {px, py, pz, 1.0f, 1.0f, 1.0f,
+                                                           FACE_NORMALS[face][0], FACE_NORMALS[face][1], FACE_NORMALS[face][2],
+                                                           u, v, layer});
+                mesh.positions.insert(mesh.positions.end(), {px, py, pz});
+            }
+            mesh.indices.insert(mesh.indices.end(), {base, base + 1, base + 2, base + 2, base + 3, base});
+        }
+    }
+    
+    void clearMesh(MeshData& mesh)
+    {
+        mesh.vertices.clear();
+        mesh.positions.clear();
+        mesh.indices.clear();
+        mesh.floatsPerVertex = VOXEL_VERTEX_FLOATS;
+    }
+}
+
+void buildVoxelMesh(const VoxelOctree& octree, MeshData& mesh)
+{
+    clearMesh(mesh);
+    
+    for (const VoxelOctree::Leaf& leaf : octree.leaves())
+    {
+        int boxMin[3] = {leaf.x, leaf.y, leaf.z};
+        int boxMax[3] = {leaf.x + leaf.sizeX, leaf.y + leaf.sizeY, leaf.z + leaf.sizeZ};
+        
+        appendBox(mesh, boxMin, boxMax, leaf.block, [&](int face)
+        {
+            // One cell thick slab just outside this face
+            int axis = face / 2;
+            bool positive = (face & 1) != 0;
+            int slabMin[3] = {boxMin[0], boxMin[1], boxMin[2]};
+            int slabMax[3] = {boxMax[0], boxMax[1], boxMax[2]};
+            slabMin[axis] = positive ? boxMax[axis] : boxMin[axis] - 1;
+            slabMax[axis] = slabMin[axis] + 1;
+            return !octree.isRegionSolid(slabMin, slabMax);
+        });
+    }
+}
+
+void buildVoxelMesh(const PaletteChunk& chunk, MeshData& mesh)
+{
+    clearMesh(mesh);
+    
+    auto isSolid = [&](int x, int y, int z)
+    {
+        if (x < 0 || y < 0 || z < 0 || x >= CHUNK_SIZE || y >= CHUNK_SIZE || z >= CHUNK_SIZE)
+            return false;
+        return chunk.get(x, y, z) != BLOCK_AIR;
+    };
+    
+    // Runs come in cell order and may wrap rows; each row piece is one box
+    chunk.forEachRun([&](int first, int count, BlockId block)
+    {
+        if (block == BLOCK_AIR)
+            return;
+        
+        int cell = first, end = first + count;
+        while (cell < end)
+        {
+            int x = cell % CHUNK_SIZE;
+            int row = cell / CHUNK_SIZE;
+            int z = row % CHUNK_SIZE;
+            int y = row / CHUNK_SIZE;
+            int length = std::min(end - cell, CHUNK_SIZE - x);
+            
+            int boxMin[3] = {x, y, z};
+            int boxMax[3] = {x + length, y + 1, z + 1};
+            appendBox(mesh, boxMin, boxMax, block, [&](int face)
+            {
+                if (face == 0)
+                    return !isSolid(x - 1, y, z);
+                if (face == 1)
+                    return !isSolid(x + length, y, z);
+                
+                // Side faces span the run, emitted whole if any neighbor is open
+                int dy = (face == 2) ? -1 : (face == 3) ? 1 : 0;
+                int dz = (face == 4) ? -1 : (face == 5) ? 1 : 0;
+                for (int i = x; i < x + length; ++i)
+                {
+                    if (!isSolid(i, y + dy, z + dz))
+                        return true;
+                }
+                return false;
+            });
+            cell += length;
+        }
+    });
+}
+
+void VoxelVolume::rebuildMesh()
+{
+    MeshData mesh;
+    buildVoxelMesh(m_octree, mesh);
+    uploadMesh(mesh);
+    
+    // Tallest solid slab from the bottom, solidity shrinks with height
+    int size = m_octree.getSize();
+    int low = 0;
+    int high = size;
+    while (low < high)
+    {
+        int height = (low + high + 1) / 2;
+        int regionMin[3] = {0, 0, 0};
+        int regionMax[3] = {size, height, size};
+        if (m_octree.isRegionSolid(regionMin, regionMax))
+            low = height;
+        else
+            high = height - 1;
+    }
+    m_solidHeight = low;
+}
+
+void VoxelVolume::uploadMesh(const MeshData& mesh)
+{
+    GLState& state = GLState::getInstance();
+    if (!m_initialized)
+        return;
+    
+    m_vertexCount = mesh.getVertexCount();
+    m_indexCount = (int)mesh.indices.size();
+    
+    // Upload to GPU
+    state.bindBuffer(GL_ARRAY_BUFFER, m_VBO);
+    glBufferData(GL_ARRAY_BUFFER, mesh.vertices.size() * sizeof(float), mesh.vertices.data(), GL_STATIC_DRAW);
+    state.bindBuffer(GL_ARRAY_BUFFER, m_depthVBO);
+    glBufferData(GL_ARRAY_BUFFER, mesh.positions.size() * sizeof(float), mesh.positions.data(), GL_STATIC_DRAW);
+    
+    state.bindVertexArray(m_VAO);
+    state.bindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_EBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, mesh.indices.size() * sizeof(unsigned int), mesh.indices.data(), GL_STATIC_DRAW);
+    RenderStats::getInstance().countBufferUpload((mesh.vertices.size() + mesh.positions.size()) * sizeof(float) +
+                                                 mesh.indices.size() * sizeof(unsigned int));
+}
+
+void VoxelVolume::adoptMesh(UploadedMesh& mesh)
+{
+    GLState& state = GLState::getInstance();
+    if (!m_initialized)
+    {
+        mesh.release();
+        return;
+    }
+    
+    // Swap in the uploaded buffers, binding them here also picks up their
+    // contents written on the other context
+    state.deleteBuffers(1, &m_VBO);
+    state.deleteBuffers(1, &m_depthVBO);
+    state.deleteBuffers(1, &m_EBO);
+    m_VBO = mesh.VBO;
+    m_depthVBO = mesh.depthVBO;
+    m_EBO = mesh.EBO;
+    m_vertexCount = mesh.vertexCount;
+    m_indexCount = mesh.indexCount;
+    mesh = UploadedMesh{};
+    setupVertexArrays();
+}
+
+void VoxelVolume::updateModelMatrix()
+{
+    // Uniform scale by the cell size, then translate
+    std::memset(m_modelMatrix, 0, sizeof(m_modelMatrix));
+    m_modelMatrix[0] = m_cellSize;
+    m_modelMatrix[5] = m_cellSize;
+    m_modelMatrix[10] = m_cellSize;
+    m_modelMatrix[12] = m_posX;
+    m_modelMatrix[13] = m_posY;
+    m_modelMatrix[14] = m_posZ;
+    m_modelMatrix[15] = 1.0f;
+    
+    computeNormalMatrix(m_normalMatrix, m_modelMatrix);
+}
+
+void VoxelVolume::getLocalBounds(float* boundsMin, float* boundsMax) const
+{
+    float size = (float)m_octree.getSize();
+    boundsMin[0] = boundsMin[1] = boundsMin[2] = 0.0f;
+    boundsMax[0] = boundsMax[1] = boundsMax[2] = size;
+}
+
+bool VoxelVolume::getOccluderBounds(float* boundsMin, float* boundsMax) const
+{
+    if (m_solidHeight <= 0)
+        return false;
+    
+    float size = (float)m_octree.getSize();
+    boundsMin[0] = boundsMin[1] = boundsMin[2] = 0.0f;
+    boundsMax[0] = size;
+    boundsMax[1] = (float)m_solidHeight;
+    boundsMax[2] = size;
+    return true;
+}
+
+GLuint VoxelVolume::getShaderProgram() const
+{
+    return ShaderManager::getInstance().getProgram(m_shaderHandle);
+}
+
+void VoxelVolume::submit(RenderQueue& queue, GLuint shaderProgram) const
+{
+    if (!m_initialized || m_indexCount == 0)
+        return;
+    
+    DrawItem item;
+    item.program = (shaderProgram != 0) ? shaderProgram : getShaderProgram();
+    item.vao = m_VAO;
+    item.depthVao = m_depthVAO;
+    item.indexCount = m_indexCount;
+    item.modelMatrix = m_modelMatrix;
+    item.normalMatrix = m_normalMatrix;
+    
+    if (item.program != 0)
+        queue.add(item);
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+// Silence OpenGL deprecation warnings on macOS
+#define GL_SILENCE_DEPRECATION
+
+#include <string>
+#include <vector>
+
+#include "shader_manager.h"
+#include "render_queue.h"
+#include "voxel_octree.h"
+#include "mesh_builder.h"
+
+#if defined(__APPLE__)
+    #include <OpenGL/gl3.h>
+#else
+    #include <SDL3/SDL_opengl.h>
+#endif
+
+class PaletteChunk;
+struct UploadedMesh;
+
+// Floats per voxel mesh vertex: position, color, normal, then texture
+// coordinate in cells and block texture array layer
+constexpr int VOXEL_VERTEX_FLOATS = 12;
+
+// Mesh the solid leaves of an octree in cell units, one box per leaf with
+// faces against fully solid neighbors skipped. Thread safe, no GL calls.
+void buildVoxelMesh(const VoxelOctree& octree, MeshData& mesh);
+
+// Mesh a chunk straight from its palette form, one box per run along x.
+// Thread safe, no GL calls.
+void buildVoxelMesh(const PaletteChunk& chunk, MeshData& mesh);
+
+// Renderable block world backed by a sparse voxel octree
+class VoxelVolume
+{
+public:
+    VoxelVolume(const std::string& name = "Volume", int depth = 6,
+                float x = 0.0f, float y = 0.0f, float z = 0.0f, float cellSize = 1.0f,
+                const std::string& vertexShaderPath = "",
+                const std::string& fragmentShaderPath = "");
+    ~VoxelVolume();
+    
+    // Delete copy constructor and assignment operator
+    VoxelVolume(const VoxelVolume&) = delete;
+    VoxelVolume& operator=(const VoxelVolume&) = delete;
+    
+    // Block storage, call rebuildMesh() after editing
+    VoxelOctree& getOctree() { return m_octree; }
+    const VoxelOctree& getOctree() const { return m_octree; }
+    
+    // Regenerate and upload the mesh from the octree
+    void rebuildMesh();
+    
+    // Upload a mesh built elsewhere (e.g. on a worker thread)
+    void uploadMesh(const MeshData& mesh);
+    
+    // Take over buffers filled by GpuUploader (mesh is left empty)
+    void adoptMesh(UploadedMesh& mesh);
+    
+    // Queue the volume for sorted drawing (uses internal shader if shaderProgram is 0)
+    void submit(RenderQueue& queue, GLuint shaderProgram = 0) const;
+    
+    // Occluder hull: the fully solid slab of the lowest solidHeight cell
+    // layers. rebuildMesh() derives it from the octree, volumes meshed
+    // elsewhere set it. false when there is no solid slab.
+    void setSolidHeight(int solidHeight) { m_solidHeight = solidHeight; }
+    bool getOccluderBounds(float* boundsMin, float* boundsMax) const;
+    
+    // Getters
+    const std::string& getName() const { return m_name; }
+    float getCellSize() const { return m_cellSize; }
+    int getIndexCount() const { return m_indexCount; }
+    int getVertexCount() const { return m_vertexCount; }
+    const float* getModelMatrix() const { return m_modelMatrix; }
+    const float* getNormalMatrix() const { return m_normalMatrix; }
+    void getLocalBounds(float* boundsMin, float* boundsMax) const;
+    
+    // Program to draw with (fallback program while the real one compiles)
+    GLuint getShaderProgram() const;
+    
+private:
+    void initialize();
+    void cleanup();
+    void setupVertexArrays();
+    void updateModelMatrix();
+    
+    std::string m_name;
+    ShaderHandle m_shaderHandle;
+    VoxelOctree m_octree;
+    
+    // Placement: cell (0, 0, 0) starts at the position, cells are cellSize wide
+    float m_posX, m_posY, m_posZ;
+    float m_cellSize;
+    
+    // OpenGL objects
+    GLuint m_VAO;
+    GLuint m_VBO;
+    GLuint m_EBO;
+    GLuint m_depthVAO; // Position-only stream for the depth pre-pass
+    GLuint m_depthVBO;
+    int m_vertexCount;
+    int m_indexCount;
+    int m_solidHeight;  // cell layers
+    
+    float m_modelMatrix[16];
+    float m_normalMatrix[9];
+    
+    bool m_initialized;
+};
@@ -0,0 +1,65 @@
+#include "world_generator.h"
+#include "chunk_codec.h"
+#include "region_file.h"
+#include "job_system.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <vector>
+
+void generateChunk(int chunkX, int chunkZ, VoxelOctree& octree)
+{
+    octree.clear();
+    
+    for (int z = 0; z < CHUNK_SIZE; z++)
+    {
+        for (int x = 0; x < CHUNK_SIZE; x++)
+        {
+            // Height field in world cells: stone core, dirt layer, grass or sand on top
+            float worldX = (float)(chunkX * CHUNK_SIZE + x);
+            float worldZ = (float)(chunkZ * CHUNK_SIZE + z);
+            float height = 9.0f + 6.0f * std::sin(worldX * 0.05f) * std::cos(worldZ * 0.04f)
+                         + 3.0f * std::sin((worldX + worldZ) * 0.02f);
+            int top = std::clamp((int)height, 1, CHUNK_SIZE);
+            
+            int stoneMin[3] = {x, 0, z}, stoneMax[3] = {x + 1, std::max(top - 3, 0), z + 1};
+            int dirtMin[3] = {x, stoneMax[1], z}, dirtMax[3] = {x + 1, top - 1, z + 1};
+            octree.fill(stoneMin, stoneMax, BLOCK_STONE);
+            octree.fill(dirtMin, dirtMax, BLOCK_DIRT);
+            octree.set(x, top - 1, z, top <= 5 ? BLOCK_SAND : BLOCK_GRASS);
+        }
+    }
+}
+
+bool generateWorld(const std::string& directory, int regionsX, int regionsZ)
+{
+    for (int regionZ = 0; regionZ < regionsZ; regionZ++)
+    {
+        for (int regionX = 0; regionX < regionsX; regionX++)
+        {
+            int firstChunkX = regionX * RegionFile::REGION_SIZE;
+            int firstChunkZ = regionZ * RegionFile::REGION_SIZE;
+            std::string path = directory + RegionFile::getFileName(firstChunkX, firstChunkZ);
+            if (std::ifstream(path, std::ios::binary).is_open())
+                continue;
+            
+            // Generate and encode the region's chunks in parallel
+            std::vector<std::vector<uint8_t>> chunks(RegionFile::CHUNKS_PER_REGION);
+            JobSystem::getInstance().parallelFor(RegionFile::CHUNKS_PER_REGION, 4, [&](int begin, int end)
+            {
+                VoxelOctree octree(CHUNK_DEPTH);
+                for (int i = begin; i < end; ++i)
+                {
+                    int localX = i % RegionFile::REGION_SIZE;
+                    int localZ = i / RegionFile::REGION_SIZE;
+                    generateChunk(firstChunkX + localX, firstChunkZ + localZ, octree);
+                    encodeChunk(octree, chunks[i]);
+                }
+            });
+            
+            if (!RegionFile::write(path, chunks))
+                return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,12 @@
+#pragma once
+
+#include <string>
+
+#include "voxel_octree.h"
+
+// Procedural rolling hills for one chunk column (chunk octree, CHUNK_DEPTH)
+void generateChunk(int chunkX, int chunkZ, VoxelOctree& octree);
+
+// Write region files for regions [0, regionsX) x [0, regionsZ) into directory
+// (which must exist). Existing region files are kept. Returns false on I/O errors.
+bool generateWorld(const std::string& directory, int regionsX, int regionsZ);